@@ -35,10 +35,13 @@
 #import "HBPartial.h"
 #import "HBPartialRegistry.h"
 #import "HBTemplate.h"
+#import "HBTemplateAnalysis.h"
+#import "HBTemplateProfile.h"
 #import "HBHelperUtils.h"
 #import "HBErrorHandling.h"
 #import "HBHandlebarsKVCValidation.h"
 #import "HBExecutionContextDelegate.h"
+#import "HBRenderFunction.h"
 
 /** 
  
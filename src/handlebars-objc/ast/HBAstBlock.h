@@ -39,8 +39,8 @@
 
 @property (readonly, nonatomic) HBAstExpression* expression; // computed
 
-@property (retain, nonatomic) NSMutableArray* statements;
-@property (retain, nonatomic) NSMutableArray* inverseStatements;
+@property (retain, nonatomic) NSArray* statements;
+@property (retain, nonatomic) NSArray* inverseStatements;
 
 @property BOOL invertedBlock;
 
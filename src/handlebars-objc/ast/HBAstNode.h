@@ -31,6 +31,10 @@
 
 @interface HBAstNode : NSObject
 
+// UTF-8 byte range of the node in the buffer it was parsed from. Set on statements.
+// See -[HBAstProgram sourceOffsetOfStatementAtIndex:] for their position in the template.
+@property (nonatomic) NSRange sourceSpan;
+
 - (NSString*)formalDump;
 
 // help visitors be fast
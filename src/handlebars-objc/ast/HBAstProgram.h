@@ -32,6 +32,20 @@
 @property (strong, nonatomic) NSArray* /* HBAstStatement */ statements;
 @property (retain, nonatomic) NSError* parseError;
 
+// A program updated incrementally after an edit of its template (see +[HBParser astByReplacingBytesInRange:withBytes:inProgram:source:reparsedStatements:error:])
+// keeps the UTF-8 template source, and combines top-level statements from several parses: each of them was parsed
+// from a buffer starting at some offset in the template. Both are nil for programs parsed in one go.
+@property (retain, nonatomic) NSData* sourceData;
+@property (retain, nonatomic) NSArray* /* NSNumber */ statementSourceOffsets;
+
+// Lookup cache keys of the contextual values of the program, by lookup signature, see -[HBAstContextualValue
+// enableLookupCachingWithKeys:]. Filled by the freezing visitor, and released with the program.
+@property (retain, nonatomic) NSMutableDictionary* lookupCacheKeys;
+
+// Offset in the template of the buffer statement at index was parsed from. Add it to the sourceSpan of
+// the statement, or of any node it contains, to get its position in the template.
+- (NSUInteger) sourceOffsetOfStatementAtIndex:(NSUInteger)index;
+
 - (NSString*)formalDump;
 
 @end
@@ -40,10 +40,18 @@
     return [visitor visitProgram:self];
 }
 
+- (NSUInteger) sourceOffsetOfStatementAtIndex:(NSUInteger)index
+{
+    return self.statementSourceOffsets ? [self.statementSourceOffsets[index] unsignedIntegerValue] : 0;
+}
+
 - (void) dealloc
 {
     self.statements = nil;
     self.parseError = nil;
+    self.sourceData = nil;
+    self.statementSourceOffsets = nil;
+    self.lookupCacheKeys = nil;
     [super dealloc];
 }
 
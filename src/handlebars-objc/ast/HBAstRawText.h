@@ -29,6 +29,18 @@
 
 @interface HBAstRawText : HBAstNode
 
+// Raw text produced by the parser is a range of the UTF-8 template source. The NSString
+// value is only materialized when first needed, without copying bytes when possible.
 @property (retain, nonatomic) NSString* litteralValue;
 
+@property (readonly, retain, nonatomic) NSData* sourceBuffer;
+@property (readonly, nonatomic) NSRange sourceRange;
+
+- (void) setSourceBuffer:(NSData*)sourceBuffer range:(NSRange)range;
+
+// Whitespace control: remove white space (tabs and Unicode spaces, as in +[NSCharacterSet whitespaceCharacterSet])
+// at the start or at the end of the text. Only the source range is moved.
+- (void) trimLeadingWhitespace;
+- (void) trimTrailingWhitespace;
+
 @end
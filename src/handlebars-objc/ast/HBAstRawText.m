@@ -28,8 +28,110 @@
 #import "HBAstRawText.h"
 #import "HBAstVisitor.h"
 
+// Length of the UTF-8 white space character at p, 0 if there is none. Tab, and the characters of Unicode category Zs.
+static inline NSUInteger whitespaceLength(const unsigned char* p, const unsigned char* end)
+{
+    if (p >= end) return 0;
+    if (p[0] == ' ' || p[0] == '\t') return 1;
+    if (p[0] < 0xC2 || end - p < 2) return 0;
+    if (p[0] == 0xC2) return (p[1] == 0xA0) ? 2 : 0;                                             // U+00A0
+    if (end - p < 3) return 0;
+    if (p[0] == 0xE1) return (p[1] == 0x9A && p[2] == 0x80) ? 3 : 0;                             // U+1680
+    if (p[0] == 0xE2 && p[1] == 0x80) return ((p[2] >= 0x80 && p[2] <= 0x8A) || p[2] == 0xAF) ? 3 : 0; // U+2000-U+200A, U+202F
+    if (p[0] == 0xE2 && p[1] == 0x81) return (p[2] == 0x9F) ? 3 : 0;                             // U+205F
+    if (p[0] == 0xE3) return (p[1] == 0x80 && p[2] == 0x80) ? 3 : 0;                             // U+3000
+    return 0;
+}
+
+// Length of the white space character ending at end
+static inline NSUInteger whitespaceLengthBefore(const unsigned char* start, const unsigned char* end)
+{
+    for (NSUInteger length = 1; length <= 3 && length <= (NSUInteger)(end - start); length++) {
+        if (whitespaceLength(end - length, end) == length) return length;
+    }
+    return 0;
+}
+
 @implementation HBAstRawText
 
+@synthesize litteralValue = _litteralValue;
+
+- (void) setSourceBuffer:(NSData*)sourceBuffer range:(NSRange)range
+{
+    self.litteralValue = nil;
+    _sourceBuffer = [sourceBuffer retain];
+    _sourceRange = range;
+}
+
+- (NSString*) litteralValue
+{
+    NSString* value = _litteralValue;
+    if (value || !_sourceBuffer) return value;
+    
+    value = [[NSString alloc] initWithBytes:(const char*)[_sourceBuffer bytes] + _sourceRange.location length:_sourceRange.length encoding:NSUTF8StringEncoding];
+    
+    // the same template can be rendered from several threads at once: the first materialized value wins.
+    if (!__sync_bool_compare_and_swap(&_litteralValue, nil, value)) [value release];
+    
+    return _litteralValue;
+}
+
+- (void) setLitteralValue:(NSString*)litteralValue
+{
+    if (litteralValue != _litteralValue) {
+        [_litteralValue release];
+        _litteralValue = [litteralValue retain];
+    }
+    
+    // an explicit value always replaces the source range
+    [_sourceBuffer release];
+    _sourceBuffer = nil;
+}
+
+- (void) trimLeadingWhitespace
+{
+    if (!_sourceBuffer) {
+        NSString* string = self.litteralValue;
+        NSUInteger i = 0;
+        while (i < [string length] && [[NSCharacterSet whitespaceCharacterSet] characterIsMember:[string characterAtIndex:i]]) i++;
+        if (i > 0) self.litteralValue = [string substringFromIndex:i];
+        return;
+    }
+    
+    const unsigned char* start = (const unsigned char*)[_sourceBuffer bytes] + _sourceRange.location;
+    const unsigned char* end = start + _sourceRange.length;
+    const unsigned char* p = start;
+    for (NSUInteger length; (length = whitespaceLength(p, end)); ) p += length;
+    
+    if (p > start) {
+        [_litteralValue release];
+        _litteralValue = nil;
+        _sourceRange = NSMakeRange(_sourceRange.location + (p - start), end - p);
+    }
+}
+
+- (void) trimTrailingWhitespace
+{
+    if (!_sourceBuffer) {
+        NSString* string = self.litteralValue;
+        NSUInteger i = [string length];
+        while (i > 0 && [[NSCharacterSet whitespaceCharacterSet] characterIsMember:[string characterAtIndex:i - 1]]) i--;
+        if (i < [string length]) self.litteralValue = [string substringToIndex:i];
+        return;
+    }
+    
+    const unsigned char* start = (const unsigned char*)[_sourceBuffer bytes] + _sourceRange.location;
+    const unsigned char* end = start + _sourceRange.length;
+    const unsigned char* p = end;
+    for (NSUInteger length; (length = whitespaceLengthBefore(start, p)); ) p -= length;
+    
+    if (p < end) {
+        [_litteralValue release];
+        _litteralValue = nil;
+        _sourceRange.length = p - start;
+    }
+}
+
 - (id) accept:(HBAstVisitor*)visitor
 {
     return [visitor visitRawText:self];
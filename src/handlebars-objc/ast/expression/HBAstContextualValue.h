@@ -26,16 +26,44 @@
 //
 
 #import "HBAstValue.h"
+#import "HBObjectPropertyAccess.h"
+
+@class HBAstKeyPathComponent;
 
 @interface HBAstContextualValue : HBAstValue
 
-@property (retain, nonatomic) NSMutableArray* /* HBAstKeyPathComponent */ keyPath;
+@property (retain, nonatomic) NSArray* /* HBAstKeyPathComponent */ keyPath;
 
 @property (readonly) BOOL hasSimpleIdentifier;
 @property (readonly) BOOL hasPathIdentifier;
 
 @property BOOL isDataValue;
 
+- (void) appendKeyPathComponent:(HBAstKeyPathComponent*)component;
+
+// Lookup descriptor, compiled from keyPath when the AST is frozen: leading "this" and ".." components are
+// resolved to a number of parent levels, and lookupKeys holds the keys left, starting with the data key
+// for data values. Setting keyPath discards it.
+@property (readonly, nonatomic) BOOL hasLookupDescriptor;
+@property (readonly, nonatomic) NSUInteger parentLevels;
+@property (readonly, nonatomic) NSString* const* lookupKeys;
+@property (readonly, nonatomic) NSUInteger lookupKeyCount;
+
+// Inline caches of the lookup, one per key in lookupKeys (see hb_property_cache). They are allocated by the first
+// lookup through them, so that values never looked up, like those of branches never rendered, have none, and live
+// as long as the descriptor. propertyCaches is NULL until then, allocatePropertyCaches allocates them if needed.
+@property (readonly, nonatomic) hb_property_cache* propertyCaches;
+- (hb_property_cache*) allocatePropertyCaches;
+
+- (void) compileLookupDescriptor;
 
+// Repeated lookups. Contextual values with the same lookup descriptor always have the same value in a context state.
+// lookupSignature identifies their descriptor. When the value is looked up several times in the same scope, the
+// freezing visitor enables caching, and lookupCacheKey is the signature interned in lookupCacheKeys, the table of the
+// program being frozen: it is shared by all such values of the program (see -[HBContextState cachesLookups]). Both are
+// nil for values without keys, whose lookup is trivial.
+- (NSArray*) lookupSignature;
+- (void) enableLookupCachingWithKeys:(NSMutableDictionary*)lookupCacheKeys;
+@property (readonly, nonatomic) id lookupCacheKey;
 
 @end
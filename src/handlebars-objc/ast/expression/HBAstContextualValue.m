@@ -30,6 +30,29 @@
 #import "HBAstVisitor.h"
 
 @implementation HBAstContextualValue
+{
+    NSString** _lookupKeys;
+    NSString* _singleLookupKey; // storage of _lookupKeys for the most common key paths, which have a single key
+    hb_property_cache* _propertyCaches;
+}
+
+@synthesize keyPath = _keyPath;
+
+- (void) setKeyPath:(NSArray*)keyPath
+{
+    if (keyPath == _keyPath) return;
+    [self discardLookupDescriptor];
+    [_keyPath release];
+    _keyPath = [keyPath retain];
+}
+
+// key paths stay mutable while they are parsed, and become immutable arrays once the AST is frozen
+- (void) appendKeyPathComponent:(HBAstKeyPathComponent*)component
+{
+    [self discardLookupDescriptor];
+    if (self.keyPath == nil) self.keyPath = [NSMutableArray array];
+    [(NSMutableArray*)self.keyPath addObject:component];
+}
 
 - (BOOL)hasSimpleIdentifier
 {
@@ -41,6 +64,97 @@
     return (self.keyPath) && (self.keyPath.count > 1);
 }
 
+#pragma mark -
+#pragma mark Lookup descriptor
+
+- (void) compileLookupDescriptor
+{
+    if (_hasLookupDescriptor) return;
+    
+    NSArray* keyPath = self.keyPath;
+    NSUInteger count = keyPath.count;
+    NSUInteger index = 0;
+    NSUInteger parentLevels = 0;
+    
+    if (count > 0 && [keyPath[0] isCurrentContextReference]) index++;
+    while (index < count && [keyPath[index] isParentContextReference]) {
+        index++;
+        parentLevels++;
+    }
+    
+    _parentLevels = parentLevels;
+    _lookupKeyCount = count - index;
+    if (_lookupKeyCount > 0) {
+        _lookupKeys = (_lookupKeyCount == 1) ? &_singleLookupKey : malloc(_lookupKeyCount * sizeof(NSString*));
+        for (NSUInteger i = 0; i < _lookupKeyCount; i++) {
+            _lookupKeys[i] = [[keyPath[index + i] key] copy];
+        }
+    }
+    _hasLookupDescriptor = YES;
+}
+
+- (void) discardLookupDescriptor
+{
+    if (!_hasLookupDescriptor) return;
+    for (NSUInteger i = 0; i < _lookupKeyCount; i++) {
+        [_lookupKeys[i] release];
+    }
+    if (_lookupKeys != &_singleLookupKey) free(_lookupKeys);
+    _lookupKeys = NULL;
+    free(_propertyCaches);
+    _propertyCaches = NULL;
+    _lookupKeyCount = 0;
+    _parentLevels = 0;
+    _hasLookupDescriptor = NO;
+    [_lookupCacheKey release];
+    _lookupCacheKey = nil;
+}
+
+- (NSString* const*) lookupKeys
+{
+    return _lookupKeys;
+}
+
+- (hb_property_cache*) propertyCaches
+{
+    return __atomic_load_n(&_propertyCaches, __ATOMIC_ACQUIRE);
+}
+
+- (hb_property_cache*) allocatePropertyCaches
+{
+    if (_lookupKeyCount == 0) return NULL;
+    return [HBObjectPropertyAccess cachesInSlot:&_propertyCaches count:_lookupKeyCount];
+}
+
+- (NSArray*) lookupSignature
+{
+    [self compileLookupDescriptor];
+    if (_lookupKeyCount == 0) return nil;
+    
+    NSMutableArray* signature = [NSMutableArray arrayWithCapacity:_lookupKeyCount + 2];
+    [signature addObject:@(_parentLevels)];
+    [signature addObject:@(self.isDataValue)];
+    [signature addObjectsFromArray:[NSArray arrayWithObjects:_lookupKeys count:_lookupKeyCount]];
+    return signature;
+}
+
+// interned in the table of the program, so that caches compare keys by address
+- (void) enableLookupCachingWithKeys:(NSMutableDictionary*)lookupCacheKeys
+{
+    if (_lookupCacheKey) return;
+    NSArray* signature = [self lookupSignature];
+    if (!signature) return;
+    
+    id key = lookupCacheKeys[signature];
+    if (!key) {
+        key = [[signature copy] autorelease];
+        lookupCacheKeys[key] = key;
+    }
+    _lookupCacheKey = [key retain];
+}
+
+#pragma mark -
+
 - (NSString*) sourceRepresentation
 {
     NSMutableString* result = [NSMutableString string];
@@ -57,6 +171,7 @@
 
 - (void) dealloc
 {
+    [self discardLookupDescriptor];
     self.keyPath = nil;
     [super dealloc];
 }
@@ -32,9 +32,13 @@
 @interface HBAstExpression : HBAstValue
 
 @property (retain, nonatomic) HBAstContextualValue* mainValue;
-@property (retain, nonatomic) NSMutableArray* /* HBAstValue */ positionalParameters;
+@property (retain, nonatomic) NSArray* /* HBAstValue */ positionalParameters;
 @property (retain, nonatomic) HBAstParametersHash* namedParameters;
 
+// helper the expression resolved to the last time it was evaluated, or the fact that it is not a helper
+// call. Owned by the evaluation visitor, which replaces it when helper registries change.
+@property (retain, atomic) id helperBinding;
+
 - (void) addPositionalParameter:(HBAstValue*)parameter;
 
 @end
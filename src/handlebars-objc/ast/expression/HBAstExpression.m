@@ -30,10 +30,11 @@
 
 @implementation HBAstExpression
 
+// parameters stay mutable while they are parsed, and become an immutable array once the AST is frozen
 - (void) addPositionalParameter:(HBAstValue*)parameter
 {
     if (self.positionalParameters == nil) self.positionalParameters = [NSMutableArray array];
-    [self.positionalParameters addObject:parameter];
+    [(NSMutableArray*)self.positionalParameters addObject:parameter];
 }
 
 - (id) accept:(HBAstVisitor*)visitor
@@ -46,6 +47,7 @@
     self.mainValue = nil;
     self.positionalParameters = nil;
     self.namedParameters = nil;
+    self.helperBinding = nil;
     
     [super dealloc];
 }
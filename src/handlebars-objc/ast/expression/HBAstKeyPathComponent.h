@@ -30,9 +30,13 @@
 @interface HBAstKeyPathComponent : HBAstNode
 
 @property (retain, nonatomic) NSString* key;
-@property (retain, nonatomic) NSString* leadingSeparator;
+@property (copy, nonatomic) NSString* leadingSeparator; // "/" or ".", stored as a single character
 @property (readonly, nonatomic) NSString* sourceRepresentation;
 
+// Special segments, flagged once when key is set so that evaluation doesn't compare strings
+@property (readonly, nonatomic) BOOL isCurrentContextReference; // "this" or "."
+@property (readonly, nonatomic) BOOL isParentContextReference; // ".."
+
 - (NSString*)formalDump;
 
 @end
@@ -29,12 +29,37 @@
 #import "HBAstVisitor.h"
 
 @implementation HBAstKeyPathComponent
+{
+    unichar _leadingSeparator;
+}
 
 - (NSString*)formalDump
 {
     return @"";
 }
 
+- (void) setKey:(NSString*)key
+{
+    if (key != _key) {
+        [_key release];
+        _key = [key retain];
+    }
+    _isCurrentContextReference = [key isEqualToString:@"this"] || [key isEqualToString:@"."];
+    _isParentContextReference = [key isEqualToString:@".."];
+}
+
+- (void) setLeadingSeparator:(NSString*)leadingSeparator
+{
+    _leadingSeparator = (leadingSeparator.length > 0) ? [leadingSeparator characterAtIndex:0] : 0;
+}
+
+- (NSString*) leadingSeparator
+{
+    if (_leadingSeparator == '/') return @"/";
+    if (_leadingSeparator == '.') return @".";
+    return nil;
+}
+
 - (NSString*) sourceRepresentation
 {
     return [NSString stringWithFormat:@"%@%@", self.leadingSeparator ? self.leadingSeparator : @"", self.key];
@@ -47,7 +72,6 @@
 
 - (void) dealloc
 {
-    self.leadingSeparator = nil;
     self.key = nil;
     [super dealloc];
 }
@@ -11,13 +11,19 @@
 
 @interface HBAstParametersHash : HBAstNode
 
+// Names and values are kept in order in a single small C array: hashes have a handful of
+// parameters at most, and are looked up by linear search.
 @property (readonly, nonatomic) NSUInteger count;
-@property (retain, nonatomic) NSMutableDictionary* /* (NSString -> HBAstValue) */namedParameters;
-@property (retain, nonatomic) NSMutableArray* /* (NSString) */ orderedNamedParameterNames;
+
+// names of the parameters, in the order they were appended: count names, never NULL
+@property (readonly, nonatomic) NSString* const* names;
 
 - (void) appendParameter:(HBAstValue*)parameter forKey:(NSString*)key;
 - (void) appendNamedParameters:(NSDictionary*)namedParameters;
 
+// releases unused capacity, once the hash is complete
+- (void) compact;
+
 // objc subscripting
 - (id)objectForKeyedSubscript:(id)key;
 // fast enumeration
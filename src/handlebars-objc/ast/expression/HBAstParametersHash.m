@@ -10,18 +10,42 @@
 #import "HBAstVisitor.h"
 
 @implementation HBAstParametersHash
+{
+    // names in [0, _capacity), values in [_capacity, 2 * _capacity)
+    id* _entries;
+    NSUInteger _count;
+    NSUInteger _capacity;
+}
 
 - (NSUInteger) count
 {
-    return self.orderedNamedParameterNames.count;
+    return _count;
+}
+
+- (NSString* const*) names
+{
+    static NSString* const noNames[1] = { nil };
+    return _entries ? (NSString* const*)_entries : noNames;
+}
+
+- (void) setCapacity:(NSUInteger)capacity
+{
+    id* entries = malloc(2 * capacity * sizeof(id));
+    if (_count > 0) {
+        memcpy(entries, _entries, _count * sizeof(id));
+        memcpy(entries + capacity, _entries + _capacity, _count * sizeof(id));
+    }
+    free(_entries);
+    _entries = entries;
+    _capacity = capacity;
 }
 
 - (void) appendParameter:(HBAstValue*)parameter forKey:(NSString*)key
 {
-    if (self.namedParameters == nil) self.namedParameters = [NSMutableDictionary dictionary];
-    if (self.orderedNamedParameterNames == nil) self.orderedNamedParameterNames = [NSMutableArray array];
-    self.namedParameters[key] = parameter;
-    [self.orderedNamedParameterNames addObject:key];
+    if (_count == _capacity) [self setCapacity:(_capacity == 0) ? 2 : 2 * _capacity];
+    _entries[_count] = [key copy];
+    _entries[_capacity + _count] = [parameter retain];
+    _count++;
 }
 
 - (void) appendNamedParameters:(NSDictionary*)namedParameters
@@ -31,21 +55,33 @@
     }
 }
 
-// objc litteral compatibility
+- (void) compact
+{
+    if (_capacity > _count) [self setCapacity:_count];
+}
 
 - (id) objectForKeyedSubscript:(id)key
 {
-    return [self.namedParameters objectForKey:key];
+    // last parameter wins when a name is repeated
+    for (NSUInteger i = _count; i > 0; i--) {
+        if (_entries[i - 1] == key) return _entries[_capacity + i - 1];
+    }
+    for (NSUInteger i = _count; i > 0; i--) {
+        if ([_entries[i - 1] isEqualToString:key]) return _entries[_capacity + i - 1];
+    }
+    return nil;
 }
 
-// fast enumeration
 
 - (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id *)stackbuf count:(NSUInteger)len
 {
-    return [self.orderedNamedParameterNames countByEnumeratingWithState:state objects:stackbuf count:len];
+    if (state->state != 0) return 0;
+    state->state = 1;
+    state->itemsPtr = _entries;
+    state->mutationsPtr = &state->extra[0];
+    return _count;
 }
 
-// visitor protocol
 
 - (id) accept:(HBAstVisitor*)visitor
 {
@@ -54,8 +90,11 @@
 
 - (void) dealloc
 {
-    self.namedParameters = nil;
-    self.orderedNamedParameterNames = nil;
+    for (NSUInteger i = 0; i < _count; i++) {
+        [_entries[i] release];
+        [_entries[_capacity + i] release];
+    }
+    free(_entries);
     
     [super dealloc];
 }
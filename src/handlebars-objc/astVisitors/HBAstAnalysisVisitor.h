@@ -0,0 +1,41 @@
+//
+//  HBAstAnalysisVisitor.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstVisitor.h"
+
+@class HBTemplate;
+@class HBTemplateAnalysis;
+
+// Finds what a program refers to, for -[HBTemplate analyze:]. Blocks and partials are followed the way the
+// evaluation visitor renders them: expressions are helper calls when they have parameters or name a helper of the
+// template, statements of blocks and partials with a context render in a scope of their own, and partials are
+// resolved by the template, then analyzed in turn, except those that include themselves.
+@interface HBAstAnalysisVisitor : HBAstVisitor
+
++ (HBTemplateAnalysis*) analysisOfProgram:(HBAstProgram*)program forTemplate:(HBTemplate*)template;
+
+@end
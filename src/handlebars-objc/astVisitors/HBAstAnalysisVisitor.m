@@ -0,0 +1,223 @@
+//
+//  HBAstAnalysisVisitor.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstAnalysisVisitor.h"
+#import "HBTemplate.h"
+#import "HBTemplate_Private.h"
+#import "HBTemplateAnalysis_Private.h"
+#import "HBPartial.h"
+#import "HBPartial_Private.h"
+#import "HBRenderFunction.h"
+
+@interface HBAstAnalysisVisitor()
+
+@property (assign, nonatomic) HBTemplate* template;
+@property (retain, nonatomic) HBTemplateAnalysis* analysis;
+@property (retain, nonatomic) NSMutableArray* scopes; // label of each context state pushed, NSNull for those keeping the context
+@property (retain, nonatomic) NSMutableArray* partialNames; // partials being analyzed, outermost first
+
+@end
+
+@implementation HBAstAnalysisVisitor
+
++ (HBTemplateAnalysis*) analysisOfProgram:(HBAstProgram*)program forTemplate:(HBTemplate*)template
+{
+    HBAstAnalysisVisitor* visitor = [[HBAstAnalysisVisitor alloc] initWithRootAstNode:program];
+    visitor.template = template;
+    visitor.analysis = [[HBTemplateAnalysis new] autorelease];
+    visitor.scopes = [NSMutableArray array];
+    visitor.partialNames = [NSMutableArray array];
+    [visitor visitNodes:program.statements];
+    HBTemplateAnalysis* result = [[visitor.analysis retain] autorelease];
+    [visitor release];
+    return result;
+}
+
+static NSString* expressionSource(HBAstExpression* expression);
+
+static NSString* valueSource(HBAstValue* value)
+{
+    if ([value isKindOfClass:[HBAstExpression class]]) {
+        HBAstExpression* expression = (HBAstExpression*)value;
+        return [NSString stringWithFormat:@"(%@)", expressionSource(expression)];
+    }
+    if ([value isKindOfClass:[HBAstString class]]) return [NSString stringWithFormat:@"\"%@\"", value.sourceRepresentation];
+    if ([value isKindOfClass:[HBAstContextualValue class]] && [(HBAstContextualValue*)value isDataValue]) return [@"@" stringByAppendingString:value.sourceRepresentation];
+    return value.sourceRepresentation;
+}
+
+// expression as written in the template, such as "each orders" or "with customer"
+static NSString* expressionSource(HBAstExpression* expression)
+{
+    NSMutableArray* components = [NSMutableArray array];
+    if (expression.mainValue) [components addObject:valueSource(expression.mainValue)];
+    for (HBAstValue* parameter in expression.positionalParameters) {
+        [components addObject:valueSource(parameter)];
+    }
+    for (NSString* name in expression.namedParameters) {
+        [components addObject:[NSString stringWithFormat:@"%@=%@", name, valueSource(expression.namedParameters[name])]];
+    }
+    return [components componentsJoinedByString:@" "];
+}
+
+// Same as -[HBAstEvaluationVisitor expressionIsHelperCall:]. Returns the name of the helper called, nil if expression is a value.
+- (NSString*) helperNameOfExpression:(HBAstExpression*)expression
+{
+    HBAstContextualValue* mainValue = expression.mainValue;
+    BOOL canBeHelperCall = !mainValue.isDataValue && mainValue.keyPath.count == 1 && ![mainValue.keyPath[0] isCurrentContextReference];
+    NSString* name = canBeHelperCall ? [mainValue.keyPath[0] key] : nil;
+    
+    if (expression.positionalParameters.count > 0 || expression.namedParameters.count > 0) return name;
+    if (name && [self.template helperForName:name]) return name;
+    return nil;
+}
+
+- (void) visitNodes:(NSArray*)nodes
+{
+    for (HBAstNode* node in nodes) {
+        [self visitNode:node];
+    }
+}
+
+- (void) visitParametersOfExpression:(HBAstExpression*)expression
+{
+    [self visitNodes:expression.positionalParameters];
+    for (NSString* name in expression.namedParameters) {
+        [self visitNode:expression.namedParameters[name]];
+    }
+}
+
+#pragma mark -
+#pragma mark High-level nodes
+
+- (id) visitBlock:(HBAstBlock*)node
+{
+    HBAstExpression* expression = node.expression;
+    NSString* helperName = [self helperNameOfExpression:expression];
+    BOOL keepsContext = NO;
+    if (helperName) {
+        [self.analysis addHelperName:helperName];
+        [self visitParametersOfExpression:expression];
+        
+        // the builtin if and unless render their statements in the current context, pushed again
+        if ([helperName isEqualToString:@"if"] || [helperName isEqualToString:@"unless"]) {
+            keepsContext = hb_render_is_builtin_helper([self.template helperForName:helperName], helperName);
+        }
+    } else {
+        [self visitExpression:expression];
+    }
+    
+    [self.scopes addObject:keepsContext ? (id)[NSNull null] : [@"#" stringByAppendingString:expressionSource(expression)]];
+    [self visitNodes:node.statements];
+    [self.scopes removeLastObject];
+    
+    [self visitNodes:node.inverseStatements];
+    return nil;
+}
+
+- (id) visitPartialTag:(HBAstPartialTag*)node
+{
+    NSString* partialName = [node.partialName sourceRepresentation];
+    [self.analysis addPartialName:partialName];
+    
+    // context is evaluated in the current scope, named parameters in the context of the partial
+    if (node.context) {
+        [self visitNode:node.context];
+        [self.scopes addObject:[NSString stringWithFormat:@">%@ %@", partialName, valueSource(node.context)]];
+    }
+    for (NSString* name in node.namedParameters) {
+        [self visitNode:node.namedParameters[name]];
+    }
+    
+    if (![self.partialNames containsObject:partialName]) {
+        HBPartial* partial = [self.template partialForName:partialName];
+        NSError* error = nil;
+        if (!partial || ![partial compile:&error]) {
+            [self.analysis addUnresolvedPartialName:partialName];
+        } else {
+            [self.partialNames addObject:partialName];
+            [self visitNodes:partial.astStatements];
+            [self.partialNames removeLastObject];
+        }
+    }
+    
+    if (node.context) [self.scopes removeLastObject];
+    return nil;
+}
+
+- (id) visitSimpleTag:(HBAstSimpleTag*)node
+{
+    return node.expression ? [self visitExpression:node.expression] : nil;
+}
+
+#pragma mark -
+#pragma mark Expressions
+
+- (id) visitExpression:(HBAstExpression*)node
+{
+    NSString* helperName = [self helperNameOfExpression:node];
+    if (helperName) {
+        [self.analysis addHelperName:helperName];
+        [self visitParametersOfExpression:node];
+    } else if (node.mainValue) {
+        [self visitNode:node.mainValue];
+    }
+    return nil;
+}
+
+- (id) visitContextualValue:(HBAstContextualValue*)node
+{
+    [node compileLookupDescriptor];
+    
+    // values above the context the template is rendered with are always nil
+    NSUInteger parentLevels = node.parentLevels;
+    if (parentLevels > self.scopes.count) return nil;
+    
+    NSMutableArray* scope = [NSMutableArray array];
+    for (id label in [self.scopes subarrayWithRange:NSMakeRange(0, self.scopes.count - parentLevels)]) {
+        if (label != [NSNull null]) [scope addObject:label];
+    }
+    
+    NSArray* keys = [NSArray arrayWithObjects:node.lookupKeys count:node.lookupKeyCount];
+    NSString* keyPath = (keys.count > 0) ? [keys componentsJoinedByString:@"."] : @"this";
+    HBTemplateKeyPathReference* reference = [[HBTemplateKeyPathReference alloc] initWithKeyPath:keyPath isDataValue:node.isDataValue scope:scope];
+    [self.analysis addKeyPathReference:reference];
+    [reference release];
+    return nil;
+}
+
+#pragma mark -
+
+- (void) dealloc
+{
+    self.analysis = nil;
+    self.scopes = nil;
+    self.partialNames = nil;
+    [super dealloc];
+}
+
+@end
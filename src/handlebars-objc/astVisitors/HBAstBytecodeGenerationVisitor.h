@@ -0,0 +1,39 @@
+//
+//  HBAstBytecodeGenerationVisitor.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstVisitor.h"
+
+@class HBBytecode;
+
+// Lowers statements of compiled programs to code for the bytecode engine. See HBBytecode.h for the format.
+@interface HBAstBytecodeGenerationVisitor : HBAstVisitor
+
+// nil when statements do not fit the instruction format: more than UINT16_MAX registers or parameters,
+// or more than UINT32_MAX instructions or constants. Templates then render them with the interpreter.
++ (HBBytecode*) bytecodeForStatements:(NSArray*)statements;
+
+@end
@@ -0,0 +1,278 @@
+//
+//  HBAstBytecodeGenerationVisitor.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstBytecodeGenerationVisitor.h"
+#import "HBBytecode.h"
+
+@interface HBAstBytecodeGenerationVisitor()
+@property (retain, nonatomic) NSMutableData* code;
+@property (retain, nonatomic) NSMutableArray* constants;
+@property (assign, nonatomic) NSUInteger targetRegister; // register values are computed to
+@property (assign, nonatomic) NSUInteger registerCount;
+@property (assign, nonatomic) BOOL overflowed; // some operand did not fit its instruction field
+@end
+
+@implementation HBAstBytecodeGenerationVisitor
+
++ (HBBytecode*) bytecodeForStatements:(NSArray*)statements
+{
+    HBAstBytecodeGenerationVisitor* visitor = [[HBAstBytecodeGenerationVisitor alloc] initWithRootAstNode:nil];
+    visitor.code = [NSMutableData data];
+    visitor.constants = [NSMutableArray array];
+    [visitor emitStatements:statements];
+    
+    HBBytecode* bytecode = nil;
+    if (!visitor.overflowed) {
+        bytecode = [[HBBytecode alloc] initWithInstructions:[visitor.code bytes] count:[visitor currentIndex] constants:visitor.constants registerCount:visitor.registerCount];
+    }
+    [visitor release];
+    
+    return [bytecode autorelease];
+}
+
+#pragma mark -
+#pragma mark Emitting code
+
+- (NSUInteger) currentIndex
+{
+    return self.code.length / sizeof(hb_bytecode_instruction);
+}
+
+// instructions move as code grows: do not keep pointers across calls to emit
+- (hb_bytecode_instruction*) instructionAtIndex:(NSUInteger)index
+{
+    return (hb_bytecode_instruction*)[self.code mutableBytes] + index;
+}
+
+- (NSUInteger) emit:(HBBytecodeOpcode)opcode constant:(id)constant
+{
+    NSUInteger index = [self currentIndex];
+    if (self.targetRegister > UINT16_MAX || index >= UINT32_MAX || self.constants.count >= UINT32_MAX - 1) self.overflowed = YES;
+    hb_bytecode_instruction instruction = { 0 };
+    instruction.opcode = opcode;
+    instruction.r = (uint16_t)self.targetRegister;
+    instruction.operandsEnd = instruction.statementsEnd = instruction.end = (uint32_t)(index + 1);
+    if (constant) {
+        instruction.constant = (uint32_t)self.constants.count;
+        [self.constants addObject:constant];
+    }
+    [self.code appendBytes:&instruction length:sizeof(instruction)];
+    
+    self.registerCount = MAX(self.registerCount, self.targetRegister + 1);
+    return index;
+}
+
+// operands of the instruction at index are the code emitted since
+- (void) endOperandsOfInstructionAtIndex:(NSUInteger)index
+{
+    hb_bytecode_instruction* instruction = [self instructionAtIndex:index];
+    instruction->operandsEnd = instruction->statementsEnd = instruction->end = (uint32_t)[self currentIndex];
+}
+
+// statements get registers of their own, see hb_vm_render
+- (void) emitStatements:(NSArray*)statements
+{
+    for (HBAstNode* statement in statements) {
+        self.targetRegister = 0;
+        [self visitNode:statement];
+    }
+}
+
+// parameters are computed to the registers following the one of the expression
+- (void) emitParametersOfExpression:(HBAstExpression*)expression atIndex:(NSUInteger)index
+{
+    hb_bytecode_instruction* instruction = [self instructionAtIndex:index];
+    NSUInteger expressionRegister = instruction->r;
+    NSUInteger r = expressionRegister + 1;
+    if (expression.positionalParameters.count > UINT16_MAX) self.overflowed = YES;
+    instruction->positionalCount = (uint16_t)expression.positionalParameters.count;
+    if (expression.positionalParameters) instruction->flags |= HBBytecodeHasPositionalParameters;
+    if (expression.namedParameters) instruction->flags |= HBBytecodeHasNamedParameters;
+    if (expression.positionalParameters.count > 0 || expression.namedParameters.count > 0) instruction->flags |= HBBytecodeHasParameters;
+    
+    for (HBAstValue* parameter in expression.positionalParameters) {
+        self.targetRegister = r++;
+        [self visitNode:parameter];
+    }
+    for (NSString* name in expression.namedParameters) {
+        self.targetRegister = r++;
+        [self visitNode:expression.namedParameters[name]];
+    }
+    self.targetRegister = expressionRegister;
+}
+
+static HBBytecodeBuiltin builtinOfExpression(HBAstExpression* expression)
+{
+    HBAstContextualValue* mainValue = expression.mainValue;
+    if (mainValue.isDataValue || mainValue.keyPath.count != 1) return HBBytecodeBuiltinNone;
+    
+    NSString* name = [mainValue.keyPath[0] key];
+    if ([name isEqualToString:@"if"]) return HBBytecodeBuiltinIf;
+    if ([name isEqualToString:@"unless"]) return HBBytecodeBuiltinUnless;
+    if ([name isEqualToString:@"with"]) return HBBytecodeBuiltinWith;
+    if ([name isEqualToString:@"each"]) return HBBytecodeBuiltinEach;
+    return HBBytecodeBuiltinNone;
+}
+
+#pragma mark -
+#pragma mark High-level nodes
+
+- (id) visitBlock:(HBAstBlock*)node
+{
+    NSUInteger index = [self emit:HBBytecodeBlock constant:node.expression];
+    [self instructionAtIndex:index]->builtin = builtinOfExpression(node.expression);
+    [self emitParametersOfExpression:node.expression atIndex:index];
+    [self endOperandsOfInstructionAtIndex:index];
+    
+    [self emitStatements:node.statements];
+    [self instructionAtIndex:index]->statementsEnd = (uint32_t)[self currentIndex];
+    [self emitStatements:node.inverseStatements];
+    [self instructionAtIndex:index]->end = (uint32_t)[self currentIndex];
+    return nil;
+}
+
+- (id) visitComment:(HBAstComment*)node
+{
+    [self emit:HBBytecodeNop constant:nil];
+    return nil;
+}
+
+- (id) visitPartialTag:(HBAstPartialTag*)node
+{
+    NSUInteger index = [self emit:HBBytecodePartial constant:node];
+    [self.constants addObject:[node.partialName sourceRepresentation]];
+    NSUInteger r = self.targetRegister;
+    
+    if (node.context) {
+        [self instructionAtIndex:index]->flags |= HBBytecodeHasContext;
+        [self visitNode:node.context];
+    }
+    if (node.namedParameters) {
+        [self instructionAtIndex:index]->flags |= HBBytecodeHasNamedParameters;
+        NSUInteger parameterRegister = r + 1;
+        for (NSString* name in node.namedParameters) {
+            self.targetRegister = parameterRegister++;
+            [self visitNode:node.namedParameters[name]];
+        }
+        self.targetRegister = r;
+    }
+    [self endOperandsOfInstructionAtIndex:index];
+    return nil;
+}
+
+- (id) visitProgram:(HBAstProgram*)node
+{
+    [self emitStatements:node.statements];
+    return nil;
+}
+
+- (id) visitRawText:(HBAstRawText*)node
+{
+    [self emit:HBBytecodeText constant:node];
+    return nil;
+}
+
+- (id) visitSimpleTag:(HBAstSimpleTag*)node
+{
+    if (!node.expression) {
+        [self emit:HBBytecodeNop constant:nil];
+        return nil;
+    }
+    
+    [self visitNode:node.expression];
+    NSUInteger index = [self emit:HBBytecodeEmit constant:nil];
+    if (node.escape) [self instructionAtIndex:index]->flags |= HBBytecodeEscape;
+    return nil;
+}
+
+- (id) visitTag:(HBAstTag*)node
+{
+    [self emit:HBBytecodeNop constant:nil];
+    return nil;
+}
+
+#pragma mark -
+#pragma mark Expressions
+
+- (void) emitLiteral:(id)value
+{
+    NSUInteger index = [self emit:HBBytecodeLiteral constant:value];
+    if (!value) [self instructionAtIndex:index]->flags |= HBBytecodeNilLiteral;
+}
+
+- (id) visitContextualValue:(HBAstContextualValue*)node
+{
+    [self emit:HBBytecodeLookup constant:node];
+    return nil;
+}
+
+- (id) visitExpression:(HBAstExpression*)node
+{
+    NSUInteger index = [self emit:HBBytecodeExpression constant:node];
+    [self emitParametersOfExpression:node atIndex:index];
+    [self endOperandsOfInstructionAtIndex:index];
+    return nil;
+}
+
+- (id) visitKeyPathComponent:(HBAstKeyPathComponent*)node
+{
+    return nil;
+}
+
+- (id) visitNumber:(HBAstNumber*)node
+{
+    [self emitLiteral:node.litteralValue];
+    return nil;
+}
+
+- (id) visitString:(HBAstString*)node
+{
+    [self emitLiteral:node.litteralValue];
+    return nil;
+}
+
+- (id) visitValue:(HBAstValue*)node
+{
+    [self emitLiteral:nil];
+    return nil;
+}
+
+- (id) visitParametersHash:(HBAstParametersHash*)node
+{
+    return nil;
+}
+
+#pragma mark -
+
+- (void) dealloc
+{
+    self.code = nil;
+    self.constants = nil;
+    [super dealloc];
+}
+
+@end
@@ -0,0 +1,46 @@
+//
+//  HBAstCodeGenerationVisitor.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstVisitor.h"
+
+// Generates Objective-C render functions (see HBRenderFunction.h) from parsed programs, ahead of time.
+// Every statement list becomes a static C function, and the top-level one is exported under the template function name.
+// Static text becomes constant UTF-8 byte arrays, key paths become lookups of precomputed keys and calls to
+// builtin helpers 'if', 'unless', 'with' and 'each' become inline control flow, guarded against overridden helpers.
+@interface HBAstCodeGenerationVisitor : HBAstVisitor
+
+// C identifier of the render function of a template: prefix, '_' and name, with non identifier characters replaced by '_'
++ (NSString*) functionNameForTemplateName:(NSString*)name prefix:(NSString*)prefix;
+
+// Objective-C source file defining the render functions of programs (template name -> HBAstProgram), in template name order.
+// headerName is the header generated by headerForTemplateNames:prefix:
++ (NSString*) implementationForPrograms:(NSDictionary*)programs prefix:(NSString*)prefix headerName:(NSString*)headerName;
+
+// Header declaring the render functions of templates
++ (NSString*) headerForTemplateNames:(NSArray*)names prefix:(NSString*)prefix;
+
+@end
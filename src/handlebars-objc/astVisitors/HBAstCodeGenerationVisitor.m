@@ -0,0 +1,531 @@
+//
+//  HBAstCodeGenerationVisitor.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstCodeGenerationVisitor.h"
+#import "HBAstParametersHash.h"
+#import "HBRenderFunction.h"
+
+@interface HBAstCodeGenerationVisitor()
+
+@property (copy, nonatomic) NSString* functionName;
+@property (retain, nonatomic) NSMutableString* declarations;  // static data
+@property (retain, nonatomic) NSMutableString* functions;     // generated functions, callees first
+@property (retain, nonatomic) NSMutableString* body;          // body of the function being generated
+@property (retain, nonatomic) NSMutableDictionary* keyArrays; // key list source -> symbol, to share identical key paths
+@property NSInteger indentation;
+@property NSUInteger symbolCount;
+
+- (void) emit:(NSString*)format, ... NS_FORMAT_FUNCTION(1,2);
+- (void) emitLookup:(HBAstContextualValue*)node assignment:(NSString*)assignment;
+
+@end
+
+#pragma mark -
+#pragma mark Literals
+
+// Escapes UTF-8 bytes for a C string literal. Non ASCII bytes are written in octal, or left as is in Objective-C string literals.
+// '?' is escaped so that no trigraph is ever produced.
+static void appendEscapedBytes(NSMutableData* literal, const uint8_t* bytes, NSUInteger length, BOOL keepNonASCII)
+{
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t c = bytes[i];
+        const char* escape = NULL;
+        char octal[5];
+        switch (c) {
+            case '\\': escape = "\\\\"; break;
+            case '"': escape = "\\\""; break;
+            case '?': escape = "\\?"; break;
+            case '\n': escape = "\\n"; break;
+            case '\r': escape = "\\r"; break;
+            case '\t': escape = "\\t"; break;
+            default:
+                if ((c >= 0x20 && c < 0x7f) || (c >= 0x80 && keepNonASCII)) {
+                    [literal appendBytes:&c length:1];
+                } else {
+                    snprintf(octal, sizeof(octal), "\\%03o", c);
+                    escape = octal;
+                }
+                break;
+        }
+        if (escape) [literal appendBytes:escape length:strlen(escape)];
+    }
+}
+
+// C string literal, split after line breaks for readability
+static NSString* cStringLiteral(NSString* string)
+{
+    NSData* data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    const uint8_t* bytes = data.bytes;
+    NSUInteger length = data.length;
+    
+    NSMutableData* literal = [NSMutableData dataWithBytes:"\"" length:1];
+    NSUInteger lineStart = 0;
+    for (NSUInteger i = 0; i < length; i++) {
+        if (bytes[i] == '\n' || i == length - 1) {
+            if (lineStart > 0) [literal appendBytes:"\n    \"" length:6];
+            appendEscapedBytes(literal, bytes + lineStart, i + 1 - lineStart, NO);
+            [literal appendBytes:"\"" length:1];
+            lineStart = i + 1;
+        }
+    }
+    if (length == 0) [literal appendBytes:"\"" length:1];
+    
+    return [[[NSString alloc] initWithData:literal encoding:NSASCIIStringEncoding] autorelease];
+}
+
+static NSString* objcStringLiteral(NSString* string)
+{
+    if (!string) return @"nil";
+    
+    NSData* data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData* literal = [NSMutableData dataWithBytes:"@\"" length:2];
+    appendEscapedBytes(literal, data.bytes, data.length, YES);
+    [literal appendBytes:"\"" length:1];
+    
+    return [[[NSString alloc] initWithData:literal encoding:NSUTF8StringEncoding] autorelease];
+}
+
+@implementation HBAstCodeGenerationVisitor
+
+#pragma mark -
+#pragma mark Source files
+
++ (NSString*) functionNameForTemplateName:(NSString*)name prefix:(NSString*)prefix
+{
+    NSMutableString* functionName = [NSMutableString stringWithFormat:@"%@_", prefix];
+    for (NSUInteger i = 0; i < name.length; i++) {
+        unichar c = [name characterAtIndex:i];
+        BOOL isIdentifierCharacter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        [functionName appendFormat:@"%C", isIdentifierCharacter ? c : (unichar)'_'];
+    }
+    return functionName;
+}
+
++ (NSString*) headerForTemplateNames:(NSArray*)names prefix:(NSString*)prefix
+{
+    NSMutableString* header = [NSMutableString stringWithString:@"// Generated by hbs-codegen from handlebars templates. Do not edit.\n\n"];
+    [header appendString:@"#import <HBHandlebars/HBHandlebars.h>\n\n"];
+    for (NSString* name in [names sortedArrayUsingSelector:@selector(compare:)]) {
+        [header appendFormat:@"extern void %@(HBAstEvaluationVisitor* visitor, NSMutableString* output);\n", [self functionNameForTemplateName:name prefix:prefix]];
+    }
+    return header;
+}
+
++ (NSString*) implementationForPrograms:(NSDictionary*)programs prefix:(NSString*)prefix headerName:(NSString*)headerName
+{
+    NSMutableString* source = [NSMutableString stringWithString:@"// Generated by hbs-codegen from handlebars templates. Do not edit.\n\n"];
+    [source appendFormat:@"#import \"%@\"\n\n", headerName];
+    [source appendFormat:@"#if HB_RENDER_FUNCTION_VERSION != %d\n", HB_RENDER_FUNCTION_VERSION];
+    [source appendString:@"#error \"generated for another version of handlebars-objc: run hbs-codegen again\"\n"];
+    [source appendString:@"#endif\n"];
+    
+    for (NSString* name in [[programs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+        HBAstCodeGenerationVisitor* visitor = [[self alloc] initWithRootAstNode:programs[name]];
+        visitor.functionName = [self functionNameForTemplateName:name prefix:prefix];
+        [source appendFormat:@"\n#pragma mark - %@\n\n", visitor.functionName];
+        [source appendString:[visitor generatedSource]];
+        [visitor release];
+    }
+    
+    return source;
+}
+
+- (NSString*) generatedSource
+{
+    self.declarations = [NSMutableString string];
+    self.functions = [NSMutableString string];
+    self.keyArrays = [NSMutableDictionary dictionary];
+    self.symbolCount = 0;
+    
+    [self visitNode:self.rootNode];
+    
+    NSString* result = [NSString stringWithFormat:@"%@%@%@", self.declarations, self.declarations.length > 0 ? @"\n" : @"", self.functions];
+    self.declarations = nil;
+    self.functions = nil;
+    self.keyArrays = nil;
+    return result;
+}
+
+#pragma mark -
+#pragma mark Emitting code
+
+- (NSString*) symbol:(NSString*)kind
+{
+    self.symbolCount++;
+    return [NSString stringWithFormat:@"%@_%@%lu", self.functionName, kind, (unsigned long)self.symbolCount];
+}
+
+- (NSString*) local:(NSString*)kind
+{
+    self.symbolCount++;
+    return [NSString stringWithFormat:@"%@%lu", kind, (unsigned long)self.symbolCount];
+}
+
+- (void) emit:(NSString*)format, ...
+{
+    va_list args;
+    va_start(args, format);
+    NSString* line = [[NSString alloc] initWithFormat:format arguments:args];
+    va_end(args);
+    
+    for (NSInteger i = 0; i < self.indentation; i++) [self.body appendString:@"    "];
+    [self.body appendString:line];
+    [self.body appendString:@"\n"];
+    [line release];
+}
+
+// Generates a function rendering statements, and returns its name. Empty statement lists have no function: NULL is returned,
+// unless the function is exported.
+- (NSString*) functionForStatements:(NSArray*)statements exportedName:(NSString*)exportedName
+{
+    if (statements.count == 0 && !exportedName) return @"NULL";
+    
+    NSString* name = exportedName ? exportedName : [self symbol:@"statements"];
+    NSMutableString* enclosingBody = [[self.body retain] autorelease];
+    NSInteger enclosingIndentation = self.indentation;
+    self.body = [NSMutableString string];
+    self.indentation = 1;
+    
+    for (HBAstNode* statement in statements) {
+        [self visitNode:statement];
+    }
+    
+    [self.functions appendFormat:@"%@void %@(HBAstEvaluationVisitor* visitor, NSMutableString* output)\n{\n%@}\n\n", exportedName ? @"" : @"static ", name, self.body];
+    
+    self.body = enclosingBody;
+    self.indentation = enclosingIndentation;
+    return name;
+}
+
+- (NSString*) helperNameForExpression:(HBAstExpression*)expression
+{
+    // same rule as HBAstEvaluationVisitor
+    HBAstContextualValue* mainValue = expression.mainValue;
+    if (mainValue.isDataValue) return nil;
+    if (mainValue.keyPath.count != 1) return nil;
+    if ([mainValue.keyPath[0] isCurrentContextReference]) return nil;
+    
+    return [mainValue.keyPath[0] key];
+}
+
+- (BOOL) expressionHasParameters:(HBAstExpression*)expression
+{
+    return expression.positionalParameters.count > 0 || expression.namedParameters.count > 0;
+}
+
+// name reported when a helper called with parameters can't be found
+- (NSString*) missingHelperNameForExpression:(HBAstExpression*)expression
+{
+    if (expression.mainValue.keyPath.count == 0) return @"nil";
+    return objcStringLiteral([expression.mainValue.keyPath[0] key]);
+}
+
+// Evaluates parameters in order, and returns the matching arguments of hb_render_call_helper.
+- (NSString*) emitPositionalParameters:(NSArray*)parameters
+{
+    if (parameters.count == 0) return @"NULL, 0";
+    
+    NSMutableArray* values = [NSMutableArray array];
+    for (HBAstValue* parameter in parameters) {
+        [values addObject:[self visitNode:parameter]];
+    }
+    NSString* array = [self local:@"positional"];
+    [self emit:@"id %@[] = { %@ };", array, [values componentsJoinedByString:@", "]];
+    return [NSString stringWithFormat:@"%@, %lu", array, (unsigned long)values.count];
+}
+
+- (NSString*) emitNamedParameters:(HBAstParametersHash*)parameters
+{
+    if (parameters.count == 0) return @"NULL, NULL, 0";
+    
+    NSMutableArray* names = [NSMutableArray array];
+    NSMutableArray* values = [NSMutableArray array];
+    for (NSString* name in parameters) {
+        [names addObject:objcStringLiteral(name)];
+        [values addObject:[self visitNode:parameters[name]]];
+    }
+    NSString* namesArray = [self symbol:@"names"];
+    [self.declarations appendFormat:@"static NSString* const %@[] = { %@ };\n", namesArray, [names componentsJoinedByString:@", "]];
+    NSString* valuesArray = [self local:@"named"];
+    [self emit:@"id %@[] = { %@ };", valuesArray, [values componentsJoinedByString:@", "]];
+    return [NSString stringWithFormat:@"%@, %@, %lu", namesArray, valuesArray, (unsigned long)values.count];
+}
+
+#pragma mark -
+#pragma mark High-level nodes
+
+- (id) visitProgram:(HBAstProgram*)node
+{
+    [self functionForStatements:node.statements exportedName:self.functionName];
+    return nil;
+}
+
+- (id) visitRawText:(HBAstRawText*)node
+{
+    NSString* text = node.litteralValue;
+    if (text.length == 0) return nil;
+    
+    NSString* bytes = [self symbol:@"text"];
+    NSString* string = [bytes stringByAppendingString:@"_string"];
+    [self.declarations appendFormat:@"static const char %@[] = %@;\n", bytes, cStringLiteral(text)];
+    [self.declarations appendFormat:@"static NSString* %@;\n", string];
+    [self emit:@"hb_render_append_text(output, &%@, %@, sizeof(%@) - 1);", string, bytes, bytes];
+    return nil;
+}
+
+- (id) visitComment:(HBAstComment*)node
+{
+    return nil;
+}
+
+- (id) visitTag:(HBAstTag*)node
+{
+    return nil;
+}
+
+- (id) visitSimpleTag:(HBAstSimpleTag*)node
+{
+    if (!node.expression) return nil;
+    
+    NSString* value = [self visitNode:node.expression];
+    [self emit:@"hb_render_append_value(visitor, output, %@, %@);", value, node.escape ? @"YES" : @"NO"];
+    return nil;
+}
+
+- (id) visitBlock:(HBAstBlock*)node
+{
+    HBAstExpression* expression = node.expression;
+    NSString* statements = [self functionForStatements:node.statements exportedName:nil];
+    NSString* inverseStatements = [self functionForStatements:node.inverseStatements exportedName:nil];
+    
+    BOOL hasParameters = [self expressionHasParameters:expression];
+    NSString* helperName = [self helperNameForExpression:expression];
+    
+    if (!helperName) {
+        if (hasParameters) {
+            [self emit:@"hb_render_missing_helper(visitor, %@);", [self missingHelperNameForExpression:expression]];
+        } else {
+            NSString* value = [self visitContextualValue:expression.mainValue];
+            [self emit:@"hb_render_section(visitor, output, %@, %@, %@);", value, statements, inverseStatements];
+        }
+        return nil;
+    }
+    
+    // whether a key is a helper is only known at render time
+    NSString* helper = [self local:@"helper"];
+    [self emit:@"HBHelper* %@ = hb_render_helper(visitor, %@);", helper, objcStringLiteral(helperName)];
+    [self emit:@"if (%@) {", helper];
+    self.indentation++;
+    
+    NSString* positionalParameters = [self emitPositionalParameters:expression.positionalParameters];
+    NSString* namedParameters = [self emitNamedParameters:expression.namedParameters];
+    NSString* helperCall = [NSString stringWithFormat:@"hb_render_append(output, hb_render_call_helper(visitor, %@, HBHelperInvocationBlock, %@, %@, %@, %@));", helper, positionalParameters, namedParameters, statements, inverseStatements];
+    
+    NSString* inlinedHelper = nil;
+    if ([helperName isEqualToString:@"if"] || [helperName isEqualToString:@"unless"]) {
+        inlinedHelper = [NSString stringWithFormat:@"hb_render_if(visitor, output, %@, %@, %@, %@, %@);", [helperName isEqualToString:@"unless"] ? @"YES" : @"NO", positionalParameters, namedParameters, statements, inverseStatements];
+    } else if ([helperName isEqualToString:@"with"]) {
+        inlinedHelper = [NSString stringWithFormat:@"hb_render_with(visitor, output, %@, %@);", positionalParameters, statements];
+    } else if ([helperName isEqualToString:@"each"]) {
+        inlinedHelper = [NSString stringWithFormat:@"hb_render_each(visitor, output, %@, %@, %@);", positionalParameters, statements, inverseStatements];
+    }
+    
+    if (inlinedHelper) {
+        [self emit:@"if (hb_render_is_builtin_helper(%@, %@)) {", helper, objcStringLiteral(helperName)];
+        [self emit:@"    %@", inlinedHelper];
+        [self emit:@"} else {"];
+        [self emit:@"    %@", helperCall];
+        [self emit:@"}"];
+    } else {
+        [self emit:@"%@", helperCall];
+    }
+    
+    self.indentation--;
+    [self emit:@"} else {"];
+    self.indentation++;
+    if (hasParameters) {
+        [self emit:@"hb_render_missing_helper(visitor, %@);", objcStringLiteral(helperName)];
+    } else {
+        NSString* value = [self visitContextualValue:expression.mainValue];
+        [self emit:@"hb_render_section(visitor, output, %@, %@, %@);", value, statements, inverseStatements];
+    }
+    self.indentation--;
+    [self emit:@"}"];
+    
+    return nil;
+}
+
+- (id) visitPartialTag:(HBAstPartialTag*)node
+{
+    NSString* partial = [self local:@"partial"];
+    [self emit:@"HBPartial* %@ = hb_render_partial(visitor, %@);", partial, objcStringLiteral([node.partialName sourceRepresentation])];
+    [self emit:@"if (%@) {", partial];
+    self.indentation++;
+    
+    if (node.context) {
+        NSString* context = [self visitNode:node.context];
+        [self emit:@"hb_render_push_context(visitor, %@);", context];
+    }
+    
+    if (node.namedParameters) {
+        NSString* namedParameters = [self emitNamedParameters:node.namedParameters];
+        [self emit:@"hb_render_merge_attributes(visitor, %@);", namedParameters];
+    }
+    
+    [self emit:@"hb_render_partial_statements(visitor, output, %@);", partial];
+    if (node.context) [self emit:@"hb_render_pop_context(visitor);"];
+    
+    self.indentation--;
+    [self emit:@"}"];
+    return nil;
+}
+
+#pragma mark -
+#pragma mark Expressions
+
+// Values are evaluated in order into locals, and visiting them returns the C expression of the value.
+
+- (id) visitExpression:(HBAstExpression*)expression
+{
+    BOOL hasParameters = [self expressionHasParameters:expression];
+    NSString* helperName = [self helperNameForExpression:expression];
+    
+    if (!helperName) {
+        if (!hasParameters) return [self visitContextualValue:expression.mainValue];
+        
+        [self emit:@"hb_render_missing_helper(visitor, %@);", [self missingHelperNameForExpression:expression]];
+        return @"nil";
+    }
+    
+    NSString* value = [self local:@"value"];
+    NSString* helper = [self local:@"helper"];
+    [self emit:@"id %@ = nil;", value];
+    [self emit:@"HBHelper* %@ = hb_render_helper(visitor, %@);", helper, objcStringLiteral(helperName)];
+    [self emit:@"if (%@) {", helper];
+    self.indentation++;
+    NSString* positionalParameters = [self emitPositionalParameters:expression.positionalParameters];
+    NSString* namedParameters = [self emitNamedParameters:expression.namedParameters];
+    [self emit:@"%@ = hb_render_call_helper(visitor, %@, HBHelperInvocationExpression, %@, %@, NULL, NULL);", value, helper, positionalParameters, namedParameters];
+    self.indentation--;
+    [self emit:@"} else {"];
+    self.indentation++;
+    if (hasParameters) {
+        [self emit:@"%@ = hb_render_missing_helper(visitor, %@);", value, objcStringLiteral(helperName)];
+    } else {
+        [self emitLookup:expression.mainValue assignment:value];
+    }
+    self.indentation--;
+    [self emit:@"}"];
+    
+    return value;
+}
+
+- (id) visitContextualValue:(HBAstContextualValue*)node
+{
+    NSString* value = [self local:@"value"];
+    [self emitLookup:node assignment:[@"id " stringByAppendingString:value]];
+    return value;
+}
+
+- (void) emitLookup:(HBAstContextualValue*)node assignment:(NSString*)assignment
+{
+    // "this" and ".." components are resolved by the lookup descriptor, like for evaluation
+    [node compileLookupDescriptor];
+    NSUInteger parentLevels = node.parentLevels;
+    
+    NSMutableArray* keys = [NSMutableArray array];
+    for (NSUInteger index = 0; index < node.lookupKeyCount; index++) {
+        [keys addObject:objcStringLiteral(node.lookupKeys[index])];
+    }
+    
+    NSString* keysArray = @"NULL";
+    if (keys.count > 0) {
+        NSString* keyList = [keys componentsJoinedByString:@", "];
+        keysArray = self.keyArrays[keyList];
+        if (!keysArray) {
+            keysArray = [self symbol:@"keys"];
+            self.keyArrays[keyList] = keysArray;
+            [self.declarations appendFormat:@"static NSString* const %@[] = { %@ };\n", keysArray, keyList];
+        }
+    }
+    
+    [self emit:@"%@ = hb_render_lookup(visitor, %lu, %@, %@, %lu);", assignment, (unsigned long)parentLevels, node.isDataValue ? @"YES" : @"NO", keysArray, (unsigned long)keys.count];
+}
+
+- (id) visitKeyPathComponent:(HBAstKeyPathComponent*)node
+{
+    return nil;
+}
+
+- (id) visitNumber:(HBAstNumber*)node
+{
+    NSNumber* number = node.litteralValue;
+    if (!number) return @"nil";
+    if (node.isBoolean) return [number boolValue] ? @"@YES" : @"@NO";
+    
+    const char* type = [number objCType];
+    if (type && (type[0] == 'd' || type[0] == 'f')) {
+        double value = [number doubleValue];
+        if (isnan(value)) return @"[NSNumber numberWithDouble:NAN]";
+        if (isinf(value)) return value > 0 ? @"[NSNumber numberWithDouble:HUGE_VAL]" : @"[NSNumber numberWithDouble:-HUGE_VAL]";
+        return [NSString stringWithFormat:@"[NSNumber numberWithDouble:%.17g]", value];
+    }
+    // -9223372036854775808 is the negation of a literal too large for long long
+    long long value = [number longLongValue];
+    if (value == LLONG_MIN) return @"[NSNumber numberWithLongLong:(-9223372036854775807LL - 1)]";
+    return [NSString stringWithFormat:@"[NSNumber numberWithLongLong:%lldLL]", value];
+}
+
+- (id) visitString:(HBAstString*)node
+{
+    return objcStringLiteral(node.litteralValue);
+}
+
+- (id) visitValue:(HBAstValue*)node
+{
+    return @"nil";
+}
+
+- (id) visitParametersHash:(HBAstParametersHash*)node
+{
+    NSAssert(false, @"parameters hashes are generated with their expression or partial");
+    return nil;
+}
+
+#pragma mark -
+
+- (void) dealloc
+{
+    self.functionName = nil;
+    self.declarations = nil;
+    self.functions = nil;
+    self.body = nil;
+    self.keyArrays = nil;
+    [super dealloc];
+}
+
+@end
@@ -0,0 +1,45 @@
+//
+//  HBAstConditionFoldingVisitor.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstRewritingVisitor.h"
+
+@class HBTemplate;
+
+// Folds constant conditions in the programs templates render: blocks of the builtin if, unless, is, gt, gte, lt and
+// lte helpers whose parameters are all number, boolean or string literals are replaced with the branch the helper
+// would render, following the same rules.
+// Helpers are resolved like when rendering: blocks are folded only where the template resolves the helper to the builtin
+// one, and can bind it (see -[HBTemplate canBindHelpers]).
+// The statements of a block are rendered in a context of their own: they stay in their block when they refer to parent
+// contexts or include partials, which could.
+@interface HBAstConditionFoldingVisitor : HBAstRewritingVisitor
+
+// Returns program itself when it has no condition to fold. helpers receives what the name of every literal condition
+// resolved to, folded or not: a helper, or NSNull.
++ (HBAstProgram*) programByFoldingConditionsOfProgram:(HBAstProgram*)program forTemplate:(HBTemplate*)template helpers:(NSMutableDictionary*)helpers;
+
+@end
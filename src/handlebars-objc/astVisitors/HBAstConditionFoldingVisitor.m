@@ -0,0 +1,213 @@
+//
+//  HBAstConditionFoldingVisitor.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstConditionFoldingVisitor.h"
+#import "HBTemplate.h"
+#import "HBTemplate_Private.h"
+#import "HBHelper.h"
+#import "HBHelperCallingInfo_Private.h"
+#import "HBBuiltinHelpersRegistry.h"
+#import "HBRenderFunction.h"
+
+// Finds references to parent contexts, and partials, in statements
+@interface HBAstParentContextReferenceVisitor : HBAstVisitor
+@end
+
+@interface HBAstConditionFoldingVisitor()
+
+@property (assign, nonatomic) HBTemplate* template;
+@property (retain, nonatomic) NSMutableDictionary* helpers;
+@property (assign, nonatomic) BOOL canBindHelpers;
+
+@end
+
+@implementation HBAstConditionFoldingVisitor
+
++ (HBAstProgram*) programByFoldingConditionsOfProgram:(HBAstProgram*)program forTemplate:(HBTemplate*)template helpers:(NSMutableDictionary*)helpers
+{
+    HBAstConditionFoldingVisitor* visitor = [[HBAstConditionFoldingVisitor alloc] initWithRootAstNode:program];
+    visitor.template = template;
+    visitor.helpers = helpers;
+    visitor.canBindHelpers = template.canBindHelpers;
+    HBAstProgram* result = [visitor rewrittenProgram:program];
+    [visitor release];
+    return result;
+}
+
+static BOOL isLiteral(HBAstValue* value)
+{
+    return [value isKindOfClass:[HBAstNumber class]] || [value isKindOfClass:[HBAstString class]];
+}
+
+static id literalValue(HBAstValue* value)
+{
+    return [(HBAstString*)value litteralValue];
+}
+
+// Name of the helper of a block whose parameters are all literals, nil if it is not a conditional helper
+static NSString* conditionalHelperName(HBAstExpression* expression)
+{
+    HBAstContextualValue* mainValue = expression.mainValue;
+    if (!mainValue || mainValue.isDataValue || mainValue.keyPath.count != 1) return nil;
+    if (expression.positionalParameters.count == 0) return nil;
+    
+    static NSSet* conditionalHelperNames = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        conditionalHelperNames = [[NSSet alloc] initWithObjects:@"if", @"unless", @"is", @"gt", @"gte", @"lt", @"lte", nil];
+    });
+    NSString* name = [mainValue.keyPath[0] key];
+    if (![conditionalHelperNames containsObject:name]) return nil;
+    
+    for (HBAstValue* parameter in expression.positionalParameters) {
+        if (!isLiteral(parameter)) return nil;
+    }
+    for (NSString* parameterName in expression.namedParameters) {
+        if (!isLiteral(expression.namedParameters[parameterName])) return nil;
+    }
+    return name;
+}
+
+// Whether the builtin helper named name renders the statements of a block, rather than its inverse statements
+static BOOL evaluateCondition(NSString* name, HBAstExpression* expression)
+{
+    if ([name isEqualToString:@"if"] || [name isEqualToString:@"unless"]) {
+        id includeZero = expression.namedParameters[@"includeZero"];
+        BOOL condition = [HBBuiltinHelpersRegistry evaluateCondition:literalValue(expression.positionalParameters[0]) includeZero:includeZero ? literalValue(includeZero) : nil];
+        return [name isEqualToString:@"if"] ? condition : !condition;
+    }
+    
+    NSMutableArray* positionalParameters = [NSMutableArray arrayWithCapacity:expression.positionalParameters.count];
+    for (HBAstValue* parameter in expression.positionalParameters) {
+        id value = literalValue(parameter);
+        [positionalParameters addObject:value ? value : [NSNull null]];
+    }
+    HBHelperCallingInfo* callingInfo = [[HBHelperCallingInfo alloc] init];
+    callingInfo.positionalParameters = positionalParameters;
+    BOOL comparisonIsValid;
+    NSComparisonResult comparisonResult = [HBBuiltinHelpersRegistry compare2FirstPositionalParameters:callingInfo validity:&comparisonIsValid];
+    [callingInfo release];
+    
+    if (!comparisonIsValid) return NO;
+    if ([name isEqualToString:@"is"]) return comparisonResult == NSOrderedSame;
+    if ([name isEqualToString:@"gt"]) return comparisonResult == NSOrderedDescending;
+    if ([name isEqualToString:@"gte"]) return comparisonResult != NSOrderedAscending;
+    if ([name isEqualToString:@"lt"]) return comparisonResult == NSOrderedAscending;
+    return comparisonResult != NSOrderedDescending; // lte
+}
+
+static BOOL referToParentContexts(NSArray* statements)
+{
+    HBAstParentContextReferenceVisitor* visitor = [[HBAstParentContextReferenceVisitor alloc] initWithRootAstNode:nil];
+    BOOL result = NO;
+    for (HBAstNode* statement in statements) {
+        if ([visitor visitNode:statement]) {
+            result = YES;
+            break;
+        }
+    }
+    [visitor release];
+    return result;
+}
+
+#pragma mark -
+#pragma mark High-level nodes
+
+- (id) visitBlock:(HBAstBlock*)node
+{
+    HBAstExpression* expression = node.expression;
+    NSString* name = conditionalHelperName(expression);
+    if (!name) return [super visitBlock:node];
+    
+    HBHelper* helper = [self.template helperForName:name];
+    self.helpers[name] = helper ? (id)helper : [NSNull null];
+    if (!self.canBindHelpers || !hb_render_is_builtin_helper(helper, name)) return [super visitBlock:node];
+    
+    // statements are rendered in a context pushed by the helper, inverse statements in the current one
+    BOOL condition = evaluateCondition(name, expression);
+    if (condition && referToParentContexts(node.statements)) return [super visitBlock:node];
+    
+    NSArray* statements = [self rewrittenStatements:condition ? node.statements : node.inverseStatements];
+    return statements ? statements : @[];
+}
+
+#pragma mark -
+
+- (void) dealloc
+{
+    self.helpers = nil;
+    [super dealloc];
+}
+
+@end
+
+@implementation HBAstParentContextReferenceVisitor
+
+// Visiting a node returns a non nil value when it refers to a parent context or includes a partial
+
+- (id) visitNodes:(id<NSFastEnumeration>)nodes
+{
+    for (HBAstNode* node in nodes) {
+        if ([self visitNode:node]) return @YES;
+    }
+    return nil;
+}
+
+- (id) visitBlock:(HBAstBlock*)node
+{
+    if (node.expression && [self visitNode:node.expression]) return @YES;
+    if ([self visitNodes:node.statements]) return @YES;
+    return [self visitNodes:node.inverseStatements];
+}
+
+- (id) visitPartialTag:(HBAstPartialTag*)node
+{
+    return @YES;
+}
+
+- (id) visitSimpleTag:(HBAstSimpleTag*)node
+{
+    return node.expression ? [self visitNode:node.expression] : nil;
+}
+
+- (id) visitExpression:(HBAstExpression*)node
+{
+    if (node.mainValue && [self visitNode:node.mainValue]) return @YES;
+    if ([self visitNodes:node.positionalParameters]) return @YES;
+    for (NSString* name in node.namedParameters) {
+        if ([self visitNode:node.namedParameters[name]]) return @YES;
+    }
+    return nil;
+}
+
+- (id) visitContextualValue:(HBAstContextualValue*)node
+{
+    [node compileLookupDescriptor];
+    return (node.parentLevels > 0) ? @YES : nil;
+}
+
+@end
@@ -38,6 +38,7 @@
 - (id) initWithTemplate:(HBTemplate*)template;
 
 - (NSString*) evaluateWithContext:(id)context;
+- (NSData*) evaluateDataWithContext:(id)context; // UTF-8 output
 
 // escaping
 
@@ -26,6 +26,7 @@
 //
 
 #import "HBAstEvaluationVisitor.h"
+#import "HBAstEvaluationVisitor_Private.h"
 #import "HBHandlebars.h"
 #import "HBAst.h"
 #import "HBContextStack.h"
@@ -34,6 +35,7 @@
 #import "HBContextRendering.h"
 #import "HBHelper.h"
 #import "HBHelperRegistry.h"
+#import "HBHelperRegistry_Private.h"
 #import "HBHelperCallingInfo.h"
 #import "HBHelperCallingInfo_Private.h"
 #import "HBTemplate.h"
@@ -43,11 +45,10 @@
 #import "HBErrorHandling_Private.h"
 #import "HBEscapedString.h"
 #import "HBEscapedString_Private.h"
-
-@interface HBAstEvaluationVisitor()
-@property (retain, nonatomic) HBContextStack* contextStack;
-@property (retain, nonatomic) NSMutableArray* escapingModeStack;
-@end
+#import "HBBytecode.h"
+#import "HBClosureTree.h"
+#import "HBTemplateProfile.h"
+#import "HBTemplateProfile_Private.h"
 
 //
 //
@@ -61,7 +62,8 @@
 // So we use a capped CF string until we reach its max size and then fallback to
 // normal NSMutableString beyond.
 //
-// The key of course is to properly evaluate resulting string length.
+// The key of course is to properly evaluate resulting string length. Strings without an
+// estimate are not capped.
 //
 // We use macros instead of a method call since benchmark gave much better results this
 // way.
@@ -69,8 +71,8 @@
 //
 
 #define CREATE_FASTER_MUTABLE_STRING(__buffer_name__, __estimated_length__) \
-    BOOL __buffer_name__##usingCappedString = true; \
     NSInteger __buffer_name__##cappedLength = (__estimated_length__); \
+    BOOL __buffer_name__##usingCappedString = (__buffer_name__##cappedLength > 0); \
     NSMutableString* __buffer_name__ = (NSMutableString*)CFStringCreateMutable(0, __buffer_name__##cappedLength)
 
 #define APPEND_STRING_TO_FASTER_MUTABLE_STRING(__buffer_name__, __string_to_append__) \
@@ -88,7 +90,80 @@
     do {} while(0)
 
 
+//
+// UTF-8 output. Strings produced while rendering are transcoded through a small buffer
+// as they are appended, so that the output never exists as an NSString.
+//
+
+void hb_append_utf8_string(NSMutableData* data, NSString* string)
+{
+    if ([string isKindOfClass:[HBEscapedString class]]) string = [(HBEscapedString*)string actualString];
+    
+    CFIndex length = CFStringGetLength((CFStringRef)string);
+    CFRange range = CFRangeMake(0, length);
+    UInt8 buffer[1024];
+    while (range.length > 0) {
+        CFIndex usedLength = 0;
+        CFIndex converted = CFStringGetBytes((CFStringRef)string, range, kCFStringEncodingUTF8, '?', false, buffer, sizeof(buffer), &usedLength);
+        if (converted == 0) break;
+        [data appendBytes:buffer length:usedLength];
+        range.location += converted;
+        range.length -= converted;
+    }
+}
+
+// raw text is copied from template source when it still refers to it
+void hb_append_raw_text(NSMutableData* data, HBAstRawText* node)
+{
+    NSData* sourceBuffer = node.sourceBuffer;
+    if (sourceBuffer) {
+        NSRange range = node.sourceRange;
+        [data appendBytes:(const char*)[sourceBuffer bytes] + range.location length:range.length];
+    } else if (node.litteralValue) {
+        hb_append_utf8_string(data, node.litteralValue);
+    }
+}
+
+//
+// Helper bindings. Expressions remember which helper they resolved to (or that none did) through
+// the helper registries of the template they were evaluated by, until a helper registry changes.
+// Templates sharing these registries, such as those rendering the same partial from one execution
+// context, share the binding.
+//
+
+@interface HBHelperBinding : NSObject
+@property (retain, nonatomic) HBHelper* helper; // nil when the expression is not a helper call
+@property (assign, nonatomic) NSUInteger localToken;
+@property (assign, nonatomic) NSUInteger sharedToken;
+@property (assign, nonatomic) NSUInteger generation;
+@end
+
+@implementation HBHelperBinding
+
+- (void) dealloc
+{
+    self.helper = nil;
+    [super dealloc];
+}
+
+@end
+
 @implementation HBAstEvaluationVisitor
+{
+    // what this render executes, taken together from the template, see -[HBTemplate getProgram:executableProgram:bytecode:closureTree:]
+    HBAstProgram* _program;
+    HBBytecode* _bytecode;
+    HBClosureTree* _closureTree;
+    hb_bytecode_registers _bytecodeRegisters;
+    
+    // profile of the template, see -[HBTemplate profile]
+    HBTemplateProfile* _profile;
+    HBTemplateProfileSites* _profileSites;
+    NSData* _profiledBlocksData;
+    const hb_block_profile* _profiledBlocks; // what blocks rendered before, NULL when the profile does not apply
+    BOOL _recordsProfile;
+    hb_block_profile* _recordedBlocks; // how blocks render this time
+}
 
 #pragma mark -
 #pragma mark 'public' API
@@ -96,12 +171,75 @@
 - (id) initWithTemplate:(HBTemplate*)template
 {
     self.template = template;
-    NSAssert(template.program != nil, @"Invalid condition: template provided to HBAstEvaluationVisitor is not compiled or compilation failed");
-    self = [self initWithRootAstNode:template.program];
+    NSAssert(template.program != nil || template.renderFunction != NULL, @"Invalid condition: template provided to HBAstEvaluationVisitor is not compiled or compilation failed");
+    
+    HBAstProgram* program, *executableProgram;
+    HBBytecode* bytecode;
+    HBClosureTree* closureTree;
+    HBTemplateProfileSites* profileSites = nil;
+    @synchronized(template) {
+        [template getProgram:&program executableProgram:&executableProgram bytecode:&bytecode closureTree:&closureTree];
+        if (template.profile && program) profileSites = template.profileSites;
+    }
+    
+    // recorded renders interpret the program itself: profiles number its blocks
+    BOOL recordsProfile = template.recordsProfile && template.profile && program;
+    self = [self initWithRootAstNode:recordsProfile ? program : executableProgram];
+    if (self) {
+        _program = [program retain];
+        _bytecode = [bytecode retain];
+        _closureTree = [closureTree retain];
+        [self prepareProfileRecording:recordsProfile sites:profileSites];
+    }
     return self;
 }
 
-- (NSString*) evaluateWithContext:(id)context
+- (void) prepareProfileRecording:(BOOL)recordsProfile sites:(HBTemplateProfileSites*)profileSites
+{
+    HBTemplateProfile* profile = self.template.profile;
+    if (!profile || !profileSites) return;
+    
+    _profile = [profile retain];
+    _profileSites = [profileSites retain];
+    _profiledBlocksData = [[profile blockProfilesForSites:_profileSites] retain];
+    _profiledBlocks = [_profiledBlocksData bytes];
+    _recordsProfile = recordsProfile;
+    if (recordsProfile) _recordedBlocks = calloc(MAX(_profileSites.blockCount, (NSUInteger)1), sizeof(hb_block_profile));
+}
+
+- (void) recordProfileOfRenderWithOutputLength:(NSUInteger)outputLength
+{
+    if (!_recordsProfile) return;
+    [_profile recordRenderWithOutputLength:outputLength blocks:_recordedBlocks sites:_profileSites];
+}
+
+// profiled and recorded counters of node, NULL when node is not a block of the program profiled
+- (void) getProfiledBlock:(const hb_block_profile**)profiled recordedBlock:(hb_block_profile**)recorded forBlock:(HBAstBlock*)node
+{
+    *profiled = NULL;
+    *recorded = NULL;
+    if (!_profileSites) return;
+    
+    NSUInteger index = [_profileSites indexOfBlock:node];
+    if (index == NSNotFound) return;
+    if (_profiledBlocks) *profiled = &_profiledBlocks[index];
+    if (_recordedBlocks) *recorded = &_recordedBlocks[index];
+}
+
+// statements of blocks usually render about the same length each time, loop bodies in particular
+static NSUInteger estimatedStatementsLength(const hb_block_profile* profile)
+{
+    if (!profile || profile->iterations == 0) return 0;
+    NSUInteger averageLength = profile->outputLength / profile->iterations;
+    return averageLength + averageLength / 4;
+}
+
+- (hb_bytecode_registers*) bytecodeRegisters
+{
+    return &_bytecodeRegisters;
+}
+
+- (void) prepareContextStackWithContext:(id)context
 {
     // Root data context
     HBDataContext* dataContext = nil;
@@ -112,14 +250,76 @@
     
     // prepare context stack
     self.contextStack = [[HBContextStack new] autorelease];
+    self.contextStack.cachesLookups = self.template.cachesRepeatedLookups;
     [self.contextStack push:[HBContextState stateWithContext:context data:dataContext]];
+}
+
+- (NSString*) evaluateWithContext:(id)context
+{
+    [self prepareContextStackWithContext:context];
 
+    // templates generated ahead of time render themselves
+    HBRenderFunction renderFunction = self.template.renderFunction;
+    if (renderFunction) {
+        NSMutableString* result = [NSMutableString string];
+        @autoreleasepool {
+            renderFunction(self, result);
+        }
+        return result;
+    }
+    
+    HBBytecode* bytecode = (self.template.engine == HBTemplateEngineBytecode && !_recordsProfile) ? _bytecode : nil;
+    if (bytecode) {
+        // the machine appends to output directly: capped strings would not grow
+        NSMutableString* result = [NSMutableString stringWithCapacity:[self.template estimatedOutputLength]];
+        @autoreleasepool {
+            [bytecode renderWithVisitor:self toString:result];
+        }
+        return result;
+    }
+    
+    HBClosureTree* closureTree = (self.template.engine == HBTemplateEngineClosures && !_recordsProfile) ? _closureTree : nil;
+    if (closureTree) {
+        NSMutableString* result = [NSMutableString stringWithCapacity:[self.template estimatedOutputLength]];
+        @autoreleasepool {
+            [closureTree renderWithVisitor:self toString:result];
+        }
+        return result;
+    }
+    
     // visit for real now
     NSString* result = [self visitNode:self.rootNode];
+    [self recordProfileOfRenderWithOutputLength:result.length];
     
     return result;
 }
 
+- (NSData*) evaluateDataWithContext:(id)context
+{
+    [self prepareContextStackWithContext:context];
+    
+    HBAstProgram* program = (HBAstProgram*)self.rootNode;
+    NSMutableData* data = [NSMutableData dataWithCapacity:[self.template estimatedOutputLength]];
+    
+    @autoreleasepool {
+        HBRenderFunction renderFunction = self.template.renderFunction;
+        if (renderFunction) {
+            NSMutableString* result = [NSMutableString string];
+            renderFunction(self, result);
+            hb_append_utf8_string(data, result);
+        } else if (self.template.engine == HBTemplateEngineBytecode && _bytecode && !_recordsProfile) {
+            [_bytecode renderWithVisitor:self toData:data];
+        } else if (self.template.engine == HBTemplateEngineClosures && _closureTree && !_recordsProfile) {
+            [_closureTree renderWithVisitor:self toData:data];
+        } else {
+            [self renderStatements:program.statements toData:data];
+            [self recordProfileOfRenderWithOutputLength:data.length];
+        }
+    }
+    
+    return data;
+}
+
 #pragma mark -
 #pragma Escaping Modes
 
@@ -162,7 +362,7 @@
     if (mainValue.isDataValue) return false;
     if (mainValue.keyPath.count != 1) return false;
     
-    if ([[mainValue.keyPath[0] key] isEqualToString:@"this"]) return false;
+    if ([mainValue.keyPath[0] isCurrentContextReference]) return false;
     
     return true;
 }
@@ -184,7 +384,26 @@
     if (![self expressionCanBeHelperCall:expression]) return nil;
     
     NSString* helperName = [expression.mainValue.keyPath[0] key]; // we've checked this is valid right above
-    return [self.template helperForName:helperName];
+    if (!self.template.canBindHelpers) return [self.template helperForName:helperName];
+    
+    // read the generation before resolving the helper, so that a concurrent registration invalidates the binding
+    NSUInteger generation = [HBHelperRegistry currentGeneration];
+    NSUInteger localToken, sharedToken;
+    [self.template getHelperBindingScope:&localToken shared:&sharedToken];
+    HBHelperBinding* binding = expression.helperBinding;
+    if (binding && binding.generation == generation && binding.localToken == localToken && binding.sharedToken == sharedToken) return binding.helper;
+    
+    HBHelper* helper = [self.template helperForName:helperName];
+    
+    binding = [[HBHelperBinding alloc] init];
+    binding.helper = helper;
+    binding.localToken = localToken;
+    binding.sharedToken = sharedToken;
+    binding.generation = generation;
+    expression.helperBinding = binding;
+    [binding release];
+    
+    return helper;
 }
 
 - (void) evaluateContextualParametersInExpression:(HBAstExpression*)expression positionalParameters:(NSArray**)positionalParameters namedParameters:(NSDictionary**)namedParameters
@@ -217,19 +436,31 @@
 
 - (id) visitBlock:(HBAstBlock*)node
 {
+    const hb_block_profile* profiled;
+    hb_block_profile* recorded;
+    [self getProfiledBlock:&profiled recordedBlock:&recorded forBlock:node];
+    if (recorded) recorded->evaluations++;
+    
+    // statements are evaluated with a context pushed, inverse statements without
     NSString* (^evaluateStatements)(id, HBDataContext*, NSArray*, BOOL) = ^(id context, HBDataContext* data, NSArray* statements, BOOL pushContext) {
-        NSMutableString* result = [NSMutableString string];
+        if (recorded) {
+            if (pushContext) recorded->iterations++;
+            else recorded->inverses++;
+        }
         if (!statements || statements.count == 0) return (NSString*)nil;
         
+        CREATE_FASTER_MUTABLE_STRING(result, pushContext ? estimatedStatementsLength(profiled) : 0);
         if (pushContext) [self.contextStack push:[HBContextState stateWithContext:context data:data]];
         for (HBAstNode* statement in statements) {
             id statementResult = [self visitNode:statement];
-            if (statementResult && [statementResult isKindOfClass:[NSString class]])
-                [result appendString:statementResult];
+            if (statementResult && [statementResult isKindOfClass:[NSString class]]) {
+                APPEND_STRING_TO_FASTER_MUTABLE_STRING(result, statementResult);
+            }
         }
         if (pushContext) [self.contextStack pop];
+        if (recorded && pushContext) recorded->outputLength += result.length;
         
-        return (NSString*)result;
+        return (NSString*)[result autorelease];
     };
     
     HBStatementsEvaluator forwardStatementsEvaluator = ^(id context, HBDataContext* data) {
@@ -273,44 +504,52 @@
         return helperResult;
     } else {
         // This is a normal block.
+        NSMutableString* result = [NSMutableString string];
+        [self evaluateSection:node forward:^(id context, HBDataContext* data) {
+            id statementEvaluation = forwardStatementsEvaluator(context, data);
+            if (statementEvaluation) [result appendString:statementEvaluation];
+        } inverse:^{
+            id statementEvaluation = inverseStatementsEvaluator(nil, nil);
+            if (statementEvaluation) [result appendString:statementEvaluation];
+        }];
+        return result;
+    }
+    return nil;
+}
+
+// Blocks that are not helper calls iterate arrays, test scalars, and push any other value as context.
+// forward is called with the context and data of each evaluation of the statements.
+- (void) evaluateSection:(HBAstBlock*)node forward:(void (^)(id context, HBDataContext* data))forward inverse:(void (^)(void))inverse
+{
+    id evaluatedExpression = [self visitExpression:node.expression];
+    HBDataContext* currentData = [[self.contextStack current] dataContext];
+    
+    if ([HBHelperUtils isEnumerableByIndex:evaluatedExpression] ) {
+        // Array-like context
+        id<NSFastEnumeration> arrayLike = evaluatedExpression;
+        NSInteger index = 0;
+        HBDataContext* arrayData = [[self.contextStack current] dataContextCopyOrNew];
+        for (id arrayElement in arrayLike) {
+            arrayData[@"index"] = @(index);
+            forward(arrayElement, arrayData);
+            index++;
+        }
+        [arrayData release];
         
-        id evaluatedExpression = [self visitExpression:node.expression];
-        HBDataContext* currentData = [[self.contextStack current] dataContext];
-                                      
-        if ([HBHelperUtils isEnumerableByIndex:evaluatedExpression] ) {
-            // Array-like context
-            id<NSFastEnumeration> arrayLike = evaluatedExpression;
-            NSInteger index = 0;
-            HBDataContext* arrayData = [[self.contextStack current] dataContextCopyOrNew];
-            NSMutableString* result = [NSMutableString string];
-            for (id arrayElement in arrayLike) {
-                arrayData[@"index"] = @(index);
-                id statementEvaluation = forwardStatementsEvaluator(arrayElement, arrayData);
-                if (statementEvaluation) [result appendString:statementEvaluation];
-                index++;
-            }
-            [arrayData release];
-            
-            // special case for empty array-like contexts. Evaluate inverse section if they're empty (as per .js implementation).
-            if (index == 0) {
-                return inverseStatementsEvaluator(evaluatedExpression, currentData);
-            } else {
-                return result;
-            }
-            
-        } else if (evaluatedExpression == nil || [evaluatedExpression isKindOfClass:[NSString class]] || [evaluatedExpression isKindOfClass:[NSNumber class]]) {
-            // String of scalar context
-            if ([HBHelperUtils evaluateObjectAsBool:evaluatedExpression]) {
-                return forwardStatementsEvaluator(evaluatedExpression, currentData);
-            } else {
-                return inverseStatementsEvaluator(evaluatedExpression, currentData);
-            }
+        // special case for empty array-like contexts. Evaluate inverse section if they're empty (as per .js implementation).
+        if (index == 0) inverse();
+        
+    } else if (evaluatedExpression == nil || [evaluatedExpression isKindOfClass:[NSString class]] || [evaluatedExpression isKindOfClass:[NSNumber class]]) {
+        // String of scalar context
+        if ([HBHelperUtils evaluateObjectAsBool:evaluatedExpression]) {
+            forward(evaluatedExpression, currentData);
         } else {
-            // Dictionary-like context
-            return forwardStatementsEvaluator(evaluatedExpression, currentData);            
+            inverse();
         }
+    } else {
+        // Dictionary-like context
+        forward(evaluatedExpression, currentData);
     }
-    return nil;
 }
 
 - (id) visitComment:(HBAstComment*)node
@@ -320,6 +559,27 @@
 
 - (id) visitPartialTag:(HBAstPartialTag*)node
 {
+    BOOL shouldPopContext = false;
+    HBPartial* partial = [self beginPartial:node pushedContext:&shouldPopContext];
+    if (!partial) return nil;
+    
+    NSMutableString* buffer = [NSMutableString string];
+    for (HBAstNode* statement in partial.astStatements) {
+        id result = [self visitNode:statement];
+        if (result && [result isKindOfClass:[NSString class]])
+            [buffer appendString:result];
+    }
+    
+    if (shouldPopContext) [self.contextStack pop];
+    
+    return buffer;
+}
+
+// Finds and compiles the partial of a partial tag, and pushes the context it is rendered in. Returns nil after reporting an error.
+// Context must be popped by caller when pushedContext is set.
+- (HBPartial*) beginPartial:(HBAstPartialTag*)node pushedContext:(BOOL*)pushedContext
+{
+    *pushedContext = false;
     if (self.error) return nil;
     HBAstValue* partialNameNode = node.partialName;
     NSString* partialName = [partialNameNode sourceRepresentation];
@@ -340,12 +600,11 @@
         return nil;
     }
     
-    BOOL shouldPopContext = false;
     if (node.context) {
         id evaluatedContext = [self visitNode:node.context];
         HBDataContext* data = self.contextStack.current.dataContext;
         [self.contextStack push:[HBContextState stateWithContext:evaluatedContext data:data]];
-        shouldPopContext = true;
+        *pushedContext = true;
     }
     
     if (node.namedParameters) {
@@ -353,21 +612,53 @@
         self.contextStack.current.mergedAttributes = partialParams;
     }
     
-    NSMutableString* buffer = [NSMutableString string];
-    for (HBAstNode* statement in partial.astStatements) {
-        id result = [self visitNode:statement];
-        if (result && [result isKindOfClass:[NSString class]])
-            [buffer appendString:result];
+    return partial;
+}
+
+#pragma mark -
+#pragma mark UTF-8 output
+
+// Same as visiting statements and concatenating results, writing to data as it goes. Raw text, sections and partials
+// are rendered in place. Other statements, such as helper calls, are rendered as strings then appended.
+- (void) renderStatements:(NSArray*)statements toData:(NSMutableData*)data
+{
+    for (HBAstNode* statement in statements) {
+        if ([statement isKindOfClass:[HBAstRawText class]]) {
+            hb_append_raw_text(data, (HBAstRawText*)statement);
+        } else if ([statement isKindOfClass:[HBAstBlock class]] && ![self expressionIsHelperCall:[(HBAstBlock*)statement expression]]) {
+            HBAstBlock* block = (HBAstBlock*)statement;
+            const hb_block_profile* profiled;
+            hb_block_profile* recorded;
+            [self getProfiledBlock:&profiled recordedBlock:&recorded forBlock:block];
+            if (recorded) recorded->evaluations++;
+            [self evaluateSection:block forward:^(id context, HBDataContext* contextData) {
+                if (recorded) recorded->iterations++;
+                if (block.statements.count == 0) return;
+                NSUInteger length = data.length;
+                [self.contextStack push:[HBContextState stateWithContext:context data:contextData]];
+                [self renderStatements:block.statements toData:data];
+                [self.contextStack pop];
+                if (recorded) recorded->outputLength += data.length - length;
+            } inverse:^{
+                if (recorded) recorded->inverses++;
+                [self renderStatements:block.inverseStatements toData:data];
+            }];
+        } else if ([statement isKindOfClass:[HBAstPartialTag class]]) {
+            BOOL shouldPopContext = false;
+            HBPartial* partial = [self beginPartial:(HBAstPartialTag*)statement pushedContext:&shouldPopContext];
+            if (!partial) continue;
+            [self renderStatements:partial.astStatements toData:data];
+            if (shouldPopContext) [self.contextStack pop];
+        } else {
+            id result = [self visitNode:statement];
+            if (result && [result isKindOfClass:[NSString class]]) hb_append_utf8_string(data, result);
+        }
     }
-    
-    if (shouldPopContext) [self.contextStack pop];
-    
-    return buffer;
 }
 
 - (id) visitProgram:(HBAstProgram*)node
 {
-    CREATE_FASTER_MUTABLE_STRING(buffer, 1.2 * self.template.templateString.length);
+    CREATE_FASTER_MUTABLE_STRING(buffer, [self.template estimatedOutputLength]);
     
     @autoreleasepool {
         for (HBAstNode* statement in node.statements) {
@@ -488,6 +779,14 @@
 
 - (void) dealloc
 {
+    [_program release];
+    [_bytecode release];
+    [_closureTree release];
+    free(_bytecodeRegisters.values);
+    [_profile release];
+    [_profileSites release];
+    [_profiledBlocksData release];
+    free(_recordedBlocks);
     self.template = nil;
     self.error = nil;
     self.contextStack = nil;
@@ -0,0 +1,51 @@
+//
+//  HBAstEvaluationVisitor_Private.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstEvaluationVisitor.h"
+#import "HBBytecode.h"
+
+@class HBContextStack;
+@class HBHelper;
+@class HBAstExpression;
+@class HBAstRawText;
+
+// Shared with render functions generated ahead of time (see HBRenderFunction.h) and with the bytecode engine (see HBBytecode.h),
+// which run on the same state as the interpreter.
+@interface HBAstEvaluationVisitor()
+@property (retain, nonatomic) HBContextStack* contextStack;
+@property (retain, nonatomic) NSMutableArray* escapingModeStack;
+
+// helper an expression calls, or nil when it is not a helper call. Bound on the expression, see -[HBAstExpression helperBinding].
+- (HBHelper*) helperForExpression:(HBAstExpression*)expression;
+
+// registers of the bytecode engine, allocated on first use and grown as statements nest, for every statement this visitor renders
+- (hb_bytecode_registers*) bytecodeRegisters;
+@end
+
+// UTF-8 output: strings are transcoded as they are appended, raw text is copied from template source when it still refers to it
+extern void hb_append_utf8_string(NSMutableData* data, NSString* string);
+extern void hb_append_raw_text(NSMutableData* data, HBAstRawText* node);
@@ -0,0 +1,43 @@
+//
+//  HBAstFreezingVisitor.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstVisitor.h"
+
+// Converts a compiled AST to its compact read-only form: mutable arrays built while parsing are
+// replaced by immutable arrays holding their children contiguously, and parameter hashes release their
+// unused capacity. Freezing is idempotent, so ASTs sharing nodes can be frozen again safely.
+// Contextual values get their lookup descriptor, and caching is enabled on those looked up more than once in
+// the same scope: statements at the same level, and inverse statements of the blocks among them, which render in
+// the same context. Statements of a block render in a scope of their own.
+@interface HBAstFreezingVisitor : HBAstVisitor
+
++ (void) freezeProgram:(HBAstProgram*)program;
+
+// Freeze the statements array of program, and the statements in range only. Other statements are already frozen.
++ (void) freezeProgram:(HBAstProgram*)program statementsInRange:(NSRange)range;
+
+@end
@@ -0,0 +1,212 @@
+//
+//  HBAstFreezingVisitor.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstFreezingVisitor.h"
+
+// immutable arrays keep their objects inline, after the array header
+static NSArray* frozenArray(NSArray* array)
+{
+    return [array isKindOfClass:[NSMutableArray class]] ? [[array copy] autorelease] : array;
+}
+
+@interface HBAstFreezingVisitor()
+
+@property (retain, nonatomic) NSMutableArray* scopes; // lookup signature -> contextual values, for enclosing scopes
+@property (assign, nonatomic) BOOL recordsLookups;
+@property (assign, nonatomic) HBAstProgram* program; // frozen, whose lookupCacheKeys is created for its first cached lookup
+
+@end
+
+@implementation HBAstFreezingVisitor
+
++ (void) freezeProgram:(HBAstProgram*)program
+{
+    [self freezeProgram:program statementsInRange:NSMakeRange(0, program.statements.count)];
+}
+
++ (void) freezeProgram:(HBAstProgram*)program statementsInRange:(NSRange)range
+{
+    if (!program) return;
+    HBAstFreezingVisitor* visitor = [[HBAstFreezingVisitor alloc] initWithRootAstNode:program];
+    visitor.scopes = [NSMutableArray array];
+    visitor.recordsLookups = YES;
+    visitor.program = program;
+    NSArray* statements = frozenArray(program.statements);
+    if (statements != program.statements) program.statements = statements;
+    [visitor beginScope];
+    for (NSUInteger i = range.location; i < NSMaxRange(range); i++) {
+        [visitor visitNode:statements[i]];
+    }
+    [visitor endScope];
+    [visitor release];
+}
+
+#pragma mark -
+#pragma mark Scopes
+
+- (void) beginScope
+{
+    [self.scopes addObject:[NSMutableDictionary dictionary]];
+}
+
+// repeated lookups of the scope are cached
+- (void) endScope
+{
+    NSDictionary* lookups = self.scopes.lastObject;
+    for (NSArray* signature in lookups) {
+        NSArray* values = lookups[signature];
+        if (values.count < 2) continue;
+        if (!self.program.lookupCacheKeys) self.program.lookupCacheKeys = [NSMutableDictionary dictionary];
+        for (HBAstContextualValue* value in values) {
+            [value enableLookupCachingWithKeys:self.program.lookupCacheKeys];
+        }
+    }
+    [self.scopes removeLastObject];
+}
+
+- (void) recordLookup:(HBAstContextualValue*)value
+{
+    NSArray* signature = [value lookupSignature];
+    if (!signature) return;
+    
+    NSMutableDictionary* lookups = self.scopes.lastObject;
+    NSMutableArray* values = lookups[signature];
+    if (!values) {
+        values = [NSMutableArray array];
+        lookups[signature] = values;
+    }
+    [values addObject:value];
+}
+
+// values that are not looked up, such as names of partials and helpers: they get no lookup descriptor either
+- (void) visitUnrecordedNode:(HBAstNode*)node
+{
+    BOOL recordsLookups = self.recordsLookups;
+    self.recordsLookups = NO;
+    [self visitNode:node];
+    self.recordsLookups = recordsLookups;
+}
+
+- (void) visitStatements:(NSArray*)statements
+{
+    for (HBAstNode* statement in statements) {
+        [self visitNode:statement];
+    }
+}
+
+#pragma mark -
+#pragma mark High-level nodes
+
+- (id) visitBlock:(HBAstBlock*)node
+{
+    NSArray* statements = frozenArray(node.statements);
+    if (statements != node.statements) node.statements = statements;
+    NSArray* inverseStatements = frozenArray(node.inverseStatements);
+    if (inverseStatements != node.inverseStatements) node.inverseStatements = inverseStatements;
+    
+    if (node.openTag) [self visitNode:node.openTag];
+    [self beginScope];
+    [self visitStatements:node.statements];
+    [self endScope];
+    [self visitStatements:node.inverseStatements];
+    return nil;
+}
+
+- (id) visitPartialTag:(HBAstPartialTag*)node
+{
+    if (node.partialName) [self visitUnrecordedNode:node.partialName];
+    if (node.context) [self visitNode:node.context];
+    if (node.namedParameters) [self visitNode:node.namedParameters];
+    return nil;
+}
+
+- (id) visitProgram:(HBAstProgram*)node
+{
+    [HBAstFreezingVisitor freezeProgram:node];
+    return nil;
+}
+
+- (id) visitSimpleTag:(HBAstSimpleTag*)node
+{
+    if (node.expression) [self visitNode:node.expression];
+    return nil;
+}
+
+- (id) visitTag:(HBAstTag*)node
+{
+    if (node.expression) [self visitNode:node.expression];
+    return nil;
+}
+
+#pragma mark -
+#pragma mark Expressions
+
+- (id) visitContextualValue:(HBAstContextualValue*)node
+{
+    NSArray* keyPath = frozenArray(node.keyPath);
+    if (keyPath != node.keyPath) node.keyPath = keyPath;
+    if (self.recordsLookups) {
+        [node compileLookupDescriptor];
+        [self recordLookup:node];
+    }
+    return nil;
+}
+
+- (id) visitExpression:(HBAstExpression*)node
+{
+    NSArray* positionalParameters = frozenArray(node.positionalParameters);
+    if (positionalParameters != node.positionalParameters) node.positionalParameters = positionalParameters;
+    
+    // helper calls with parameters never look their name up
+    BOOL hasParameters = (node.positionalParameters.count > 0 || node.namedParameters.count > 0);
+    if (node.mainValue && hasParameters) [self visitUnrecordedNode:node.mainValue];
+    else if (node.mainValue) [self visitNode:node.mainValue];
+    for (HBAstValue* parameter in node.positionalParameters) {
+        [self visitNode:parameter];
+    }
+    if (node.namedParameters) [self visitNode:node.namedParameters];
+    return nil;
+}
+
+- (id) visitParametersHash:(HBAstParametersHash*)node
+{
+    [node compact];
+    for (NSString* name in node) {
+        [self visitNode:node[name]];
+    }
+    return nil;
+}
+
+#pragma mark -
+
+- (void) dealloc
+{
+    self.scopes = nil;
+    [super dealloc];
+}
+
+@end
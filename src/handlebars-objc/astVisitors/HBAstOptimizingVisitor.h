@@ -0,0 +1,42 @@
+//
+//  HBAstOptimizingVisitor.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstVisitor.h"
+
+// Simplifies the statements of compiled programs, so that there are fewer nodes to visit and append when rendering:
+// - adjacent raw text is merged into a single node (text split by escaped mustaches, comments or whitespace control)
+// - comments and empty raw text are dropped
+// Top-level statements keep source spans that follow each other. The bytes of dropped statements are left out of them.
+@interface HBAstOptimizingVisitor : HBAstVisitor
+
++ (void) optimizeProgram:(HBAstProgram*)program;
+
+// Optimize the top-level statements in range only, for instance those parsed again after an edit. Statements
+// around range must not be raw text. Returns the range of the optimized statements.
++ (NSRange) optimizeProgram:(HBAstProgram*)program statementsInRange:(NSRange)range;
+
+@end
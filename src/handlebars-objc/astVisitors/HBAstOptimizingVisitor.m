@@ -0,0 +1,159 @@
+//
+//  HBAstOptimizingVisitor.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstOptimizingVisitor.h"
+
+@interface HBAstOptimizingVisitor()
+
+// text of merged raw text nodes, for the whole optimization
+@property (retain, nonatomic) NSMutableData* mergedText;
+
+@end
+
+@implementation HBAstOptimizingVisitor
+
++ (void) optimizeProgram:(HBAstProgram*)program
+{
+    [self optimizeProgram:program statementsInRange:NSMakeRange(0, program.statements.count)];
+}
+
++ (NSRange) optimizeProgram:(HBAstProgram*)program statementsInRange:(NSRange)range
+{
+    if (!program) return range;
+    
+    NSArray* statements = program.statements;
+    HBAstOptimizingVisitor* visitor = [[HBAstOptimizingVisitor alloc] initWithRootAstNode:program];
+    NSArray* optimizedStatements = [visitor optimizedStatements:[statements subarrayWithRange:range]];
+    if (!optimizedStatements) optimizedStatements = @[];
+    [visitor release];
+    
+    NSMutableArray* newStatements = [NSMutableArray arrayWithArray:statements];
+    [newStatements replaceObjectsInRange:range withObjectsFromArray:optimizedStatements];
+    program.statements = newStatements;
+    
+    // statements parsed together share their source offset
+    if (program.statementSourceOffsets) {
+        NSMutableArray* offsets = [NSMutableArray arrayWithArray:program.statementSourceOffsets];
+        NSNumber* offset = (range.length > 0) ? offsets[range.location] : @0;
+        NSMutableArray* newOffsets = [NSMutableArray arrayWithCapacity:optimizedStatements.count];
+        for (NSUInteger i = 0; i < optimizedStatements.count; i++) [newOffsets addObject:offset];
+        [offsets replaceObjectsInRange:range withObjectsFromArray:newOffsets];
+        program.statementSourceOffsets = offsets;
+    }
+    
+    return NSMakeRange(range.location, optimizedStatements.count);
+}
+
+// Merges a run of raw text nodes into the first non empty one. Returns nil when they are all empty.
+- (HBAstRawText*) mergedRawText:(NSArray*)run
+{
+    HBAstRawText* result = nil;
+    NSUInteger nonEmptyCount = 0;
+    for (HBAstRawText* rawText in run) {
+        NSUInteger length = rawText.sourceBuffer ? rawText.sourceRange.length : rawText.litteralValue.length;
+        if (length == 0) continue;
+        if (!result) result = rawText;
+        nonEmptyCount++;
+    }
+    if (nonEmptyCount < 2) return result;
+    
+    if (!self.mergedText) self.mergedText = [NSMutableData data];
+    NSUInteger location = self.mergedText.length;
+    for (HBAstRawText* rawText in run) {
+        NSData* sourceBuffer = rawText.sourceBuffer;
+        if (sourceBuffer) {
+            NSRange range = rawText.sourceRange;
+            [self.mergedText appendBytes:(const char*)[sourceBuffer bytes] + range.location length:range.length];
+        } else if (rawText.litteralValue) {
+            [self.mergedText appendData:[rawText.litteralValue dataUsingEncoding:NSUTF8StringEncoding]];
+        }
+    }
+    
+    NSRange firstSpan = [run.firstObject sourceSpan];
+    NSRange lastSpan = [run.lastObject sourceSpan];
+    [result setSourceBuffer:self.mergedText range:NSMakeRange(location, self.mergedText.length - location)];
+    result.sourceSpan = NSMakeRange(firstSpan.location, NSMaxRange(lastSpan) - firstSpan.location);
+    return result;
+}
+
+// Returns the optimized statements, nil when there are none left.
+- (NSArray*) optimizedStatements:(NSArray*)statements
+{
+    NSMutableArray* result = [NSMutableArray arrayWithCapacity:statements.count];
+    NSMutableArray* run = [NSMutableArray array];
+    
+    for (HBAstNode* statement in statements) {
+        if ([statement isKindOfClass:[HBAstComment class]]) continue;
+        
+        if ([statement isKindOfClass:[HBAstRawText class]]) {
+            [run addObject:statement];
+            continue;
+        }
+        
+        if (run.count > 0) {
+            HBAstRawText* rawText = [self mergedRawText:run];
+            if (rawText) [result addObject:rawText];
+            [run removeAllObjects];
+        }
+        
+        [self visitNode:statement];
+        [result addObject:statement];
+    }
+    
+    if (run.count > 0) {
+        HBAstRawText* rawText = [self mergedRawText:run];
+        if (rawText) [result addObject:rawText];
+    }
+    
+    return (result.count > 0) ? result : nil;
+}
+
+#pragma mark -
+#pragma mark High-level nodes
+
+- (id) visitBlock:(HBAstBlock*)node
+{
+    node.statements = [self optimizedStatements:node.statements];
+    node.inverseStatements = [self optimizedStatements:node.inverseStatements];
+    return nil;
+}
+
+- (id) visitProgram:(HBAstProgram*)node
+{
+    [HBAstOptimizingVisitor optimizeProgram:node];
+    return nil;
+}
+
+#pragma mark -
+
+- (void) dealloc
+{
+    self.mergedText = nil;
+    [super dealloc];
+}
+
+@end
@@ -0,0 +1,41 @@
+//
+//  HBAstPartialInliningVisitor.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstRewritingVisitor.h"
+
+@class HBTemplate;
+
+// Splices partials into the programs of templates that inline them (see -[HBTemplate inlinesPartials]).
+// Partial tags without context nor parameters are replaced with the statements of the partial the template
+// resolves them to, transitively. Partials that are missing, fail to compile or include themselves stay partial
+// tags, resolved when rendering.
+@interface HBAstPartialInliningVisitor : HBAstRewritingVisitor
+
+// Returns program itself when it has no partial to inline. inlinedPartials receives the partials spliced in, by name.
++ (HBAstProgram*) programByInliningPartialsOfProgram:(HBAstProgram*)program forTemplate:(HBTemplate*)template inlinedPartials:(NSMutableDictionary*)inlinedPartials;
+
+@end
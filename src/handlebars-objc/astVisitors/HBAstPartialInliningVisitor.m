@@ -0,0 +1,87 @@
+//
+//  HBAstPartialInliningVisitor.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstPartialInliningVisitor.h"
+#import "HBTemplate.h"
+#import "HBTemplate_Private.h"
+#import "HBPartial.h"
+#import "HBPartial_Private.h"
+
+@interface HBAstPartialInliningVisitor()
+
+@property (assign, nonatomic) HBTemplate* template;
+@property (retain, nonatomic) NSMutableDictionary* inlinedPartials;
+@property (retain, nonatomic) NSMutableArray* partialNames; // partials being inlined, outermost first
+
+@end
+
+@implementation HBAstPartialInliningVisitor
+
++ (HBAstProgram*) programByInliningPartialsOfProgram:(HBAstProgram*)program forTemplate:(HBTemplate*)template inlinedPartials:(NSMutableDictionary*)inlinedPartials
+{
+    HBAstPartialInliningVisitor* visitor = [[HBAstPartialInliningVisitor alloc] initWithRootAstNode:program];
+    visitor.template = template;
+    visitor.inlinedPartials = inlinedPartials;
+    visitor.partialNames = [NSMutableArray array];
+    HBAstProgram* result = [visitor rewrittenProgram:program];
+    [visitor release];
+    return result;
+}
+
+#pragma mark -
+#pragma mark High-level nodes
+
+- (id) visitPartialTag:(HBAstPartialTag*)node
+{
+    // partials with a context or parameters render in a context of their own
+    if (node.context || node.namedParameters) return nil;
+    
+    NSString* partialName = [node.partialName sourceRepresentation];
+    if ([self.partialNames containsObject:partialName]) return nil;
+    
+    // errors are reported when rendering
+    HBPartial* partial = [self.template partialForName:partialName];
+    if (!partial || ![partial compile:nil]) return nil;
+    
+    self.inlinedPartials[partialName] = partial;
+    [self.partialNames addObject:partialName];
+    NSArray* statements = [self rewrittenStatements:partial.astStatements];
+    [self.partialNames removeLastObject];
+    
+    return statements ? statements : @[];
+}
+
+#pragma mark -
+
+- (void) dealloc
+{
+    self.inlinedPartials = nil;
+    self.partialNames = nil;
+    [super dealloc];
+}
+
+@end
@@ -0,0 +1,91 @@
+//
+//  HBAstRewritingVisitor.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstRewritingVisitor.h"
+
+@implementation HBAstRewritingVisitor
+
+- (HBAstProgram*) rewrittenProgram:(HBAstProgram*)program
+{
+    if (!program) return nil;
+    
+    NSArray* statements = [self rewrittenStatements:program.statements];
+    if (statements == program.statements) return program;
+    
+    HBAstProgram* result = [[HBAstProgram new] autorelease];
+    result.statements = statements;
+    return result;
+}
+
+- (NSArray*) rewrittenStatements:(NSArray*)statements
+{
+    NSMutableArray* result = nil;
+    NSUInteger index = 0;
+    for (HBAstNode* statement in statements) {
+        NSArray* replacement = [self visitNode:statement];
+        if (replacement && !result) {
+            result = [NSMutableArray arrayWithCapacity:statements.count];
+            [result addObjectsFromArray:[statements subarrayWithRange:NSMakeRange(0, index)]];
+        }
+        if (replacement) {
+            [result addObjectsFromArray:replacement];
+        } else if (result) {
+            [result addObject:statement];
+        }
+        index++;
+    }
+    
+    // immutable, like frozen statements
+    return result ? [[result copy] autorelease] : statements;
+}
+
+- (HBAstBlock*) block:(HBAstBlock*)block withStatements:(NSArray*)statements inverseStatements:(NSArray*)inverseStatements
+{
+    HBAstBlock* result = [[HBAstBlock new] autorelease];
+    result.sourceSpan = block.sourceSpan;
+    result.openTag = block.openTag;
+    result.elseTag = block.elseTag;
+    result.closeTag = block.closeTag;
+    result.invertedBlock = block.invertedBlock;
+    result.statements = statements;
+    result.inverseStatements = inverseStatements;
+    return result;
+}
+
+#pragma mark -
+#pragma mark High-level nodes
+
+- (id) visitBlock:(HBAstBlock*)node
+{
+    NSArray* statements = [self rewrittenStatements:node.statements];
+    NSArray* inverseStatements = [self rewrittenStatements:node.inverseStatements];
+    if (statements == node.statements && inverseStatements == node.inverseStatements) return nil;
+    
+    return @[ [self block:node withStatements:statements inverseStatements:inverseStatements] ];
+}
+
+@end
@@ -32,6 +32,7 @@
 @interface HBContextStack : NSObject
 
 @property (readonly) HBContextState* current;
+@property (assign, nonatomic) BOOL cachesLookups; // given to states pushed, see -[HBContextState cachesLookups]
 
 - (void) push:(HBContextState*)state;
 - (void) pop;
@@ -38,6 +38,7 @@
 - (void) push:(HBContextState*)state
 {
     state.parent = self.current;
+    state.cachesLookups = self.cachesLookups;
     self.current = state;
     
     // Line below implements one part of the
@@ -26,6 +26,7 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "HBObjectPropertyAccess.h"
 
 @class HBAstContextualValue;
 @class HBDataContext;
@@ -37,10 +38,21 @@
 @property (retain, nonatomic) NSDictionary* mergedAttributes;
 @property (retain, nonatomic) HBContextState* parent;
 
+// When set, values of contextual values with a lookup cache key (see -[HBAstContextualValue lookupCacheKey]) are
+// looked up once in the state, and reused. Setting mergedAttributes forgets them.
+@property (assign, nonatomic) BOOL cachesLookups;
+
 + (instancetype)stateWithContext:(id)context data:(HBDataContext*)data;
 
 - (id) evaluateContextualValue:(HBAstContextualValue*)value;
 
+// Same lookup as evaluateContextualValue:, for a key path resolved ahead of time: "this" dropped, parentLevels ".."
+// components, then keys. When isDataValue is set, keys[0] is read from the data context.
+- (id) evaluateKeys:(NSString* const*)keys count:(NSUInteger)count parentLevels:(NSUInteger)parentLevels isDataValue:(BOOL)isDataValue;
+
+// Same as above, reading each key through the inline cache with the same index in propertyCaches (see -[HBAstContextualValue propertyCaches])
+- (id) evaluateKeys:(NSString* const*)keys count:(NSUInteger)count parentLevels:(NSUInteger)parentLevels isDataValue:(BOOL)isDataValue propertyCaches:(hb_property_cache*)propertyCaches;
+
 - (HBDataContext*) dataContextCopyOrNew NS_RETURNS_RETAINED; // must be released by sender as per usual conventions on copy and new
 
 @end
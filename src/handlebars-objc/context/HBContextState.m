@@ -27,10 +27,26 @@
 
 #import "HBContextState.h"
 #import "HBAstContextualValue.h" 
+#import "HBAstKeyPathComponent.h"
 #import "HBDataContext.h" 
 #import "HBObjectPropertyAccess.h"
 
+// cached value of lookups that found nothing
+static id hb_no_value = nil;
+
 @implementation HBContextState
+{
+    CFMutableDictionaryRef _lookupCache; // lookup cache key -> value. Keys are interned: they are compared by address, and retained so that addresses are not reused.
+}
+
+@synthesize mergedAttributes = _mergedAttributes;
+
++ (void) initialize
+{
+    if (self == [HBContextState class]) {
+        hb_no_value = [NSObject new];
+    }
+}
 
 + (instancetype)stateWithContext:(id)context data:(HBDataContext*)data
 {
@@ -41,6 +57,11 @@
 }
 
 - (id) valueForKey:(NSString*)key context:(id)context includeMergedAttributes:(BOOL)includeMergedAttributes
+{
+    return [self valueForKey:key context:context includeMergedAttributes:includeMergedAttributes cache:NULL];
+}
+
+- (id) valueForKey:(NSString*)key context:(id)context includeMergedAttributes:(BOOL)includeMergedAttributes cache:(hb_property_cache*)cache
 {
     if (!context) return nil;
     id result;
@@ -49,7 +70,7 @@
     }
         
     @try {
-        result = [HBObjectPropertyAccess valueForKey:key onObject:context];
+        result = [HBObjectPropertyAccess valueForKey:key onObject:context cache:cache];
     }
     @catch (NSException* e) {
         result = nil;
@@ -58,8 +79,35 @@
     return result;
 }
 
+// merged attributes take precedence over the context: lookups made before they changed may not hold anymore
+- (void) setMergedAttributes:(NSDictionary*)mergedAttributes
+{
+    if (mergedAttributes == _mergedAttributes) return;
+    [_mergedAttributes release];
+    _mergedAttributes = [mergedAttributes retain];
+    if (_lookupCache) CFDictionaryRemoveAllValues(_lookupCache);
+}
+
 - (id) evaluateContextualValue:(HBAstContextualValue*)value
 {
+    // frozen ASTs have their key paths compiled already
+    if (value.hasLookupDescriptor) {
+        id cacheKey = _cachesLookups ? value.lookupCacheKey : nil;
+        if (!cacheKey) return [self evaluateKeys:value.lookupKeys count:value.lookupKeyCount parentLevels:value.parentLevels isDataValue:value.isDataValue propertyCaches:[value allocatePropertyCaches]];
+        
+        if (_lookupCache) {
+            id cachedValue = (id)CFDictionaryGetValue(_lookupCache, cacheKey);
+            if (cachedValue) return (cachedValue == hb_no_value) ? nil : cachedValue;
+        } else {
+            CFDictionaryKeyCallBacks keyCallBacks = { 0, kCFTypeDictionaryKeyCallBacks.retain, kCFTypeDictionaryKeyCallBacks.release, NULL, NULL, NULL };
+            _lookupCache = CFDictionaryCreateMutable(NULL, 0, &keyCallBacks, &kCFTypeDictionaryValueCallBacks);
+        }
+        
+        id result = [self evaluateKeys:value.lookupKeys count:value.lookupKeyCount parentLevels:value.parentLevels isDataValue:value.isDataValue propertyCaches:[value allocatePropertyCaches]];
+        CFDictionarySetValue(_lookupCache, cacheKey, result ? result : hb_no_value);
+        return result;
+    }
+    
     NSUInteger index = 0;
     id current = nil;
     NSArray* pathComponents = value.keyPath;
@@ -67,10 +115,10 @@
     HBContextState* startState = self;
 
     // consume "." components if any
-    if (pathComponents.count > 0 && ([[pathComponents[0] key] isEqualToString:@"this"] || [[pathComponents[0] key] isEqualToString:@"."])) index++;
+    if (pathComponents.count > 0 && [pathComponents[0] isCurrentContextReference]) index++;
     
     // consume ".." components if any
-    while (index < pathComponents.count && [[pathComponents[index] key] isEqualToString:@".."] && startState) {
+    while (index < pathComponents.count && [pathComponents[index] isParentContextReference] && startState) {
         index++;
         startState = startState.parent;
     }
@@ -97,6 +145,38 @@
     return current;
 }
 
+- (id) evaluateKeys:(NSString* const*)keys count:(NSUInteger)count parentLevels:(NSUInteger)parentLevels isDataValue:(BOOL)isDataValue
+{
+    return [self evaluateKeys:keys count:count parentLevels:parentLevels isDataValue:isDataValue propertyCaches:NULL];
+}
+
+- (id) evaluateKeys:(NSString* const*)keys count:(NSUInteger)count parentLevels:(NSUInteger)parentLevels isDataValue:(BOOL)isDataValue propertyCaches:(hb_property_cache*)propertyCaches
+{
+    NSUInteger index = 0;
+    HBContextState* startState = self;
+    
+    for (NSUInteger level = 0; level < parentLevels && startState; level++) {
+        startState = startState.parent;
+    }
+    if (!startState) return nil;
+    id current = startState.context;
+    
+    if (isDataValue) {
+        if (count == 0) return nil;
+        current = startState.dataContext ? startState.dataContext[keys[0]] : nil;
+        index++;
+    }
+    
+    BOOL atRootLevel = true;
+    while (index < count && current) {
+        current = [self valueForKey:keys[index] context:current includeMergedAttributes:atRootLevel cache:(propertyCaches ? &propertyCaches[index] : NULL)];
+        atRootLevel = false;
+        index++;
+    }
+    
+    return current;
+}
+
 - (HBDataContext*) dataContextCopyOrNew 
 {
     if (self.dataContext) return [self.dataContext copy];
@@ -111,6 +191,7 @@
     self.dataContext = nil;
     self.mergedAttributes = nil;
     self.parent = nil;
+    if (_lookupCache) CFRelease(_lookupCache);
     [super dealloc];
 }
 
@@ -28,9 +28,40 @@
 
 #import <Foundation/Foundation.h>
 
+// Inline cache of a lookup site, a key of a compiled key path: how the key was read on the classes of the
+// objects seen there, so that reading it again on objects of these classes skips resolving the access.
+// Entries are added, never changed, and published by their class: caches are shared by threads rendering
+// the same template without locking. Sites that see more classes than entries use the generic path.
+#define HB_PROPERTY_CACHE_SIZE 4
+
+typedef struct {
+    Class objectClass;
+    uint8_t kind;
+    SEL selector;
+    IMP accessor;
+} hb_property_cache_entry;
+
+typedef struct {
+    volatile NSUInteger count; // entries claimed, may exceed HB_PROPERTY_CACHE_SIZE
+    hb_property_cache_entry entries[HB_PROPERTY_CACHE_SIZE];
+} hb_property_cache;
+
 // Utility that checks access to values on contexts. 
 @interface HBObjectPropertyAccess : NSObject
 
 + (id) valueForKey:(NSString *)key onObject:(id)object;
 
+// Same as valueForKey:onObject:, through cache, which may be NULL
++ (id) valueForKey:(NSString *)key onObject:(id)object cache:(hb_property_cache*)cache;
+
+// Resolves key for objects of objectClass ahead of time, for instance from a profile of earlier renders
++ (void) addClass:(Class)objectClass toCache:(hb_property_cache*)cache forKey:(NSString*)key;
+
+// classes cache has entries for, none if cache is NULL
++ (NSArray*) classesInCache:(hb_property_cache*)cache;
+
+// The count caches slot points to, allocated by the first call: sites only pay for caches once they are looked up.
+// Threads allocating them at the same time agree on the caches published first.
++ (hb_property_cache*) cachesInSlot:(hb_property_cache**)slot count:(NSUInteger)count;
+
 @end
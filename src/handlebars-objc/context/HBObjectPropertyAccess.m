@@ -151,4 +151,165 @@
     return nil;
 }
 
+#pragma mark -
+#pragma mark Inline caches
+
+typedef NS_ENUM(uint8_t, HBPropertyAccessKind) {
+    HBPropertyAccessDictionary = 1, // CFDictionaryGetValue
+    HBPropertyAccessSubscript,      // objectForKeyedSubscript: implementation
+    HBPropertyAccessGetter,         // implementation of a getter returning an object
+    HBPropertyAccessKVC,            // valueForKey:, known to be allowed
+    HBPropertyAccessMissing,        // no value
+};
+
+static BOOL classInheritsFrom(Class objectClass, Class ancestor)
+{
+    for (Class class = objectClass; class; class = class_getSuperclass(class)) {
+        if (class == ancestor) return YES;
+    }
+    return NO;
+}
+
+// Resolves how valueForKey:onObject: reads key on objects of objectClass. Returns NO when it depends on the objects
+// rather than on their class.
++ (BOOL) resolveAccessToKey:(NSString*)key onClass:(Class)objectClass entry:(hb_property_cache_entry*)entry
+{
+    static Class managedObjectClass = nil;
+    static dispatch_once_t pred;
+    dispatch_once(&pred, ^{
+        managedObjectClass = NSClassFromString(@"NSManagedObject");
+    });
+    
+    // valid keys of managed objects depend on their entity
+    if (managedObjectClass && classInheritsFrom(objectClass, managedObjectClass)) return NO;
+    if (!classInheritsFrom(objectClass, [NSObject class])) return NO;
+    
+    SEL subscriptSelector = @selector(objectForKeyedSubscript:);
+    if (class_respondsToSelector(objectClass, subscriptSelector)) {
+        IMP subscript = class_getMethodImplementation(objectClass, subscriptSelector);
+        if (classInheritsFrom(objectClass, [NSDictionary class]) && subscript == class_getMethodImplementation([NSDictionary class], subscriptSelector)) {
+            entry->kind = HBPropertyAccessDictionary;
+        } else {
+            entry->kind = HBPropertyAccessSubscript;
+            entry->selector = subscriptSelector;
+            entry->accessor = subscript;
+        }
+        return YES;
+    }
+    
+    if (![[self validKeysForClass:objectClass] containsObject:key]) {
+        entry->kind = HBPropertyAccessMissing;
+        return YES;
+    }
+    
+    // getters can be called directly when they are what KVC would call, and return objects KVC would not box
+    entry->kind = HBPropertyAccessKVC;
+    SEL valueForKeySelector = @selector(valueForKey:);
+    if (class_getMethodImplementation(objectClass, valueForKeySelector) != class_getMethodImplementation([NSObject class], valueForKeySelector)) return YES;
+    if (key.length == 0) return YES;
+    
+    NSString* capitalizedKey = [[[key substringToIndex:1] uppercaseString] stringByAppendingString:[key substringFromIndex:1]];
+    if (class_respondsToSelector(objectClass, NSSelectorFromString([@"get" stringByAppendingString:capitalizedKey]))) return YES;
+    
+    SEL getter = NSSelectorFromString(key);
+    Method method = class_getInstanceMethod(objectClass, getter);
+    if (!method || method_getNumberOfArguments(method) != 2) return YES;
+    char returnType[2] = { 0 };
+    method_getReturnType(method, returnType, sizeof(returnType));
+    if (returnType[0] != '@') return YES;
+    
+    entry->kind = HBPropertyAccessGetter;
+    entry->selector = getter;
+    entry->accessor = method_getImplementation(method);
+    return YES;
+}
+
+// Claims an entry of cache for objectClass. Does nothing once the cache is full.
+static void addCacheEntry(hb_property_cache* cache, Class objectClass, const hb_property_cache_entry* resolved)
+{
+    if (cache->count >= HB_PROPERTY_CACHE_SIZE) return;
+    NSUInteger index = __sync_fetch_and_add(&cache->count, 1);
+    if (index >= HB_PROPERTY_CACHE_SIZE) return;
+    
+    hb_property_cache_entry* entry = &cache->entries[index];
+    entry->kind = resolved->kind;
+    entry->selector = resolved->selector;
+    entry->accessor = resolved->accessor;
+    __atomic_store_n(&entry->objectClass, objectClass, __ATOMIC_RELEASE);
+}
+
++ (id) valueForKey:(NSString *)key onObject:(id)object cache:(hb_property_cache*)cache
+{
+    if (!cache || !object) return [self valueForKey:key onObject:object];
+    
+    Class objectClass = object_getClass(object);
+    NSUInteger count = MIN(cache->count, (NSUInteger)HB_PROPERTY_CACHE_SIZE);
+    for (NSUInteger i = 0; i < count; i++) {
+        hb_property_cache_entry* entry = &cache->entries[i];
+        if (__atomic_load_n(&entry->objectClass, __ATOMIC_ACQUIRE) != objectClass) continue;
+        
+        switch ((HBPropertyAccessKind)entry->kind) {
+            case HBPropertyAccessDictionary:
+                return (id)CFDictionaryGetValue((CFDictionaryRef)object, key);
+            case HBPropertyAccessSubscript:
+                return ((id (*)(id, SEL, id))entry->accessor)(object, entry->selector, key);
+            case HBPropertyAccessGetter:
+                return ((id (*)(id, SEL))entry->accessor)(object, entry->selector);
+            case HBPropertyAccessKVC:
+                return [object valueForKey:key];
+            case HBPropertyAccessMissing:
+                return nil;
+        }
+    }
+    
+    // miss: resolve the access for next time, unless the object answers respondsToSelector: differently from its
+    // class, and read the value the generic way
+    if (cache->count < HB_PROPERTY_CACHE_SIZE) {
+        SEL subscriptSelector = @selector(objectForKeyedSubscript:);
+        hb_property_cache_entry resolved = { 0 };
+        if ([object respondsToSelector:subscriptSelector] == class_respondsToSelector(objectClass, subscriptSelector) && [self resolveAccessToKey:key onClass:objectClass entry:&resolved]) {
+            addCacheEntry(cache, objectClass, &resolved);
+        }
+    }
+    return [self valueForKey:key onObject:object];
+}
+
++ (void) addClass:(Class)objectClass toCache:(hb_property_cache*)cache forKey:(NSString*)key
+{
+    NSUInteger count = MIN(cache->count, (NSUInteger)HB_PROPERTY_CACHE_SIZE);
+    for (NSUInteger i = 0; i < count; i++) {
+        if (__atomic_load_n(&cache->entries[i].objectClass, __ATOMIC_ACQUIRE) == objectClass) return;
+    }
+    
+    // objects of classes overriding respondsToSelector: are checked when they are looked up instead
+    SEL respondsToSelector = @selector(respondsToSelector:);
+    if (class_getMethodImplementation(objectClass, respondsToSelector) != class_getMethodImplementation([NSObject class], respondsToSelector)) return;
+    
+    hb_property_cache_entry resolved = { 0 };
+    if ([self resolveAccessToKey:key onClass:objectClass entry:&resolved]) addCacheEntry(cache, objectClass, &resolved);
+}
+
++ (NSArray*) classesInCache:(hb_property_cache*)cache
+{
+    NSMutableArray* classes = [NSMutableArray array];
+    if (!cache) return classes;
+    NSUInteger count = MIN(cache->count, (NSUInteger)HB_PROPERTY_CACHE_SIZE);
+    for (NSUInteger i = 0; i < count; i++) {
+        Class objectClass = __atomic_load_n(&cache->entries[i].objectClass, __ATOMIC_ACQUIRE);
+        if (objectClass) [classes addObject:objectClass];
+    }
+    return classes;
+}
+
++ (hb_property_cache*) cachesInSlot:(hb_property_cache**)slot count:(NSUInteger)count
+{
+    hb_property_cache* caches = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (caches) return caches;
+    
+    hb_property_cache* allocated = calloc(count, sizeof(hb_property_cache));
+    if (__atomic_compare_exchange_n(slot, &caches, allocated, NO, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) return allocated;
+    free(allocated);
+    return caches;
+}
+
 @end
@@ -40,7 +40,9 @@ typedef NS_ENUM(NSInteger, HBErrorCode) {
     /** used when a helper referenced in a template doesn't exist */
     HBErrorCodeHelperMissingError   = 100,
     /** used when a partial references in a template doesn't exist */
-    HBErrorCodePartialMissingError  = 200
+    HBErrorCodePartialMissingError  = 200,
+    /** used when precompiled templates can't be loaded */
+    HBErrorCodeArchiveError         = 300
 };
 
 /**
@@ -28,9 +28,18 @@
 #import <Foundation/Foundation.h>
 #import "HBHelperRegistry.h"
 
+@class HBHelperCallingInfo;
+
 @interface HBBuiltinHelpersRegistry : HBHelperRegistry
 
 + (void) initialize;
 + (instancetype) builtinRegistry;
 
+// condition tested by 'if' and 'unless' helpers, given their first parameter and their 'includeZero' named parameter
++ (BOOL) evaluateCondition:(id)value includeZero:(id)includeZero;
+
+// comparison made by 'is', 'gt', 'gte', 'lt' and 'lte' helpers between their two positional parameters. comparisonValid is
+// NO when there are not two of them, or when they cannot be compared
++ (NSComparisonResult) compare2FirstPositionalParameters:(HBHelperCallingInfo*)callingInfo validity:(BOOL*)comparisonValid;
+
 @end
@@ -76,16 +76,19 @@ static HBBuiltinHelpersRegistry* _builtinHelpersRegistry = nil;
     [self registerEscapeBlock];
 }
 
-+ (BOOL) _firstParamEvaluatesToTrue:(HBHelperCallingInfo*) callingInfo
++ (BOOL) evaluateCondition:(id)value includeZero:(id)includeZeroValue
 {
-    id value = callingInfo[0];
-    
-    BOOL includeZero = [HBHelperUtils evaluateObjectAsBool:callingInfo[@"includeZero"]];
+    BOOL includeZero = [HBHelperUtils evaluateObjectAsBool:includeZeroValue];
     BOOL zeroAndIncludeZero = includeZero && value && [value isKindOfClass:[NSNumber class]] && ([value integerValue] == 0);
     
     return [HBHelperUtils evaluateObjectAsBool:value] || zeroAndIncludeZero;
 }
 
++ (BOOL) _firstParamEvaluatesToTrue:(HBHelperCallingInfo*) callingInfo
+{
+    return [self evaluateCondition:callingInfo[0] includeZero:callingInfo[@"includeZero"]];
+}
+
 + (void) registerIfBlock
 {
     HBHelperBlock ifBlock = ^(HBHelperCallingInfo* callingInfo) {
@@ -116,6 +116,24 @@
  */
 - (void) removeAllHelpers;
 
+/** @name Helper bindings */
+
+/**
+ Generation of the registry
+ 
+ Templates remember the helpers their mustaches resolve to. The generation changes each time a helper is added to or removed from the registry, so that these bindings are resolved again. Values come from a counter shared by all registries.
+ @since v1.5.0
+ */
+@property (readonly) NSUInteger generation;
+
+/**
+ Latest generation of all registries
+ 
+ Helper bindings made at this generation are valid as long as it does not change.
+ @since v1.5.0
+ */
++ (NSUInteger) currentGeneration;
+
 
 /** 
  Retrieve a helper by name using the objective-C keyed subscripting API
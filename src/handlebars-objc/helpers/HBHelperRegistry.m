@@ -26,12 +26,47 @@
 //
 
 #import "HBHelperRegistry.h"
+#import "HBHelperRegistry_Private.h"
 
 @interface HBHelperRegistry()
 @property (retain, nonatomic) NSMutableDictionary* helpers;
+@property (readwrite) NSUInteger generation;
 @end
 
+// shared by all registries, so that a single comparison tells whether any of them changed
+static volatile NSUInteger hb_helper_registry_generation = 1;
+
 @implementation HBHelperRegistry
+{
+    volatile NSUInteger _bindingToken;
+}
+
++ (NSUInteger) currentGeneration
+{
+    return hb_helper_registry_generation;
+}
+
++ (void) invalidateHelperBindings
+{
+    __sync_add_and_fetch(&hb_helper_registry_generation, 1);
+}
+
+- (NSUInteger) bindingToken
+{
+    return _bindingToken;
+}
+
+- (void) registryDidChange
+{
+    static volatile NSUInteger lastToken = 0;
+    
+    // before moving to a new generation, so that bindings made after it see the token
+    if (_bindingToken == 0) {
+        NSUInteger token = __sync_add_and_fetch(&lastToken, 1);
+        __sync_bool_compare_and_swap(&_bindingToken, 0, token);
+    }
+    self.generation = __sync_add_and_fetch(&hb_helper_registry_generation, 1);
+}
 
 + (instancetype) registry
 {
@@ -63,6 +98,7 @@
     @synchronized(self.helpers) {
         self.helpers[name] = helper;
     }
+    [self registryDidChange];
 }
 
 - (void) addHelpers:(NSDictionary*)helpers
@@ -77,6 +113,7 @@
     @synchronized(self.helpers) {
         [self.helpers removeObjectForKey:name];
     }
+    [self registryDidChange];
 }
 
 - (void) removeAllHelpers
@@ -84,6 +121,7 @@
     @synchronized(self.helpers) {
         [self.helpers removeAllObjects];
     }
+    [self registryDidChange];
 }
 
 // objc litteral compatibility
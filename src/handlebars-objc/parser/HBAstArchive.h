@@ -0,0 +1,68 @@
+//
+//  HBAstArchive.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class HBAstProgram;
+
+// Precompiled templates.
+//
+// Compiled programs are archived in a compact binary format, so that a fixed set of templates can be
+// compiled at build time and loaded at run time without running the lexer or the parser. An archive is:
+//
+//   header      "HBPC", format version (uint32), string pool offset and directory offset (uint64), little endian
+//   programs    one node stream per template or partial
+//   string pool UTF-8 bytes of all strings and raw text, each stored once
+//   directory   template and partial names, with the range of their node stream
+//
+// All other integers are LEB128 varints. Nodes are written in prefix order, a kind byte first, and refer to
+// strings by their range in the pool. Archives are meant to be mapped: loading one only reads the header and
+// the directory, each program is decoded the first time it is compiled, and raw text keeps pointing into the
+// mapped pool until its string value is needed.
+
+extern const uint32_t HBAstArchiveVersion;
+
+// A program in an archive, decoded on demand
+@interface HBArchivedProgram : NSObject
+
+@property (readonly, retain, nonatomic) NSData* archiveData;
+@property (readonly, nonatomic) NSRange range;
+
+// decodes a new program each time it is called
+- (HBAstProgram*) program:(NSError**)error;
+
+@end
+
+@interface HBAstArchive : NSObject
+
+// programs are keyed by name. Archived programs are used as is.
++ (NSData*) archivedDataWithTemplatePrograms:(NSDictionary* /* NSString -> HBAstProgram */)templatePrograms partialPrograms:(NSDictionary* /* NSString -> HBAstProgram */)partialPrograms;
+
+// Checks the header and reads the directory of an archive. Programs are not decoded.
++ (BOOL) readArchivedData:(NSData*)data templatePrograms:(NSDictionary** /* NSString -> HBArchivedProgram */)templatePrograms partialPrograms:(NSDictionary** /* NSString -> HBArchivedProgram */)partialPrograms error:(NSError**)error;
+
+@end
@@ -0,0 +1,689 @@
+//
+//  HBAstArchive.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstArchive.h"
+#import "HBAst.h"
+#import "HBAstParametersHash.h"
+#import "HBAstVisitor.h"
+#import "HBSymbolTable.h"
+#import "HBErrorHandling.h"
+
+const uint32_t HBAstArchiveVersion = 1;
+
+static const char HBAstArchiveMagic[4] = { 'H', 'B', 'P', 'C' };
+
+#define HB_ARCHIVE_HEADER_SIZE 24
+
+// Deeper nesting only comes from corrupted archives. Bounds recursion while decoding.
+#define HB_ARCHIVE_MAX_DEPTH 4096
+
+typedef NS_ENUM(uint8_t, HBAstArchiveNodeKind) {
+    HBAstArchiveNodeNone = 0,
+    HBAstArchiveNodeProgram,
+    HBAstArchiveNodeRawText,
+    HBAstArchiveNodeComment,
+    HBAstArchiveNodeTag,
+    HBAstArchiveNodeSimpleTag,
+    HBAstArchiveNodePartialTag,
+    HBAstArchiveNodeBlock,
+    HBAstArchiveNodeExpression,
+    HBAstArchiveNodeContextualValue,
+    HBAstArchiveNodeKeyPathComponent,
+    HBAstArchiveNodeString,
+    HBAstArchiveNodeInteger,
+    HBAstArchiveNodeFloat,
+    HBAstArchiveNodeBoolean,
+    HBAstArchiveNodeParametersHash
+};
+
+// tag flags
+#define HB_ARCHIVE_LEFT_WSC     1
+#define HB_ARCHIVE_RIGHT_WSC    2
+#define HB_ARCHIVE_ESCAPE       4
+
+static NSError* hb_archive_error(NSString* reason)
+{
+    NSString* description = [NSString stringWithFormat:@"Invalid precompiled template archive: %@", reason];
+    return [NSError errorWithDomain:HBErrorDomain code:HBErrorCodeArchiveError userInfo:@{ NSLocalizedDescriptionKey : description }];
+}
+
+#pragma mark -
+#pragma mark Writing
+
+// Every node starts with its kind and source span. Lists are written as their count + 1, nil as 0.
+@interface HBAstArchivingVisitor : HBAstVisitor
+
+@property (retain, nonatomic) NSMutableData* nodes;
+@property (retain, nonatomic) NSMutableData* strings;
+@property (retain, nonatomic) NSMutableDictionary* /* NSData -> NSNumber */ stringOffsets;
+
+@end
+
+@implementation HBAstArchivingVisitor
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        _nodes = [[NSMutableData alloc] init];
+        _strings = [[NSMutableData alloc] init];
+        _stringOffsets = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (void) writeVarint:(uint64_t)value
+{
+    uint8_t bytes[10];
+    NSUInteger length = 0;
+    do {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        bytes[length++] = byte | (value ? 0x80 : 0);
+    } while (value);
+    [self.nodes appendBytes:bytes length:length];
+}
+
+// Strings are stored once in the pool, and written as their length + 1 and their offset in the pool. nil is written as 0.
+- (void) writeBytes:(NSData*)bytes
+{
+    if (!bytes) {
+        [self writeVarint:0];
+        return;
+    }
+    
+    NSNumber* offset = self.stringOffsets[bytes];
+    if (!offset) {
+        offset = @(self.strings.length);
+        [self.strings appendData:bytes];
+        self.stringOffsets[bytes] = offset;
+    }
+    [self writeVarint:bytes.length + 1];
+    [self writeVarint:[offset unsignedLongLongValue]];
+}
+
+- (void) writeString:(NSString*)string
+{
+    [self writeBytes:[string dataUsingEncoding:NSUTF8StringEncoding allowLossyConversion:YES]];
+}
+
+- (void) writeKind:(HBAstArchiveNodeKind)kind ofNode:(HBAstNode*)node
+{
+    [self.nodes appendBytes:&kind length:1];
+    [self writeVarint:node.sourceSpan.location];
+    [self writeVarint:node.sourceSpan.length];
+}
+
+- (void) writeNode:(HBAstNode*)node
+{
+    if (node) {
+        [self visitNode:node];
+    } else {
+        HBAstArchiveNodeKind kind = HBAstArchiveNodeNone;
+        [self.nodes appendBytes:&kind length:1];
+    }
+}
+
+- (void) writeNodes:(NSArray*)nodes
+{
+    if (!nodes) {
+        [self writeVarint:0];
+        return;
+    }
+    
+    [self writeVarint:nodes.count + 1];
+    for (HBAstNode* node in nodes) {
+        [self visitNode:node];
+    }
+}
+
+- (void) writeTag:(HBAstTag*)tag kind:(HBAstArchiveNodeKind)kind flags:(uint64_t)flags
+{
+    [self writeKind:kind ofNode:tag];
+    if (tag.left_wsc) flags |= HB_ARCHIVE_LEFT_WSC;
+    if (tag.right_wsc) flags |= HB_ARCHIVE_RIGHT_WSC;
+    [self writeVarint:flags];
+    [self writeNode:tag.expression];
+}
+
+#pragma mark High-level nodes
+
+- (id) visitBlock:(HBAstBlock*)node
+{
+    [self writeKind:HBAstArchiveNodeBlock ofNode:node];
+    [self writeVarint:node.invertedBlock ? 1 : 0];
+    [self writeNode:node.openTag];
+    [self writeNode:node.elseTag];
+    [self writeNode:node.closeTag];
+    [self writeNodes:node.statements];
+    [self writeNodes:node.inverseStatements];
+    return nil;
+}
+
+- (id) visitComment:(HBAstComment*)node
+{
+    [self writeKind:HBAstArchiveNodeComment ofNode:node];
+    [self writeString:node.litteralValue];
+    return nil;
+}
+
+- (id) visitPartialTag:(HBAstPartialTag*)node
+{
+    [self writeTag:node kind:HBAstArchiveNodePartialTag flags:0];
+    [self writeNode:node.partialName];
+    [self writeNode:node.context];
+    [self writeNode:node.namedParameters];
+    return nil;
+}
+
+- (id) visitProgram:(HBAstProgram*)node
+{
+    [self writeKind:HBAstArchiveNodeProgram ofNode:node];
+    [self writeNodes:node.statements];
+    return nil;
+}
+
+- (id) visitRawText:(HBAstRawText*)node
+{
+    [self writeKind:HBAstArchiveNodeRawText ofNode:node];
+    // text still pointing into its template is copied as is, without materializing its string value
+    if (node.sourceBuffer) {
+        [self writeBytes:[node.sourceBuffer subdataWithRange:node.sourceRange]];
+    } else {
+        [self writeString:node.litteralValue];
+    }
+    return nil;
+}
+
+- (id) visitSimpleTag:(HBAstSimpleTag*)node
+{
+    [self writeTag:node kind:HBAstArchiveNodeSimpleTag flags:node.escape ? HB_ARCHIVE_ESCAPE : 0];
+    return nil;
+}
+
+- (id) visitTag:(HBAstTag*)node
+{
+    [self writeTag:node kind:HBAstArchiveNodeTag flags:0];
+    return nil;
+}
+
+#pragma mark Expressions
+
+- (id) visitContextualValue:(HBAstContextualValue*)node
+{
+    [self writeKind:HBAstArchiveNodeContextualValue ofNode:node];
+    [self writeVarint:node.isDataValue ? 1 : 0];
+    [self writeNodes:node.keyPath];
+    return nil;
+}
+
+- (id) visitExpression:(HBAstExpression*)node
+{
+    [self writeKind:HBAstArchiveNodeExpression ofNode:node];
+    [self writeNode:node.mainValue];
+    [self writeNodes:node.positionalParameters];
+    [self writeNode:node.namedParameters];
+    return nil;
+}
+
+- (id) visitKeyPathComponent:(HBAstKeyPathComponent*)node
+{
+    [self writeKind:HBAstArchiveNodeKeyPathComponent ofNode:node];
+    [self writeString:node.key];
+    [self writeString:node.leadingSeparator];
+    return nil;
+}
+
+- (id) visitNumber:(HBAstNumber*)node
+{
+    // the value itself is archived, so that numbers don't depend on how their source representation is parsed
+    const char* type = [node.litteralValue objCType];
+    if (node.isBoolean) {
+        [self writeKind:HBAstArchiveNodeBoolean ofNode:node];
+        [self writeVarint:[node.litteralValue boolValue] ? 1 : 0];
+    } else if (type && (type[0] == 'd' || type[0] == 'f')) {
+        [self writeKind:HBAstArchiveNodeFloat ofNode:node];
+        double value = [node.litteralValue doubleValue];
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        [self writeVarint:bits];
+    } else {
+        [self writeKind:HBAstArchiveNodeInteger ofNode:node];
+        int64_t value = [node.litteralValue longLongValue];
+        [self writeVarint:((uint64_t)value << 1) ^ (uint64_t)(value >> 63)]; // zigzag encoding keeps small negative values short
+    }
+    [self writeString:node.sourceRepresentation];
+    return nil;
+}
+
+- (id) visitString:(HBAstString*)node
+{
+    [self writeKind:HBAstArchiveNodeString ofNode:node];
+    [self writeString:node.litteralValue];
+    [self writeString:node.sourceRepresentation];
+    return nil;
+}
+
+- (id) visitValue:(HBAstValue*)node
+{
+    NSAssert(false, @"abstract values are never part of an AST");
+    return nil;
+}
+
+- (id) visitParametersHash:(HBAstParametersHash*)node
+{
+    [self writeKind:HBAstArchiveNodeParametersHash ofNode:node];
+    [self writeVarint:node.count];
+    for (NSString* name in node) {
+        [self writeString:name];
+        [self writeNode:node[name]];
+    }
+    return nil;
+}
+
+#pragma mark -
+
+- (void) dealloc
+{
+    self.nodes = nil;
+    self.strings = nil;
+    self.stringOffsets = nil;
+    [super dealloc];
+}
+
+@end
+
+#pragma mark -
+#pragma mark Reading
+
+typedef struct hb_archive_reader {
+    NSData* data;
+    const uint8_t* bytes;
+    NSUInteger position;
+    NSUInteger end;
+    NSRange pool;
+    NSUInteger depth;
+    BOOL failed;
+} hb_archive_reader;
+
+static uint64_t hb_archive_read_varint(hb_archive_reader* reader)
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64 && reader->position < reader->end; shift += 7) {
+        uint8_t byte = reader->bytes[reader->position++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    reader->failed = YES;
+    return 0;
+}
+
+// range of a string in the archive. Location is NSNotFound for nil.
+static NSRange hb_archive_read_string_range(hb_archive_reader* reader)
+{
+    uint64_t length = hb_archive_read_varint(reader);
+    if (length == 0) return NSMakeRange(NSNotFound, 0);
+    length--;
+    
+    uint64_t offset = hb_archive_read_varint(reader);
+    if (reader->failed || offset > reader->pool.length || length > reader->pool.length - offset) {
+        reader->failed = YES;
+        return NSMakeRange(NSNotFound, 0);
+    }
+    return NSMakeRange(reader->pool.location + (NSUInteger)offset, (NSUInteger)length);
+}
+
+static NSString* hb_archive_read_string(hb_archive_reader* reader, BOOL symbol)
+{
+    NSRange range = hb_archive_read_string_range(reader);
+    if (range.location == NSNotFound) return nil;
+    
+    const char* bytes = (const char*)reader->bytes + range.location;
+    NSString* string = symbol ? [HBSymbolTable symbolWithUTF8Bytes:bytes length:range.length] : [[[NSString alloc] initWithBytes:bytes length:range.length encoding:NSUTF8StringEncoding] autorelease];
+    if (!string) reader->failed = YES;
+    return string;
+}
+
+static HBAstNode* hb_archive_read_node(hb_archive_reader* reader, Class expectedClass);
+
+static NSMutableArray* hb_archive_read_nodes(hb_archive_reader* reader, Class expectedClass)
+{
+    uint64_t count = hb_archive_read_varint(reader);
+    if (count == 0 || reader->failed) return nil;
+    count--;
+    
+    // each node takes one byte at least
+    if (count > reader->end - reader->position) {
+        reader->failed = YES;
+        return nil;
+    }
+    
+    NSMutableArray* nodes = [NSMutableArray arrayWithCapacity:(NSUInteger)count];
+    for (uint64_t i = 0; i < count && !reader->failed; i++) {
+        HBAstNode* node = hb_archive_read_node(reader, expectedClass);
+        if (node) [nodes addObject:node]; else reader->failed = YES;
+    }
+    return nodes;
+}
+
+static void hb_archive_read_tag(hb_archive_reader* reader, HBAstTag* tag, uint64_t* flags)
+{
+    *flags = hb_archive_read_varint(reader);
+    tag.left_wsc = (*flags & HB_ARCHIVE_LEFT_WSC) != 0;
+    tag.right_wsc = (*flags & HB_ARCHIVE_RIGHT_WSC) != 0;
+    tag.expression = (HBAstExpression*)hb_archive_read_node(reader, [HBAstExpression class]);
+}
+
+// Returns nil for a nil node, or when decoding fails. Nodes must be of expectedClass.
+static HBAstNode* hb_archive_read_node(hb_archive_reader* reader, Class expectedClass)
+{
+    if (reader->failed || reader->position >= reader->end || reader->depth >= HB_ARCHIVE_MAX_DEPTH) {
+        reader->failed = YES;
+        return nil;
+    }
+    
+    HBAstArchiveNodeKind kind = reader->bytes[reader->position++];
+    if (kind == HBAstArchiveNodeNone) return nil;
+    
+    reader->depth++;
+    NSUInteger location = (NSUInteger)hb_archive_read_varint(reader);
+    NSUInteger length = (NSUInteger)hb_archive_read_varint(reader);
+    
+    HBAstNode* node = nil;
+    uint64_t flags = 0;
+    switch (kind) {
+        case HBAstArchiveNodeProgram: {
+            HBAstProgram* program = [[HBAstProgram new] autorelease];
+            program.statements = hb_archive_read_nodes(reader, [HBAstNode class]);
+            node = program;
+            break;
+        }
+        case HBAstArchiveNodeRawText: {
+            // raw text points into the archive until its value is needed
+            HBAstRawText* rawText = [[HBAstRawText new] autorelease];
+            NSRange range = hb_archive_read_string_range(reader);
+            if (range.location != NSNotFound) [rawText setSourceBuffer:reader->data range:range];
+            node = rawText;
+            break;
+        }
+        case HBAstArchiveNodeComment: {
+            HBAstComment* comment = [[HBAstComment new] autorelease];
+            comment.litteralValue = hb_archive_read_string(reader, NO);
+            node = comment;
+            break;
+        }
+        case HBAstArchiveNodeTag: {
+            HBAstTag* tag = [[HBAstTag new] autorelease];
+            hb_archive_read_tag(reader, tag, &flags);
+            node = tag;
+            break;
+        }
+        case HBAstArchiveNodeSimpleTag: {
+            HBAstSimpleTag* tag = [[HBAstSimpleTag new] autorelease];
+            hb_archive_read_tag(reader, tag, &flags);
+            tag.escape = (flags & HB_ARCHIVE_ESCAPE) != 0;
+            node = tag;
+            break;
+        }
+        case HBAstArchiveNodePartialTag: {
+            HBAstPartialTag* tag = [[HBAstPartialTag new] autorelease];
+            hb_archive_read_tag(reader, tag, &flags);
+            tag.partialName = (HBAstValue*)hb_archive_read_node(reader, [HBAstValue class]);
+            tag.context = (HBAstContextualValue*)hb_archive_read_node(reader, [HBAstContextualValue class]);
+            tag.namedParameters = (HBAstParametersHash*)hb_archive_read_node(reader, [HBAstParametersHash class]);
+            node = tag;
+            break;
+        }
+        case HBAstArchiveNodeBlock: {
+            HBAstBlock* block = [[HBAstBlock new] autorelease];
+            block.invertedBlock = (hb_archive_read_varint(reader) != 0);
+            block.openTag = (HBAstTag*)hb_archive_read_node(reader, [HBAstTag class]);
+            block.elseTag = (HBAstTag*)hb_archive_read_node(reader, [HBAstTag class]);
+            block.closeTag = (HBAstTag*)hb_archive_read_node(reader, [HBAstTag class]);
+            block.statements = hb_archive_read_nodes(reader, [HBAstNode class]);
+            block.inverseStatements = hb_archive_read_nodes(reader, [HBAstNode class]);
+            node = block;
+            break;
+        }
+        case HBAstArchiveNodeExpression: {
+            HBAstExpression* expression = [[HBAstExpression new] autorelease];
+            expression.mainValue = (HBAstContextualValue*)hb_archive_read_node(reader, [HBAstContextualValue class]);
+            expression.positionalParameters = hb_archive_read_nodes(reader, [HBAstValue class]);
+            expression.namedParameters = (HBAstParametersHash*)hb_archive_read_node(reader, [HBAstParametersHash class]);
+            node = expression;
+            break;
+        }
+        case HBAstArchiveNodeContextualValue: {
+            HBAstContextualValue* value = [[HBAstContextualValue new] autorelease];
+            value.isDataValue = (hb_archive_read_varint(reader) != 0);
+            value.keyPath = hb_archive_read_nodes(reader, [HBAstKeyPathComponent class]);
+            node = value;
+            break;
+        }
+        case HBAstArchiveNodeKeyPathComponent: {
+            HBAstKeyPathComponent* component = [[HBAstKeyPathComponent new] autorelease];
+            component.key = hb_archive_read_string(reader, YES);
+            component.leadingSeparator = hb_archive_read_string(reader, YES);
+            node = component;
+            break;
+        }
+        case HBAstArchiveNodeString: {
+            HBAstString* string = [[HBAstString new] autorelease];
+            string.litteralValue = hb_archive_read_string(reader, NO);
+            string.sourceRepresentation = hb_archive_read_string(reader, NO);
+            node = string;
+            break;
+        }
+        case HBAstArchiveNodeInteger:
+        case HBAstArchiveNodeFloat:
+        case HBAstArchiveNodeBoolean: {
+            HBAstNumber* number = [[HBAstNumber new] autorelease];
+            uint64_t value = hb_archive_read_varint(reader);
+            if (kind == HBAstArchiveNodeBoolean) {
+                number.litteralValue = value ? @YES : @NO;
+                number.isBoolean = YES;
+            } else if (kind == HBAstArchiveNodeFloat) {
+                double doubleValue;
+                memcpy(&doubleValue, &value, sizeof(doubleValue));
+                number.litteralValue = [NSNumber numberWithDouble:doubleValue];
+            } else {
+                number.litteralValue = [NSNumber numberWithLongLong:(int64_t)(value >> 1) ^ -(int64_t)(value & 1)];
+            }
+            number.sourceRepresentation = hb_archive_read_string(reader, NO);
+            node = number;
+            break;
+        }
+        case HBAstArchiveNodeParametersHash: {
+            HBAstParametersHash* hash = [[HBAstParametersHash new] autorelease];
+            uint64_t count = hb_archive_read_varint(reader);
+            for (uint64_t i = 0; i < count && !reader->failed; i++) {
+                NSString* name = hb_archive_read_string(reader, YES);
+                HBAstValue* value = (HBAstValue*)hb_archive_read_node(reader, [HBAstValue class]);
+                if (name && value) [hash appendParameter:value forKey:name]; else reader->failed = YES;
+            }
+            node = hash;
+            break;
+        }
+        default:
+            reader->failed = YES;
+            break;
+    }
+    
+    reader->depth--;
+    if (node && ![node isKindOfClass:expectedClass]) reader->failed = YES;
+    if (reader->failed) return nil;
+    
+    node.sourceSpan = NSMakeRange(location, length);
+    return node;
+}
+
+#pragma mark -
+
+@interface HBArchivedProgram ()
+
+@property (readwrite, retain, nonatomic) NSData* archiveData;
+@property (readwrite, nonatomic) NSRange range;
+@property (nonatomic) NSRange poolRange;
+
+@end
+
+@implementation HBArchivedProgram
+
+- (HBAstProgram*) program:(NSError**)error
+{
+    hb_archive_reader reader = { self.archiveData, [self.archiveData bytes], self.range.location, NSMaxRange(self.range), self.poolRange, 0, NO };
+    HBAstProgram* program = (HBAstProgram*)hb_archive_read_node(&reader, [HBAstProgram class]);
+    if (!program || reader.position != reader.end) {
+        if (error) *error = hb_archive_error(@"corrupted program");
+        return nil;
+    }
+    return program;
+}
+
+- (void) dealloc
+{
+    self.archiveData = nil;
+    [super dealloc];
+}
+
+@end
+
+#pragma mark -
+
+@implementation HBAstArchive
+
++ (NSData*) archivedDataWithTemplatePrograms:(NSDictionary*)templatePrograms partialPrograms:(NSDictionary*)partialPrograms
+{
+    HBAstArchivingVisitor* visitor = [[HBAstArchivingVisitor alloc] init];
+    
+    // programs, in name order so that archives of the same templates are identical
+    NSMutableArray* directory = [NSMutableArray array];
+    for (NSDictionary* programs in @[ templatePrograms ? templatePrograms : @{}, partialPrograms ? partialPrograms : @{} ]) {
+        NSMutableArray* entries = [NSMutableArray array];
+        for (NSString* name in [[programs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+            NSUInteger offset = visitor.nodes.length;
+            [visitor visitNode:programs[name]];
+            [entries addObject:@[ name, @(HB_ARCHIVE_HEADER_SIZE + offset), @(visitor.nodes.length - offset) ]];
+        }
+        [directory addObject:entries];
+    }
+    
+    // directory, written after the programs, then moved after the string pool
+    NSUInteger directoryStart = visitor.nodes.length;
+    [visitor writeVarint:[directory[0] count]];
+    [visitor writeVarint:[directory[1] count]];
+    for (NSArray* entries in directory) {
+        for (NSArray* entry in entries) {
+            [visitor writeString:entry[0]];
+            [visitor writeVarint:[entry[1] unsignedLongLongValue]];
+            [visitor writeVarint:[entry[2] unsignedLongLongValue]];
+        }
+    }
+    
+    uint64_t poolOffset = HB_ARCHIVE_HEADER_SIZE + directoryStart;
+    uint64_t directoryOffset = poolOffset + visitor.strings.length;
+    uint32_t version = NSSwapHostIntToLittle(HBAstArchiveVersion);
+    uint64_t littleEndianPoolOffset = NSSwapHostLongLongToLittle(poolOffset);
+    uint64_t littleEndianDirectoryOffset = NSSwapHostLongLongToLittle(directoryOffset);
+    
+    NSMutableData* data = [NSMutableData dataWithCapacity:(NSUInteger)directoryOffset + visitor.nodes.length - directoryStart];
+    [data appendBytes:HBAstArchiveMagic length:sizeof(HBAstArchiveMagic)];
+    [data appendBytes:&version length:sizeof(version)];
+    [data appendBytes:&littleEndianPoolOffset length:sizeof(littleEndianPoolOffset)];
+    [data appendBytes:&littleEndianDirectoryOffset length:sizeof(littleEndianDirectoryOffset)];
+    [data appendBytes:[visitor.nodes bytes] length:directoryStart];
+    [data appendData:visitor.strings];
+    [data appendBytes:(const char*)[visitor.nodes bytes] + directoryStart length:visitor.nodes.length - directoryStart];
+    
+    [visitor release];
+    return data;
+}
+
++ (BOOL) readArchivedData:(NSData*)data templatePrograms:(NSDictionary**)templatePrograms partialPrograms:(NSDictionary**)partialPrograms error:(NSError**)error
+{
+    const uint8_t* bytes = [data bytes];
+    NSUInteger length = [data length];
+    if (length < HB_ARCHIVE_HEADER_SIZE || memcmp(bytes, HBAstArchiveMagic, sizeof(HBAstArchiveMagic)) != 0) {
+        if (error) *error = hb_archive_error(@"not a precompiled template archive");
+        return NO;
+    }
+    
+    uint32_t version;
+    uint64_t poolOffset, directoryOffset;
+    memcpy(&version, bytes + 4, sizeof(version));
+    memcpy(&poolOffset, bytes + 8, sizeof(poolOffset));
+    memcpy(&directoryOffset, bytes + 16, sizeof(directoryOffset));
+    version = NSSwapLittleIntToHost(version);
+    poolOffset = NSSwapLittleLongLongToHost(poolOffset);
+    directoryOffset = NSSwapLittleLongLongToHost(directoryOffset);
+    
+    if (version != HBAstArchiveVersion) {
+        if (error) *error = hb_archive_error([NSString stringWithFormat:@"format version %u, expected %u. Templates must be precompiled again.", version, HBAstArchiveVersion]);
+        return NO;
+    }
+    if (poolOffset < HB_ARCHIVE_HEADER_SIZE || poolOffset > directoryOffset || directoryOffset > length) {
+        if (error) *error = hb_archive_error(@"corrupted header");
+        return NO;
+    }
+    
+    NSRange pool = NSMakeRange((NSUInteger)poolOffset, (NSUInteger)(directoryOffset - poolOffset));
+    hb_archive_reader reader = { data, bytes, (NSUInteger)directoryOffset, length, pool, 0, NO };
+    uint64_t counts[2];
+    counts[0] = hb_archive_read_varint(&reader);
+    counts[1] = hb_archive_read_varint(&reader);
+    
+    NSMutableDictionary* programs[2] = { [NSMutableDictionary dictionary], [NSMutableDictionary dictionary] };
+    for (NSUInteger i = 0; i < 2; i++) {
+        for (uint64_t j = 0; j < counts[i] && !reader.failed; j++) {
+            NSString* name = hb_archive_read_string(&reader, NO);
+            uint64_t offset = hb_archive_read_varint(&reader);
+            uint64_t programLength = hb_archive_read_varint(&reader);
+            if (!name || offset < HB_ARCHIVE_HEADER_SIZE || offset > poolOffset || programLength > poolOffset - offset) {
+                reader.failed = YES;
+                break;
+            }
+            
+            HBArchivedProgram* program = [[HBArchivedProgram alloc] init];
+            program.archiveData = data;
+            program.range = NSMakeRange((NSUInteger)offset, (NSUInteger)programLength);
+            program.poolRange = pool;
+            programs[i][name] = program;
+            [program release];
+        }
+    }
+    
+    if (reader.failed) {
+        if (error) *error = hb_archive_error(@"corrupted directory");
+        return NO;
+    }
+    
+    if (templatePrograms) *templatePrograms = programs[0];
+    if (partialPrograms) *partialPrograms = programs[1];
+    return YES;
+}
+
+@end
@@ -29,8 +29,43 @@
 
 @class HBAstProgram;
 
+// Two interchangeable parser implementations build the same AST.
+typedef NS_ENUM(NSInteger, HBParserImplementation) {
+    HBParserImplementationFlexBison,        // flex scanner and bison parser generated from handlebars-objc.lm and handlebars-objc.ym
+    HBParserImplementationRecursiveDescent  // hand-written single-pass recursive descent parser
+};
+
+// HBParser is safe for concurrent use: every call to astFromString:error: runs its own
+// reentrant scanner and parser, and no lexer or parser state is shared between calls.
+// Templates can thus be compiled in parallel from any number of threads.
+
 @interface HBParser : NSObject
 
+// parse using the default implementation
 + (HBAstProgram*)astFromString:(NSString*)text error:(NSError**)error;
 
++ (HBAstProgram*)astFromString:(NSString*)text implementation:(HBParserImplementation)implementation error:(NSError**)error;
+
+// Parse UTF-8 input without ever holding the template as an NSString. Bytes are handed to the flex/bison
+// parser in chunks as they are read, and the AST keeps the bytes it refers to: a mapped file is not copied,
+// and bytes read from a file descriptor or a stream are only stored once.
++ (HBAstProgram*)astFromUTF8Data:(NSData*)data error:(NSError**)error;
++ (HBAstProgram*)astFromContentsOfFile:(NSString*)path error:(NSError**)error; // the file is mapped
++ (HBAstProgram*)astFromFileDescriptor:(int)fd error:(NSError**)error; // reads until end of file, does not close fd
++ (HBAstProgram*)astFromInputStream:(NSInputStream*)stream error:(NSError**)error; // opens and closes the stream if not open yet
+
+// Read a file descriptor or a stream to its end, for sources that can only be read once. Returns nil and sets error if reading fails.
++ (NSData*)dataFromFileDescriptor:(int)fd error:(NSError**)error; // does not close fd
++ (NSData*)dataFromInputStream:(NSInputStream*)stream error:(NSError**)error; // opens and closes the stream if not open yet
+
+// Incremental parsing, for templates edited live. source is the UTF-8 template program was parsed from. Returns the program
+// for source with the bytes in range replaced by replacement: only the top-level statements around the edit are parsed again,
+// and the others are shared with program. reparsedStatements is set to the range of the new statements, whose whitespace
+// control is applied like the others. When the edit changes the block structure around it, the whole template is parsed again.
++ (HBAstProgram*)astByReplacingBytesInRange:(NSRange)range withBytes:(NSData*)replacement inProgram:(HBAstProgram*)program source:(NSData*)source reparsedStatements:(NSRange*)reparsedStatements error:(NSError**)error;
+
+// implementation used by astFromString:error:. HBParserImplementationFlexBison unless changed.
++ (HBParserImplementation) defaultImplementation;
++ (void) setDefaultImplementation:(HBParserImplementation)implementation;
+
 @end
@@ -29,35 +29,295 @@
 #import "HBAst.h"
 #import "HBHandlebars.h"
 #import "HBErrorHandling_Private.h"
+#include <unistd.h>
+#include <errno.h>
 
 
+typedef NSInteger (^hb_input_reader)(char* buffer, NSUInteger maxLength, NSError** error);
+
 extern id astFromString(NSString* text, NSError** error);
+extern id astFromStringWithRecursiveDescent(NSString* text, NSError** error);
+extern id astFromUTF8Data(NSData* data, NSError** error);
+extern id astFromUTF8Reader(hb_input_reader reader, NSData** source, NSError** error);
 
-extern int hb_column;
+static HBParserImplementation _defaultImplementation = HBParserImplementationFlexBison;
 
 @implementation HBParser
 
++ (HBParserImplementation) defaultImplementation
+{
+    return _defaultImplementation;
+}
+
++ (void) setDefaultImplementation:(HBParserImplementation)implementation
+{
+    _defaultImplementation = implementation;
+}
+
 + (HBAstProgram*)astFromString:(NSString*)text error:(NSError **)error
+{
+    return [self astFromString:text implementation:_defaultImplementation error:error];
+}
+
++ (HBAstProgram*)astFromString:(NSString*)text implementation:(HBParserImplementation)implementation error:(NSError **)error
 {
     HBAstProgram* program = nil;
-    
-    hb_column = 1;
 
     NSError* lowerLevelError = nil;
-    program = astFromString(text, &lowerLevelError);
+    if (implementation == HBParserImplementationRecursiveDescent) {
+        program = astFromStringWithRecursiveDescent(text, &lowerLevelError);
+    } else {
+        program = astFromString(text, &lowerLevelError);
+    }
     
     if (lowerLevelError == nil) return program;
     
-    // everything from now on is error handling
-    if ([lowerLevelError isKindOfClass:[HBParseError class]]) {
-        HBParseError* parseError = (HBParseError*)lowerLevelError;
-    
-        NSInteger pos = parseError.positionInBuffer;
+    lowerLevelError = [self reportedError:lowerLevelError context:^(NSInteger pos) {
         NSInteger posMin = MAX(0, pos - 30);
         NSInteger posMax = MIN(pos + 30, [text length] - 1);
+        return [text substringWithRange:NSMakeRange(posMin, posMax - posMin)];
+    }];
+    
+    if (error) *error = lowerLevelError;
+    return nil;
+}
+
+#pragma mark -
+#pragma mark Parsing UTF-8 input
+
+static hb_input_reader fileDescriptorReader(int fd)
+{
+    return [[^NSInteger(char* buffer, NSUInteger maxLength, NSError** readError) {
+        ssize_t length;
+        do {
+            length = read(fd, buffer, maxLength);
+        } while (length < 0 && errno == EINTR);
+        if (length < 0) *readError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        return length;
+    } copy] autorelease];
+}
+
+static hb_input_reader inputStreamReader(NSInputStream* stream)
+{
+    return [[^NSInteger(char* buffer, NSUInteger maxLength, NSError** readError) {
+        NSInteger length = [stream read:(uint8_t*)buffer maxLength:maxLength];
+        if (length < 0) *readError = [stream streamError] ? [stream streamError] : [NSError errorWithDomain:NSPOSIXErrorDomain code:EIO userInfo:nil];
+        return length;
+    } copy] autorelease];
+}
+
+// opens the stream if not open yet, returns whether it was opened
+static BOOL openStream(NSInputStream* stream)
+{
+    if ([stream streamStatus] != NSStreamStatusNotOpen) return NO;
+    [stream open];
+    return YES;
+}
+
+// Text of a UTF-8 buffer around a byte position, extended to character boundaries
+static NSString* contextInUTF8Data(NSData* data, NSInteger pos)
+{
+    const unsigned char* bytes = [data bytes];
+    NSInteger length = [data length];
+    NSInteger posMin = MAX(0, MIN(pos - 30, length));
+    NSInteger posMax = MAX(posMin, MIN(pos + 30, length));
+    while (posMin > 0 && (bytes[posMin] & 0xC0) == 0x80) posMin--;
+    while (posMax < length && (bytes[posMax] & 0xC0) == 0x80) posMax++;
+    
+    NSString* context = [[[NSString alloc] initWithBytes:bytes + posMin length:posMax - posMin encoding:NSUTF8StringEncoding] autorelease];
+    return context ? context : @"";
+}
+
++ (HBAstProgram*)astFromUTF8Data:(NSData*)data error:(NSError**)error
+{
+    NSError* lowerLevelError = nil;
+    HBAstProgram* program = astFromUTF8Data(data, &lowerLevelError);
+    if (lowerLevelError == nil) return program;
+    
+    lowerLevelError = [self reportedError:lowerLevelError context:^(NSInteger pos) { return contextInUTF8Data(data, pos); }];
+    if (error) *error = lowerLevelError;
+    return nil;
+}
+
++ (HBAstProgram*)astFromContentsOfFile:(NSString*)path error:(NSError**)error
+{
+    NSData* data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:error];
+    if (!data) return nil;
+    
+    return [self astFromUTF8Data:data error:error];
+}
+
++ (HBAstProgram*)astFromReader:(hb_input_reader)reader error:(NSError**)error
+{
+    NSError* lowerLevelError = nil;
+    NSData* source = nil;
+    HBAstProgram* program = astFromUTF8Reader(reader, &source, &lowerLevelError);
+    if (lowerLevelError == nil) return program;
+    
+    lowerLevelError = [self reportedError:lowerLevelError context:^(NSInteger pos) { return contextInUTF8Data(source, pos); }];
+    if (error) *error = lowerLevelError;
+    return nil;
+}
+
++ (HBAstProgram*)astFromFileDescriptor:(int)fd error:(NSError**)error
+{
+    return [self astFromReader:fileDescriptorReader(fd) error:error];
+}
+
++ (HBAstProgram*)astFromInputStream:(NSInputStream*)stream error:(NSError**)error
+{
+    BOOL opened = openStream(stream);
+    HBAstProgram* program = [self astFromReader:inputStreamReader(stream) error:error];
+    if (opened) [stream close];
+    return program;
+}
+
++ (NSData*)dataFromReader:(hb_input_reader)reader error:(NSError**)error
+{
+    NSMutableData* data = [NSMutableData data];
+    char buffer[16384];
+    NSInteger length;
+    NSError* readError = nil;
+    while ((length = reader(buffer, sizeof(buffer), &readError)) > 0) [data appendBytes:buffer length:length];
+    
+    if (length < 0) {
+        if (error) *error = readError;
+        return nil;
+    }
+    return data;
+}
+
++ (NSData*)dataFromFileDescriptor:(int)fd error:(NSError**)error
+{
+    return [self dataFromReader:fileDescriptorReader(fd) error:error];
+}
+
++ (NSData*)dataFromInputStream:(NSInputStream*)stream error:(NSError**)error
+{
+    BOOL opened = openStream(stream);
+    NSData* data = [self dataFromReader:inputStreamReader(stream) error:error];
+    if (opened) [stream close];
+    return data;
+}
+
+#pragma mark -
+#pragma mark Incremental parsing
+
+static inline NSRange statementSpan(HBAstProgram* program, NSUInteger index)
+{
+    NSRange span = [(HBAstNode*)program.statements[index] sourceSpan];
+    span.location += [program sourceOffsetOfStatementAtIndex:index];
+    return span;
+}
+
+// tag of a statement facing raw text on one side: the close tag of a block after it, its open tag before it
+static HBAstTag* facingTag(HBAstNode* statement, BOOL before)
+{
+    if ([statement isKindOfClass:[HBAstBlock class]]) return before ? ((HBAstBlock*)statement).openTag : ((HBAstBlock*)statement).closeTag;
+    if ([statement isKindOfClass:[HBAstTag class]]) return (HBAstTag*)statement;
+    return nil;
+}
+
++ (HBAstProgram*)astByReplacingBytesInRange:(NSRange)range withBytes:(NSData*)replacement inProgram:(HBAstProgram*)program source:(NSData*)source reparsedStatements:(NSRange*)reparsedStatements error:(NSError**)error
+{
+    NSMutableData* newSource = [NSMutableData dataWithCapacity:[source length] - range.length + [replacement length]];
+    [newSource appendBytes:[source bytes] length:range.location];
+    [newSource appendData:replacement];
+    [newSource appendBytes:(const char*)[source bytes] + NSMaxRange(range) length:[source length] - NSMaxRange(range)];
+    NSInteger delta = (NSInteger)[replacement length] - (NSInteger)range.length;
+    
+    // Top-level statement spans are in source order. They tile the template, but for the gaps left by comments and empty
+    // text dropped when compiling. Find the first statement ending at or after the start of the edit, and the last one
+    // starting at or before its end: statements touching the edit are parsed again too, with the gaps around them.
+    NSArray* statements = program.statements;
+    NSUInteger count = [statements count];
+    NSUInteger first = 0, last = count;
+    for (NSUInteger high = count; first < high; ) {
+        NSUInteger middle = (first + high) / 2;
+        if (NSMaxRange(statementSpan(program, middle)) < range.location) first = middle + 1; else high = middle;
+    }
+    for (NSUInteger low = first; low < last; ) {
+        NSUInteger middle = (low + last) / 2;
+        if (statementSpan(program, middle).location <= NSMaxRange(range)) low = middle + 1; else last = middle;
+    }
+    
+    HBAstProgram* result = nil;
+    if (first < count && last > first) {
+        last--;
         
-        NSString* extractedText = [text substringWithRange:NSMakeRange(posMin, posMax - posMin)];
+        // Extend the statements to parse again until their neighbours can't be affected by the edit:
+        // - raw text next to them may need different whitespace trimming, or would merge with new raw text
+        // - a tag before them would lex differently if followed by '}' ("}}}" closes an unescaped tag)
+        // - a tag after them would lex differently if preceded by '{' or '\' (more braces, escaped mustache)
+        const char* bytes = [newSource bytes];
+        NSUInteger start, end;
+        for (;;) {
+            while (first > 0 && [statements[first - 1] isKindOfClass:[HBAstRawText class]]) first--;
+            while (last + 1 < count && [statements[last + 1] isKindOfClass:[HBAstRawText class]]) last++;
+            start = (first > 0) ? NSMaxRange(statementSpan(program, first - 1)) : 0;
+            end = (last + 1 < count) ? statementSpan(program, last + 1).location + delta : [newSource length];
+            if (first > 0 && start < [newSource length] && bytes[start] == '}') { first--; continue; }
+            if (last + 1 < count && end > 0 && (bytes[end - 1] == '{' || bytes[end - 1] == '\\')) { last++; continue; }
+            break;
+        }
+        
+        NSError* regionError = nil;
+        HBAstProgram* region = (end > start) ? astFromUTF8Data([newSource subdataWithRange:NSMakeRange(start, end - start)], &regionError) : nil;
+        
+        // An error in the region may come from the statements around it (a block the edit opened or closed for instance):
+        // only a parse of the whole template can tell.
+        if (!regionError) {
+            // whitespace control of the tags around the region, which the region was parsed without
+            NSArray* regionStatements = region.statements;
+            HBAstRawText* firstText = [regionStatements.firstObject isKindOfClass:[HBAstRawText class]] ? regionStatements.firstObject : nil;
+            HBAstRawText* lastText = [regionStatements.lastObject isKindOfClass:[HBAstRawText class]] ? regionStatements.lastObject : nil;
+            if (firstText && first > 0 && facingTag(statements[first - 1], NO).right_wsc) [firstText trimLeadingWhitespace];
+            if (lastText && last + 1 < count && facingTag(statements[last + 1], YES).left_wsc) [lastText trimTrailingWhitespace];
+            
+            NSUInteger newCount = count - (last + 1 - first) + [region.statements count];
+            NSMutableArray* newStatements = [NSMutableArray arrayWithCapacity:newCount];
+            NSMutableArray* offsets = [NSMutableArray arrayWithCapacity:newCount];
+            for (NSUInteger i = 0; i < first; i++) {
+                [newStatements addObject:statements[i]];
+                [offsets addObject:@([program sourceOffsetOfStatementAtIndex:i])];
+            }
+            for (HBAstNode* statement in region.statements) {
+                [newStatements addObject:statement];
+                [offsets addObject:@(start)];
+            }
+            for (NSUInteger i = last + 1; i < count; i++) {
+                [newStatements addObject:statements[i]];
+                [offsets addObject:@([program sourceOffsetOfStatementAtIndex:i] + delta)];
+            }
+            
+            if (reparsedStatements) *reparsedStatements = NSMakeRange(first, [region.statements count]);
+            
+            result = [[HBAstProgram new] autorelease];
+            result.statements = newStatements;
+            result.statementSourceOffsets = offsets;
+            result.lookupCacheKeys = program.lookupCacheKeys; // statements kept share their keys with those reparsed
+        }
+    }
     
+    if (!result) {
+        result = [self astFromUTF8Data:newSource error:error];
+        if (reparsedStatements) *reparsedStatements = NSMakeRange(0, [result.statements count]);
+    }
+    
+    result.sourceData = newSource;
+    return result;
+}
+
+#pragma mark -
+#pragma mark Error reporting
+
+// Parse errors are logged and returned with the template text around the error.
++ (NSError*) reportedError:(NSError*)lowerLevelError context:(NSString* (^)(NSInteger pos))extractContext
+{
+    if ([lowerLevelError isKindOfClass:[HBParseError class]]) {
+        HBParseError* parseError = (HBParseError*)lowerLevelError;
+    
+        NSString* extractedText = extractContext(parseError.positionInBuffer);
     
         NSString* error = [NSString stringWithFormat:@"%@\nline %ld\n'%@'", parseError.lowLevelParserDescription, (long int)parseError.lineNumber, extractedText];
         [HBHandlebars log:1 object:error];
@@ -65,9 +325,7 @@ extern int hb_column;
         if (error) lowerLevelError = [HBParseError parseErrorWithLineNumber:parseError.lineNumber positionInBuffer:parseError.positionInBuffer contextInBuffer:extractedText lowLevelParserDescription:parseError.lowLevelParserDescription];
     }
     
-    if (error) *error = lowerLevelError;
-    
-    return nil;
+    return lowerLevelError;
 }
 
 @end
@@ -0,0 +1,975 @@
+//
+//  HBRecursiveDescentParser.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/14.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+// Hand-written, single-pass alternative to the flex scanner and bison parser
+// (handlebars-objc.lm and handlebars-objc.ym).
+//
+// The lexer pulls tokens on demand from the UTF-8 source buffer and the parser
+// is a plain recursive descent over the grammar, with at most two tokens of
+// lookahead. It builds exactly the same AST as the generated parser, and
+// reproduces the generated lexer token for token: same longest-match choices
+// between rules, same trailing contexts, same characters silently skipped by
+// flex's default rule, and same line and position for syntax errors.
+
+#import "HBAst.h"
+#import "HBSymbolTable.h"
+#import "HBTextScanner.h"
+#import "HBWhitespaceControl.h"
+#import "HBErrorHandling_Private.h"
+
+// Number of zero bytes after the source. Fixed-length lookaheads (at most 5 bytes
+// past the current character) can then read the buffer without bound checks.
+#define HB_RD_SOURCE_PADDING 8
+
+// Maximum nesting of blocks and subexpressions. Templates may come from untrusted sources, and
+// the parser recursion must fit in the stack of any thread (bison fails on deep nesting too).
+#define HB_RD_MAX_NESTING_DEPTH 1000
+
+typedef enum {
+    HBTokenEnd = 0,
+    HBTokenTextContent,
+    HBTokenCommentStart,
+    HBTokenCommentContent,
+    HBTokenCommentEnd,
+    HBTokenDashedCommentStart,
+    HBTokenDashedCommentEnd,
+    HBTokenOpen,
+    HBTokenOpenPartial,
+    HBTokenOpenBlock,
+    HBTokenOpenEndBlock,
+    HBTokenOpenInverse,
+    HBTokenOpenUnescaped,
+    HBTokenOpenUnescapedAmpersand,
+    HBTokenClose,
+    HBTokenCloseUnescaped,
+    HBTokenOpenRaw,
+    HBTokenCloseRaw,
+    HBTokenOpenEndRaw,
+    HBTokenCloseEndRaw,
+    HBTokenString,
+    HBTokenEquals,
+    HBTokenData,
+    HBTokenLeftParenthesis,
+    HBTokenRightParenthesis,
+    HBTokenInteger,
+    HBTokenFloat,
+    HBTokenBoolean,
+    HBTokenId,
+    HBTokenPathSeparator,
+    HBTokenUnknown
+} hb_rd_token_type;
+
+// token names, as bison names them in its error messages
+static const char* hb_rd_token_names[] = {
+    "$end", "TEXT_CONTENT", "COMMENT_START", "COMMENT_CONTENT", "COMMENT_END", "DASHED_COMMENT_START", "DASHED_COMMENT_END",
+    "OPEN", "OPEN_PARTIAL", "OPEN_BLOCK", "OPEN_ENDBLOCK", "OPEN_INVERSE", "OPEN_UNESCAPED", "OPEN_UNESCAPED_AMPERSAND",
+    "CLOSE", "CLOSE_UNESCAPED", "OPEN_RAW", "CLOSE_RAW", "OPEN_ENDRAW", "CLOSE_ENDRAW",
+    "STRING", "EQUALS", "DATA", "LPARENT", "RPARENT", "INTEGER", "FLOAT", "BOOLEAN", "ID", "PATH_SEPARATOR", "UNKNOWN"
+};
+
+// lexer start conditions, same as in handlebars-objc.lm
+typedef enum {
+    HBLexerInitial,
+    HBLexerExpression,
+    HBLexerComment,
+    HBLexerDashedComment,
+    HBLexerRaw,
+    HBLexerRawExpression
+} hb_rd_lexer_state;
+
+typedef struct {
+    hb_rd_token_type type;
+    int ival;           // whitespace control flag of open and close tokens, separator character of path separators
+    NSRange range;      // text carried by the token, in the source buffer
+    int line;
+    int column;
+    NSUInteger end;     // offset following the lexeme
+} hb_rd_token;
+
+typedef struct {
+    NSData* source;
+    const char* bytes;
+    NSUInteger length;
+    NSUInteger position;
+    hb_rd_lexer_state state;
+
+    // location tracking. Like flex's yylineno, line is updated with the newlines of every
+    // consumed lexeme, including skipped ones. The location of the last consumed lexeme is
+    // what gets reported for end of input.
+    int line;
+    int lexemeLine;
+    int lexemeColumn;
+    NSUInteger consumedEnd; // end of the last token consumed by the parser, for source spans
+
+    hb_rd_token lookahead[2];
+    int lookaheadCount;
+
+    int depth;
+    NSError* error;
+
+    hb_whitespace_control whitespaceControl; // applied to statements as they are built
+} hb_rd_parser;
+
+
+#pragma mark -
+#pragma mark Lexer
+
+static inline BOOL hb_rd_char_in(unsigned char c, const char* set)
+{
+    return c && strchr(set, c);
+}
+
+// identifier characters: everything but the characters excluded by the ID class of handlebars-objc.lm
+static inline BOOL hb_rd_is_id_char(unsigned char c)
+{
+    return !hb_rd_char_in(c, " \t!\"#%&'()*+,./;<=>@[\\]^`{|}~");
+}
+
+static inline BOOL hb_rd_is_id_trailer(unsigned char c)
+{
+    return hb_rd_char_in(c, "=/. \t})~");
+}
+
+static inline BOOL hb_rd_is_litteral_trailer(unsigned char c)
+{
+    return hb_rd_char_in(c, " \t})");
+}
+
+static inline BOOL hb_rd_is_dot_trailer(unsigned char c)
+{
+    return hb_rd_char_in(c, "}/ \t)~");
+}
+
+static inline NSUInteger hb_rd_id_end(hb_rd_parser* parser, NSUInteger p)
+{
+    while (p < parser->length && hb_rd_is_id_char(parser->bytes[p])) p++;
+    return p;
+}
+
+static void hb_rd_consume(hb_rd_parser* parser, NSUInteger length)
+{
+    NSUInteger start = parser->position;
+    NSUInteger end = start + length;
+    parser->line += (int)hb_count_newlines(parser->bytes + start, parser->bytes + end);
+    parser->position = end;
+    parser->lexemeLine = parser->line;
+    parser->lexemeColumn = (int)start + 1;
+}
+
+// Skips characters flex's default rule would drop one at a time. The last one is the reported lexeme.
+static void hb_rd_skip(hb_rd_parser* parser, NSUInteger length)
+{
+    if (length > 1) hb_rd_consume(parser, length - 1);
+    hb_rd_consume(parser, 1);
+}
+
+static BOOL hb_rd_emit(hb_rd_parser* parser, hb_rd_token* token, hb_rd_token_type type, int ival, NSUInteger rangeLocation, NSUInteger rangeLength, NSUInteger consumedLength)
+{
+    hb_rd_consume(parser, consumedLength);
+    token->type = type;
+    token->ival = ival;
+    token->range = NSMakeRange(rangeLocation, rangeLength);
+    token->line = parser->lexemeLine;
+    token->column = parser->lexemeColumn;
+    token->end = parser->position;
+    return YES;
+}
+
+static BOOL hb_rd_lex_initial(hb_rd_parser* parser, hb_rd_token* token)
+{
+    const char* b = parser->bytes;
+    NSUInteger p = parser->position;
+
+    if (b[p] == '\\') {
+        if (b[p+1] == '\\' && b[p+2] == '{' && b[p+3] == '{') return hb_rd_emit(parser, token, HBTokenTextContent, 0, p, 1, 2);
+        if (b[p+1] == '{' && b[p+2] == '{') return hb_rd_emit(parser, token, HBTokenTextContent, 0, p + 1, 2, 3);
+        return hb_rd_emit(parser, token, HBTokenTextContent, 0, p, 1, 1);
+    }
+
+    if (b[p] != '{') {
+        NSUInteger q = hb_scan_text(b + p + 1, b + parser->length) - b;
+        return hb_rd_emit(parser, token, HBTokenTextContent, 0, p, q - p, q - p);
+    }
+
+    if (b[p+1] != '{') return hb_rd_emit(parser, token, HBTokenTextContent, 0, p, 1, 1);
+
+    // mustaches
+    NSUInteger q = p + 2;
+    hb_rd_token_type type = HBTokenOpen;
+    hb_rd_lexer_state state = HBLexerExpression;
+    int ival = 0;
+
+    if (b[q] == '{' && b[q+1] == '{') {
+        type = HBTokenOpenRaw; q += 2;
+    } else if (b[q] == '{') {
+        type = HBTokenOpenUnescaped; q += 1;
+    } else if (b[q] == '!' && b[q+1] == '-' && b[q+2] == '-') {
+        type = HBTokenDashedCommentStart; state = HBLexerDashedComment; q += 3;
+    } else if (b[q] == '!') {
+        type = HBTokenCommentStart; state = HBLexerComment; q += 1;
+    } else {
+        if (b[q] == '~') { ival = 1; q++; }
+
+        NSUInteger r = q;
+        while (b[r] == ' ') r++;
+        if (memcmp(b + r, "else", 4) == 0) {
+            type = HBTokenOpenInverse; q = r + 4;
+        } else {
+            switch (b[q]) {
+                case '>': type = HBTokenOpenPartial; q++; break;
+                case '#': type = HBTokenOpenBlock; q++; break;
+                case '/': type = HBTokenOpenEndBlock; q++; break;
+                case '^': type = HBTokenOpenInverse; q++; break;
+                case '&': type = HBTokenOpenUnescapedAmpersand; q++; break;
+                case '{': type = HBTokenOpenUnescaped; q++; break;
+                default: break;
+            }
+        }
+    }
+
+    parser->state = state;
+    return hb_rd_emit(parser, token, type, ival, p, 0, q - p);
+}
+
+// End of the longest match of "(\\"|[^"])*" starting at p (and its single quote equivalent):
+// a quote preceded by a backslash may either close the string or be part of it, the first
+// other quote necessarily closes it. Returns NSNotFound if the string is not terminated.
+static NSUInteger hb_rd_string_end(hb_rd_parser* parser, NSUInteger p)
+{
+    const char* b = parser->bytes;
+    char quote = b[p];
+    NSUInteger end = NSNotFound;
+    for (NSUInteger i = p + 1; i < parser->length; i++) {
+        if (b[i] != quote) continue;
+        end = i;
+        if (b[i-1] != '\\') break;
+    }
+    return end;
+}
+
+static BOOL hb_rd_lex_expression(hb_rd_parser* parser, hb_rd_token* token)
+{
+    const char* b = parser->bytes;
+    NSUInteger p = parser->position;
+    unsigned char c = b[p];
+
+    if (c == ' ' || c == '\t') {
+        NSUInteger q = p;
+        while (b[q] == ' ' || b[q] == '\t') q++;
+        hb_rd_consume(parser, q - p);
+        return NO;
+    }
+
+    if (c == '}' && b[p+1] == '}') {
+        parser->state = HBLexerInitial;
+        if (b[p+2] != '}') return hb_rd_emit(parser, token, HBTokenClose, 0, p, 0, 2);
+        if (b[p+3] != '}') return hb_rd_emit(parser, token, HBTokenCloseUnescaped, 0, p, 0, 3);
+        parser->state = HBLexerRaw;
+        return hb_rd_emit(parser, token, HBTokenCloseRaw, 0, p, 0, 4);
+    }
+    if (c == '}' && b[p+1] == '~' && b[p+2] == '}' && b[p+3] == '}') {
+        parser->state = HBLexerInitial;
+        return hb_rd_emit(parser, token, HBTokenCloseUnescaped, 1, p, 0, 4);
+    }
+    if (c == '~' && b[p+1] == '}' && b[p+2] == '}') {
+        parser->state = HBLexerInitial;
+        return hb_rd_emit(parser, token, HBTokenClose, 1, p, 0, 3);
+    }
+
+    if (c == '"' || c == '\'') {
+        NSUInteger end = hb_rd_string_end(parser, p);
+        if (end != NSNotFound) return hb_rd_emit(parser, token, HBTokenString, 0, p + 1, end - p - 1, end - p + 1);
+        return hb_rd_emit(parser, token, HBTokenUnknown, 0, p, 1, 1);
+    }
+
+    switch (c) {
+        case '=': return hb_rd_emit(parser, token, HBTokenEquals, 0, p, 1, 1);
+        case '@': return hb_rd_emit(parser, token, HBTokenData, 0, p, 1, 1);
+        case '(': return hb_rd_emit(parser, token, HBTokenLeftParenthesis, 0, p, 1, 1);
+        case ')': return hb_rd_emit(parser, token, HBTokenRightParenthesis, 0, p, 1, 1);
+        default: break;
+    }
+
+    // The remaining rules overlap: pick the longest match, trailing context included,
+    // and the first rule of handlebars-objc.lm on ties. Candidates are tried in rule order.
+    hb_rd_token_type type = HBTokenEnd;
+    NSUInteger matchLength = 0;
+    NSUInteger tokenLength = 0;
+    NSUInteger rangeLocation = p;
+    NSUInteger rangeLength = 0;
+    int ival = 0;
+
+#define CANDIDATE(_type_, _matchLength_, _tokenLength_, _rangeLocation_, _rangeLength_, _ival_) \
+    if ((_matchLength_) > matchLength) { type = (_type_); matchLength = (_matchLength_); tokenLength = (_tokenLength_); rangeLocation = (_rangeLocation_); rangeLength = (_rangeLength_); ival = (_ival_); }
+
+    // integers and floats
+    NSUInteger i = (c == '-') ? p + 1 : p;
+    NSUInteger digitsStart = i;
+    while (i < parser->length && b[i] >= '0' && b[i] <= '9') i++;
+    if (i > digitsStart) {
+        if (hb_rd_is_litteral_trailer(b[i])) {
+            CANDIDATE(HBTokenInteger, i - p + 1, i - p, p, i - p, 0);
+        }
+        if (b[i] == '.') {
+            NSUInteger j = i + 1;
+            while (j < parser->length && b[j] >= '0' && b[j] <= '9') j++;
+            if (j > i + 1 && hb_rd_is_litteral_trailer(b[j])) {
+                CANDIDATE(HBTokenFloat, j - p + 1, j - p, p, j - p, 0);
+            }
+        }
+    }
+
+    // booleans
+    if (memcmp(b + p, "true", 4) == 0 && hb_rd_is_litteral_trailer(b[p+4])) {
+        CANDIDATE(HBTokenBoolean, 5, 4, p, 4, 0);
+    }
+    if (memcmp(b + p, "false", 5) == 0 && hb_rd_is_litteral_trailer(b[p+5])) {
+        CANDIDATE(HBTokenBoolean, 6, 5, p, 5, 0);
+    }
+
+    // ".", ".." and path separators
+    if (c == '.' && hb_rd_is_dot_trailer(b[p+1])) {
+        CANDIDATE(HBTokenId, 2, 1, p, 1, 0);
+    }
+    if (c == '.' && b[p+1] == '.') {
+        CANDIDATE(HBTokenId, 2, 2, p, 2, 0);
+    }
+    if (c == '.' || c == '/') {
+        CANDIDATE(HBTokenPathSeparator, 1, 1, p, 1, c);
+    }
+
+    // identifiers
+    NSUInteger k = hb_rd_id_end(parser, p);
+    if (k > p && hb_rd_is_id_trailer(b[k])) {
+        CANDIDATE(HBTokenId, k - p + 1, k - p, p, k - p, 0);
+    }
+
+    // segment literals: the last ']' before the next '['
+    if (c == '[') {
+        NSUInteger end = NSNotFound;
+        for (NSUInteger l = p + 1; l < parser->length && b[l] != '['; l++) {
+            if (b[l] == ']') end = l;
+        }
+        if (end != NSNotFound) {
+            CANDIDATE(HBTokenId, end - p + 1, end - p + 1, p + 1, end - p - 1, 0);
+        }
+    }
+
+    // any other character but newlines
+    if (c != '\n') {
+        CANDIDATE(HBTokenUnknown, 1, 1, p, 1, 0);
+    }
+
+#undef CANDIDATE
+
+    if (matchLength == 0) {
+        // Only happens on a newline starting an identifier run that has no trailing character. The leading
+        // newlines of the run are dropped by flex's default rule, the character after them is unknown.
+        NSUInteger newlinesEnd = p;
+        while (newlinesEnd < k && b[newlinesEnd] == '\n') newlinesEnd++;
+        hb_rd_skip(parser, MAX(newlinesEnd - p, 1));
+        return NO;
+    }
+
+    return hb_rd_emit(parser, token, type, ival, rangeLocation, rangeLength, tokenLength);
+}
+
+static BOOL hb_rd_lex_raw(hb_rd_parser* parser, hb_rd_token* token)
+{
+    const char* b = parser->bytes;
+    NSUInteger p = parser->position;
+
+    if (memcmp(b + p, "{{{{/", 5) == 0) {
+        parser->state = HBLexerRawExpression;
+        return hb_rd_emit(parser, token, HBTokenOpenEndRaw, 0, p, 0, 5);
+    }
+
+    // raw content is everything up to the first "{{{{/", newlines included
+    NSUInteger contentEnd = p + 1;
+    while (contentEnd < parser->length && !(b[contentEnd] == '{' && memcmp(b + contentEnd, "{{{{/", 5) == 0)) contentEnd++;
+    return hb_rd_emit(parser, token, HBTokenTextContent, 0, p, contentEnd - p, contentEnd - p);
+}
+
+static BOOL hb_rd_lex_raw_expression(hb_rd_parser* parser, hb_rd_token* token)
+{
+    const char* b = parser->bytes;
+    NSUInteger p = parser->position;
+
+    if (b[p] == ' ' || b[p] == '\t') {
+        NSUInteger q = p;
+        while (b[q] == ' ' || b[q] == '\t') q++;
+        hb_rd_consume(parser, q - p);
+        return NO;
+    }
+
+    NSUInteger k = hb_rd_id_end(parser, p);
+    if (k > p && hb_rd_is_id_trailer(b[k])) return hb_rd_emit(parser, token, HBTokenId, 0, p, k - p, k - p);
+
+    if (memcmp(b + p, "}}}}", 4) == 0) {
+        parser->state = HBLexerInitial;
+        return hb_rd_emit(parser, token, HBTokenCloseEndRaw, 0, p, 0, 4);
+    }
+
+    // an identifier run without trailing character, or any other character, is dropped
+    hb_rd_skip(parser, MAX(k - p, 1));
+    return NO;
+}
+
+static BOOL hb_rd_lex_comment(hb_rd_parser* parser, hb_rd_token* token)
+{
+    const char* b = parser->bytes;
+    NSUInteger p = parser->position;
+
+    if (b[p] != '}') {
+        NSUInteger q = p;
+        while (q < parser->length && b[q] != '}') q++;
+        return hb_rd_emit(parser, token, HBTokenCommentContent, 0, p, q - p, q - p);
+    }
+
+    if (b[p+1] == '}') {
+        parser->state = HBLexerInitial;
+        return hb_rd_emit(parser, token, HBTokenCommentEnd, 0, p, 0, 2);
+    }
+
+    // a lone '}' is dropped from the comment by flex's default rule
+    hb_rd_skip(parser, 1);
+    return NO;
+}
+
+static BOOL hb_rd_lex_dashed_comment(hb_rd_parser* parser, hb_rd_token* token)
+{
+    NSUInteger p = parser->position;
+
+    if (memcmp(parser->bytes + p, "--}}", 4) == 0) {
+        parser->state = HBLexerInitial;
+        return hb_rd_emit(parser, token, HBTokenDashedCommentEnd, 0, p, 0, 4);
+    }
+
+    hb_rd_skip(parser, 1);
+    return NO;
+}
+
+static void hb_rd_lex(hb_rd_parser* parser, hb_rd_token* token)
+{
+    for (;;) {
+        if (parser->position >= parser->length) {
+            token->type = HBTokenEnd;
+            token->ival = 0;
+            token->range = NSMakeRange(parser->length, 0);
+            token->line = parser->lexemeLine;
+            token->column = parser->lexemeColumn;
+            token->end = parser->length;
+            return;
+        }
+
+        BOOL found = NO;
+        switch (parser->state) {
+            case HBLexerInitial: found = hb_rd_lex_initial(parser, token); break;
+            case HBLexerExpression: found = hb_rd_lex_expression(parser, token); break;
+            case HBLexerComment: found = hb_rd_lex_comment(parser, token); break;
+            case HBLexerDashedComment: found = hb_rd_lex_dashed_comment(parser, token); break;
+            case HBLexerRaw: found = hb_rd_lex_raw(parser, token); break;
+            case HBLexerRawExpression: found = hb_rd_lex_raw_expression(parser, token); break;
+        }
+        if (found) return;
+    }
+}
+
+static inline hb_rd_token* hb_rd_peek(hb_rd_parser* parser)
+{
+    if (parser->lookaheadCount < 1) {
+        hb_rd_lex(parser, &parser->lookahead[0]);
+        parser->lookaheadCount = 1;
+    }
+    return &parser->lookahead[0];
+}
+
+static inline hb_rd_token* hb_rd_peek2(hb_rd_parser* parser)
+{
+    hb_rd_peek(parser);
+    if (parser->lookaheadCount < 2) {
+        hb_rd_lex(parser, &parser->lookahead[1]);
+        parser->lookaheadCount = 2;
+    }
+    return &parser->lookahead[1];
+}
+
+static inline hb_rd_token hb_rd_next(hb_rd_parser* parser)
+{
+    hb_rd_token token = *hb_rd_peek(parser);
+    parser->lookahead[0] = parser->lookahead[1];
+    parser->lookaheadCount--;
+    parser->consumedEnd = token.end;
+    return token;
+}
+
+
+#pragma mark -
+#pragma mark Parser
+
+static void hb_rd_fail_with_description(hb_rd_parser* parser, hb_rd_token* token, NSString* description)
+{
+    if (parser->error) return;
+    parser->error = [[HBParseError parseErrorWithLineNumber:token->line positionInBuffer:token->column contextInBuffer:@"" lowLevelParserDescription:description] retain];
+}
+
+static void hb_rd_fail(hb_rd_parser* parser, hb_rd_token* token)
+{
+    hb_rd_fail_with_description(parser, token, [NSString stringWithFormat:@"syntax error, unexpected %s", hb_rd_token_names[token->type]]);
+}
+
+// every hb_rd_enter that succeeds must be balanced by an hb_rd_leave
+static BOOL hb_rd_enter(hb_rd_parser* parser)
+{
+    if (parser->depth >= HB_RD_MAX_NESTING_DEPTH) {
+        hb_rd_fail_with_description(parser, hb_rd_peek(parser), @"nesting too deep");
+        return NO;
+    }
+    parser->depth++;
+    return YES;
+}
+
+static inline void hb_rd_leave(hb_rd_parser* parser)
+{
+    parser->depth--;
+}
+
+// consumes the next token if it has the expected type, fails otherwise
+static BOOL hb_rd_expect(hb_rd_parser* parser, hb_rd_token_type type, hb_rd_token* token)
+{
+    hb_rd_token* next = hb_rd_peek(parser);
+    if (next->type != type) {
+        hb_rd_fail(parser, next);
+        return NO;
+    }
+    *token = hb_rd_next(parser);
+    return YES;
+}
+
+static inline NSString* hb_rd_source_string(hb_rd_parser* parser, NSRange range)
+{
+    return [[[NSString alloc] initWithBytes:parser->bytes + range.location length:range.length encoding:NSUTF8StringEncoding] autorelease];
+}
+
+static HBAstExpression* hb_rd_expression(hb_rd_parser* parser);
+
+static HBAstContextualValue* hb_rd_path(hb_rd_parser* parser)
+{
+    hb_rd_token token;
+    if (!hb_rd_expect(parser, HBTokenId, &token)) return nil;
+
+    HBAstKeyPathComponent* component = [[HBAstKeyPathComponent new] autorelease];
+    component.key = [HBSymbolTable symbolWithUTF8Bytes:parser->bytes + token.range.location length:token.range.length];
+    NSMutableArray* keyPath = [NSMutableArray arrayWithObject:component];
+
+    while (hb_rd_peek(parser)->type == HBTokenPathSeparator) {
+        hb_rd_token separator = hb_rd_next(parser);
+        if (!hb_rd_expect(parser, HBTokenId, &token)) return nil;
+
+        component = [[HBAstKeyPathComponent new] autorelease];
+        component.key = [HBSymbolTable symbolWithUTF8Bytes:parser->bytes + token.range.location length:token.range.length];
+        component.leadingSeparator = (separator.ival == '/') ? @"/" : @".";
+        [keyPath addObject:component];
+    }
+
+    HBAstContextualValue* contextualValue = [[HBAstContextualValue new] autorelease];
+    contextualValue.keyPath = keyPath;
+    return contextualValue;
+}
+
+static HBAstContextualValue* hb_rd_contextual_value(hb_rd_parser* parser)
+{
+    BOOL isDataValue = (hb_rd_peek(parser)->type == HBTokenData);
+    if (isDataValue) hb_rd_next(parser);
+
+    HBAstContextualValue* value = hb_rd_path(parser);
+    if (isDataValue) value.isDataValue = true;
+    return value;
+}
+
+static HBAstString* hb_rd_string(hb_rd_parser* parser)
+{
+    hb_rd_token token = hb_rd_next(parser);
+    NSString* value = hb_rd_source_string(parser, token.range);
+
+    // the quote character is right before the range. Strings only need unescaping if they contain a backslash.
+    const char* bytes = parser->bytes + token.range.location;
+    if (memchr(bytes, '\\', token.range.length)) {
+        value = (bytes[-1] == '"') ? [value stringByReplacingOccurrencesOfString:@"\\\"" withString:@"\""] : [value stringByReplacingOccurrencesOfString:@"\\'" withString:@"'"];
+    }
+
+    HBAstString* s = [[HBAstString new] autorelease];
+    s.litteralValue = value;
+    s.sourceRepresentation = value;
+    return s;
+}
+
+static HBAstNumber* hb_rd_number(hb_rd_parser* parser)
+{
+    hb_rd_token token = hb_rd_next(parser);
+    NSString* source = hb_rd_source_string(parser, token.range);
+
+    HBAstNumber* number = [[HBAstNumber new] autorelease];
+    switch (token.type) {
+        case HBTokenInteger: number.litteralValue = [NSNumber numberWithInteger:[source integerValue]]; break;
+        case HBTokenFloat: number.litteralValue = [NSNumber numberWithDouble:[source doubleValue]]; break;
+        default: number.litteralValue = ([source isEqual:@"true"] ? @true : @false); number.isBoolean = true; break;
+    }
+    number.sourceRepresentation = source;
+    return number;
+}
+
+static HBAstValue* hb_rd_value(hb_rd_parser* parser)
+{
+    hb_rd_token* token = hb_rd_peek(parser);
+    switch (token->type) {
+        case HBTokenLeftParenthesis: {
+            if (!hb_rd_enter(parser)) return nil;
+            hb_rd_next(parser);
+            HBAstExpression* expression = hb_rd_expression(parser);
+            hb_rd_leave(parser);
+            hb_rd_token closing;
+            if (!expression || !hb_rd_expect(parser, HBTokenRightParenthesis, &closing)) return nil;
+            return expression;
+        }
+        case HBTokenId:
+        case HBTokenData:
+            return hb_rd_contextual_value(parser);
+        case HBTokenString:
+            return hb_rd_string(parser);
+        case HBTokenInteger:
+        case HBTokenFloat:
+        case HBTokenBoolean:
+            return hb_rd_number(parser);
+        default:
+            hb_rd_fail(parser, token);
+            return nil;
+    }
+}
+
+static inline BOOL hb_rd_starts_value(hb_rd_token_type type)
+{
+    switch (type) {
+        case HBTokenLeftParenthesis:
+        case HBTokenId:
+        case HBTokenData:
+        case HBTokenString:
+        case HBTokenInteger:
+        case HBTokenFloat:
+        case HBTokenBoolean:
+            return YES;
+        default:
+            return NO;
+    }
+}
+
+static inline BOOL hb_rd_starts_hash(hb_rd_parser* parser)
+{
+    return hb_rd_peek(parser)->type == HBTokenId && hb_rd_peek2(parser)->type == HBTokenEquals;
+}
+
+static HBAstParametersHash* hb_rd_hash(hb_rd_parser* parser)
+{
+    HBAstParametersHash* hash = [[HBAstParametersHash new] autorelease];
+    while (hb_rd_peek(parser)->type == HBTokenId) {
+        hb_rd_token key = hb_rd_next(parser);
+        hb_rd_token equals;
+        if (!hb_rd_expect(parser, HBTokenEquals, &equals)) return nil;
+
+        HBAstValue* value = hb_rd_value(parser);
+        if (!value) return nil;
+
+        [hash appendParameter:value forKey:[HBSymbolTable symbolWithUTF8Bytes:parser->bytes + key.range.location length:key.range.length]];
+    }
+    return hash;
+}
+
+static HBAstExpression* hb_rd_expression(hb_rd_parser* parser)
+{
+    HBAstContextualValue* mainValue = hb_rd_contextual_value(parser);
+    if (!mainValue) return nil;
+
+    HBAstExpression* expression = [[HBAstExpression new] autorelease];
+    expression.mainValue = mainValue;
+
+    while (hb_rd_starts_value(hb_rd_peek(parser)->type) && !hb_rd_starts_hash(parser)) {
+        HBAstValue* value = hb_rd_value(parser);
+        if (!value) return nil;
+        [expression addPositionalParameter:value];
+    }
+
+    if (hb_rd_peek(parser)->type == HBTokenId) {
+        HBAstParametersHash* hash = hb_rd_hash(parser);
+        if (!hash) return nil;
+        expression.namedParameters = hash;
+    }
+
+    return expression;
+}
+
+// open expression close
+static id hb_rd_tag(hb_rd_parser* parser, Class tagClass, hb_rd_token_type closeType)
+{
+    hb_rd_token open = hb_rd_next(parser);
+    HBAstExpression* expression = hb_rd_expression(parser);
+    hb_rd_token close;
+    if (!expression || !hb_rd_expect(parser, closeType, &close)) return nil;
+
+    HBAstTag* tag = [[tagClass new] autorelease];
+    tag.left_wsc = open.ival;
+    tag.right_wsc = close.ival;
+    tag.expression = expression;
+    hb_whitespace_control_tag(&parser->whitespaceControl, tag.left_wsc, tag.right_wsc);
+    return tag;
+}
+
+static HBAstPartialTag* hb_rd_partial_tag(hb_rd_parser* parser)
+{
+    hb_rd_token open = hb_rd_next(parser);
+    HBAstPartialTag* tag = [[HBAstPartialTag new] autorelease];
+    tag.left_wsc = open.ival;
+
+    hb_rd_token* token = hb_rd_peek(parser);
+    switch (token->type) {
+        case HBTokenId: tag.partialName = hb_rd_path(parser); break;
+        case HBTokenString: tag.partialName = hb_rd_string(parser); break;
+        case HBTokenInteger: tag.partialName = hb_rd_number(parser); break;
+        default: hb_rd_fail(parser, token); break;
+    }
+    if (!tag.partialName) return nil;
+
+    if (hb_rd_peek(parser)->type == HBTokenId && !hb_rd_starts_hash(parser)) {
+        tag.context = hb_rd_path(parser);
+        if (!tag.context) return nil;
+    }
+
+    if (hb_rd_peek(parser)->type == HBTokenId) {
+        tag.namedParameters = hb_rd_hash(parser);
+        if (!tag.namedParameters) return nil;
+    }
+
+    hb_rd_token close;
+    if (!hb_rd_expect(parser, HBTokenClose, &close)) return nil;
+    tag.right_wsc = close.ival;
+    hb_whitespace_control_tag(&parser->whitespaceControl, tag.left_wsc, tag.right_wsc);
+    return tag;
+}
+
+static HBAstComment* hb_rd_comment(hb_rd_parser* parser)
+{
+    hb_rd_next(parser);
+
+    hb_rd_token content;
+    if (!hb_rd_expect(parser, HBTokenCommentContent, &content)) return nil;
+    NSString* value = hb_rd_source_string(parser, content.range);
+    while (hb_rd_peek(parser)->type == HBTokenCommentContent) {
+        content = hb_rd_next(parser);
+        value = [value stringByAppendingString:hb_rd_source_string(parser, content.range)];
+    }
+
+    hb_rd_token end;
+    if (!hb_rd_expect(parser, HBTokenCommentEnd, &end)) return nil;
+
+    HBAstComment* comment = [[HBAstComment new] autorelease];
+    comment.litteralValue = value;
+    hb_whitespace_control_comment(&parser->whitespaceControl);
+    return comment;
+}
+
+static HBAstBlock* hb_rd_block(hb_rd_parser* parser);
+
+// Parses statements until a token that cannot start one. When allowElse is set, {{else}} and {{^}}
+// end the statements too, so that the enclosing block can handle them.
+// Returns nil when there is no statement or on error (in which case parser->error is set).
+static NSMutableArray* hb_rd_statements(hb_rd_parser* parser, BOOL allowElse)
+{
+    NSMutableArray* statements = nil;
+    for (;;) {
+        hb_rd_token* token = hb_rd_peek(parser);
+        NSUInteger start = token->column - 1;
+        HBAstNode* statement = nil;
+
+        switch (token->type) {
+            case HBTokenTextContent: {
+                HBAstRawText* rawText = [[HBAstRawText new] autorelease];
+                [rawText setSourceBuffer:parser->source range:token->range];
+                hb_whitespace_control_raw_text(&parser->whitespaceControl, rawText);
+                hb_rd_next(parser);
+                statement = rawText;
+                break;
+            }
+            case HBTokenCommentStart:
+                statement = hb_rd_comment(parser);
+                break;
+            case HBTokenOpen: {
+                HBAstSimpleTag* tag = hb_rd_tag(parser, [HBAstSimpleTag class], HBTokenClose);
+                tag.escape = true;
+                statement = tag;
+                break;
+            }
+            case HBTokenOpenUnescaped:
+                statement = hb_rd_tag(parser, [HBAstSimpleTag class], HBTokenCloseUnescaped);
+                break;
+            case HBTokenOpenUnescapedAmpersand:
+                statement = hb_rd_tag(parser, [HBAstSimpleTag class], HBTokenClose);
+                break;
+            case HBTokenOpenPartial:
+                statement = hb_rd_partial_tag(parser);
+                break;
+            case HBTokenOpenInverse:
+                if (allowElse && hb_rd_peek2(parser)->type == HBTokenClose) return statements;
+                // fall through
+            case HBTokenOpenBlock:
+            case HBTokenOpenRaw:
+                if (!hb_rd_enter(parser)) return nil;
+                statement = hb_rd_block(parser);
+                hb_rd_leave(parser);
+                break;
+            default:
+                return statements;
+        }
+
+        if (!statement) return nil;
+        statement.sourceSpan = NSMakeRange(start, parser->consumedEnd - start);
+        if (!statements) statements = [NSMutableArray array];
+        [statements addObject:statement];
+    }
+}
+
+static HBAstTag* hb_rd_block_close_tag(hb_rd_parser* parser)
+{
+    hb_rd_token* token = hb_rd_peek(parser);
+    if (token->type != HBTokenOpenEndBlock) {
+        hb_rd_fail(parser, token);
+        return nil;
+    }
+    return hb_rd_tag(parser, [HBAstTag class], HBTokenClose);
+}
+
+static HBAstBlock* hb_rd_block(hb_rd_parser* parser)
+{
+    hb_rd_token_type openType = hb_rd_peek(parser)->type;
+    HBAstBlock* block = [[HBAstBlock new] autorelease];
+
+    if (openType == HBTokenOpenRaw) {
+        block.openTag = hb_rd_tag(parser, [HBAstTag class], HBTokenCloseRaw);
+        if (!block.openTag) return nil;
+
+        block.statements = hb_rd_statements(parser, NO);
+        if (parser->error) return nil;
+        hb_rd_token* token = hb_rd_peek(parser);
+        if (!block.statements || token->type != HBTokenOpenEndRaw) {
+            hb_rd_fail(parser, token);
+            return nil;
+        }
+
+        block.closeTag = hb_rd_tag(parser, [HBAstTag class], HBTokenCloseEndRaw);
+        return block.closeTag ? block : nil;
+    }
+
+    block.openTag = hb_rd_tag(parser, [HBAstTag class], HBTokenClose);
+    if (!block.openTag) return nil;
+
+    if (openType == HBTokenOpenInverse) {
+        block.inverseStatements = hb_rd_statements(parser, NO);
+        if (parser->error) return nil;
+    } else {
+        block.statements = hb_rd_statements(parser, YES);
+        if (parser->error) return nil;
+
+        // statements only stop on an open inverse token when it is an else tag
+        if (hb_rd_peek(parser)->type == HBTokenOpenInverse) {
+            hb_rd_token open = hb_rd_next(parser);
+            hb_rd_token close = hb_rd_next(parser);
+            HBAstTag* elseTag = [[HBAstTag new] autorelease];
+            elseTag.left_wsc = open.ival;
+            elseTag.right_wsc = close.ival;
+            hb_whitespace_control_tag(&parser->whitespaceControl, elseTag.left_wsc, elseTag.right_wsc);
+            block.elseTag = elseTag;
+
+            block.inverseStatements = hb_rd_statements(parser, NO);
+            if (parser->error) return nil;
+        }
+    }
+
+    block.closeTag = hb_rd_block_close_tag(parser);
+    return block.closeTag ? block : nil;
+}
+
+static HBAstProgram* hb_rd_program(hb_rd_parser* parser)
+{
+    NSMutableArray* statements = hb_rd_statements(parser, NO);
+    if (parser->error) return nil;
+
+    hb_rd_token* token = hb_rd_peek(parser);
+    if (token->type != HBTokenEnd) {
+        hb_rd_fail(parser, token);
+        return nil;
+    }
+
+    // like the generated parser, an empty template has no program
+    if (!statements) return nil;
+
+    HBAstProgram* program = [[HBAstProgram new] autorelease];
+    program.statements = statements;
+    return program;
+}
+
+id astFromStringWithRecursiveDescent(NSString* text, NSError** error)
+{
+    // Same UTF-8 copy of the template as the generated parser makes, so that raw text nodes
+    // can keep ranges into it. The zero padding lets the lexer peek a few bytes past any position.
+    NSUInteger utf8Length = [text lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData* source = [NSMutableData dataWithLength:utf8Length + HB_RD_SOURCE_PADDING];
+    [text getBytes:[source mutableBytes] maxLength:utf8Length usedLength:NULL encoding:NSUTF8StringEncoding options:0 range:NSMakeRange(0, [text length]) remainingRange:NULL];
+
+    hb_rd_parser parser = {
+        .source = source,
+        .bytes = [source bytes],
+        .length = utf8Length,
+        .position = 0,
+        .state = HBLexerInitial,
+        .line = 1,
+        .lexemeLine = 1,
+        .lexemeColumn = 1,
+        .lookaheadCount = 0,
+        .depth = 0,
+        .error = nil
+    };
+
+    HBAstProgram* program = nil;
+    @autoreleasepool {
+        program = [hb_rd_program(&parser) retain];
+    }
+
+    if (parser.error) {
+        if (error) *error = [[parser.error retain] autorelease];
+        [parser.error release];
+    }
+
+    return [program autorelease];
+}
@@ -0,0 +1,48 @@
+//
+//  HBSymbolTable.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+// Process-wide table of interned identifiers.
+//
+// Identifiers used in templates (key path components, hash parameter names...) are
+// interned so that all occurrences across all compiled templates share one immutable
+// string instance. This saves memory when many templates are resident and lets lookups
+// compare identifiers by pointer first.
+//
+// Interned strings are never released. To protect processes compiling untrusted templates,
+// the table stops growing once it reaches HBSymbolTableMaxSymbolCount entries: identifiers
+// that are not already interned are then returned as regular strings.
+
+extern const NSUInteger HBSymbolTableMaxSymbolCount;
+
+@interface HBSymbolTable : NSObject
+
++ (NSString*) symbolWithUTF8Bytes:(const char*)bytes length:(NSUInteger)length;
++ (NSString*) symbolForString:(NSString*)string;
+
+@end
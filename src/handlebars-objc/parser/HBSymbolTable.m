@@ -0,0 +1,78 @@
+//
+//  HBSymbolTable.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBSymbolTable.h"
+
+const NSUInteger HBSymbolTableMaxSymbolCount = 65536;
+
+@implementation HBSymbolTable
+
+static CFMutableSetRef _symbols = NULL;
+
++ (void) initialize
+{
+    if (self == [HBSymbolTable class]) {
+        _symbols = CFSetCreateMutable(kCFAllocatorDefault, 0, &kCFTypeSetCallBacks);
+    }
+}
+
+// Returns the interned string equal to string, or nil if there is none yet.
+// In the latter case, symbol is interned if the table is not full.
++ (NSString*) lookupString:(NSString*)string internedValue:(NSString*)symbol
+{
+    @synchronized(self) {
+        NSString* existingSymbol = (NSString*)CFSetGetValue(_symbols, string);
+        if (existingSymbol) return existingSymbol;
+        if (symbol && (CFSetGetCount(_symbols) < (CFIndex)HBSymbolTableMaxSymbolCount)) CFSetAddValue(_symbols, symbol);
+    }
+    return nil;
+}
+
++ (NSString*) symbolWithUTF8Bytes:(const char*)bytes length:(NSUInteger)length
+{
+    // first look symbol up using a string that does not copy bytes
+    NSString* probe = (NSString*)CFStringCreateWithBytesNoCopy(kCFAllocatorDefault, (const UInt8*)bytes, length, kCFStringEncodingUTF8, false, kCFAllocatorNull);
+    if (!probe) return nil;
+    NSString* symbol = [self lookupString:probe internedValue:nil];
+    CFRelease((CFStringRef)probe);
+    if (symbol) return symbol;
+    
+    // new symbol
+    NSString* newSymbol = [[[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding] autorelease];
+    symbol = [self lookupString:newSymbol internedValue:newSymbol];
+    return symbol ? symbol : newSymbol;
+}
+
++ (NSString*) symbolForString:(NSString*)string
+{
+    if (!string) return nil;
+    NSString* newSymbol = [[string copy] autorelease];
+    NSString* symbol = [self lookupString:newSymbol internedValue:newSymbol];
+    return symbol ? symbol : newSymbol;
+}
+
+@end
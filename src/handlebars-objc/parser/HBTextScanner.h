@@ -0,0 +1,44 @@
+//
+//  HBTextScanner.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import <Foundation/Foundation.h>
+
+// Scanning of literal text between mustaches.
+//
+// Most bytes of a typical template are static text that only ends at the next '{' or '\'.
+// Both lexers find that end with hb_scan_text, which examines 16 or 32 bytes at a time using
+// SSE2 or AVX2 on x86-64 and NEON on arm64, and 8 bytes at a time elsewhere.
+
+// Returns a pointer to the first '{' or '\' in [start, end), or end if there is none.
+const char* hb_scan_text(const char* start, const char* end);
+
+// Same as hb_scan_text, one byte at a time. Reference implementation for tests and benchmarks.
+const char* hb_scan_text_bytewise(const char* start, const char* end);
+
+// Returns the number of '\n' in [start, end).
+NSUInteger hb_count_newlines(const char* start, const char* end);
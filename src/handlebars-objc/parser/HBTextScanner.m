@@ -0,0 +1,141 @@
+//
+//  HBTextScanner.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+
+#import "HBTextScanner.h"
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static inline BOOL hb_is_text_delimiter(char c)
+{
+    return c == '{' || c == '\\';
+}
+
+const char* hb_scan_text_bytewise(const char* start, const char* end)
+{
+    const char* p = start;
+    while (p < end && !hb_is_text_delimiter(*p)) p++;
+    return p;
+}
+
+// Eight bytes at a time in a general purpose register: a byte of word equal to c has its high bit set in the result
+// (bytes above a match may be flagged too, so matches are located bytewise).
+static inline uint64_t hb_word_bytes_equal(uint64_t word, char c)
+{
+    const uint64_t ones = 0x0101010101010101ULL;
+    uint64_t x = word ^ (ones * (unsigned char)c);
+    return (x - ones) & ~x & (ones << 7);
+}
+
+static const char* hb_scan_text_words(const char* start, const char* end)
+{
+    const char* p = start;
+    while (end - p >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        if (hb_word_bytes_equal(word, '{') | hb_word_bytes_equal(word, '\\')) break;
+        p += 8;
+    }
+    return hb_scan_text_bytewise(p, end);
+}
+
+#if defined(__AVX2__)
+
+const char* hb_scan_text(const char* start, const char* end)
+{
+    const __m256i braces = _mm256_set1_epi8('{');
+    const __m256i backslashes = _mm256_set1_epi8('\\');
+    const char* p = start;
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)p);
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, braces), _mm256_cmpeq_epi8(chunk, backslashes)));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return hb_scan_text_words(p, end);
+}
+
+#elif defined(__SSE2__)
+
+const char* hb_scan_text(const char* start, const char* end)
+{
+    const __m128i braces = _mm_set1_epi8('{');
+    const __m128i backslashes = _mm_set1_epi8('\\');
+    const char* p = start;
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, braces), _mm_cmpeq_epi8(chunk, backslashes)));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return hb_scan_text_words(p, end);
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+const char* hb_scan_text(const char* start, const char* end)
+{
+    const uint8x16_t braces = vdupq_n_u8('{');
+    const uint8x16_t backslashes = vdupq_n_u8('\\');
+    const char* p = start;
+    while (end - p >= 16) {
+        uint8x16_t chunk = vld1q_u8((const uint8_t*)p);
+        uint8x16_t matches = vorrq_u8(vceqq_u8(chunk, braces), vceqq_u8(chunk, backslashes));
+        // narrow the 16 byte mask to 4 bits per byte, so it fits a general purpose register
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+        if (mask) return p + (__builtin_ctzll(mask) >> 2);
+        p += 16;
+    }
+    return hb_scan_text_words(p, end);
+}
+
+#else
+
+const char* hb_scan_text(const char* start, const char* end)
+{
+    return hb_scan_text_words(start, end);
+}
+
+#endif
+
+NSUInteger hb_count_newlines(const char* start, const char* end)
+{
+    NSUInteger count = 0;
+    const char* p = start;
+    while (p < end && (p = memchr(p, '\n', end - p))) {
+        count++;
+        p++;
+    }
+    return count;
+}
@@ -0,0 +1,56 @@
+//
+//  HBWhitespaceControl.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBAstRawText.h"
+
+// Whitespace control ('~' next to a mustache) trims the raw text on that side of the tag. It is applied by the
+// parsers as statements are built, in source order: raw text is trimmed when the tag that follows it is built,
+// or when it is built itself after a tag. Comments are not affected and stop trimming.
+typedef struct {
+    HBAstRawText* lastRawText;  // raw text right before the next tag, if any
+    BOOL trimNextRawText;       // the last tag has whitespace control on its right
+} hb_whitespace_control;
+
+static inline void hb_whitespace_control_raw_text(hb_whitespace_control* wsc, HBAstRawText* rawText)
+{
+    if (wsc->trimNextRawText) [rawText trimLeadingWhitespace];
+    wsc->trimNextRawText = NO;
+    wsc->lastRawText = rawText;
+}
+
+static inline void hb_whitespace_control_tag(hb_whitespace_control* wsc, BOOL left_wsc, BOOL right_wsc)
+{
+    if (left_wsc && wsc->lastRawText) [wsc->lastRawText trimTrailingWhitespace];
+    wsc->lastRawText = nil;
+    wsc->trimNextRawText = right_wsc;
+}
+
+static inline void hb_whitespace_control_comment(hb_whitespace_control* wsc)
+{
+    wsc->lastRawText = nil;
+    wsc->trimNextRawText = NO;
+}
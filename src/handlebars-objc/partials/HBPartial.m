@@ -28,14 +28,31 @@
 #import "HBPartial.h"
 #import "HBPartial_Private.h"
 #import "HBParser.h"
+#import "HBAstArchive.h"
+#import "HBAstFreezingVisitor.h"
+#import "HBAstOptimizingVisitor.h"
+#import "HBAstBytecodeGenerationVisitor.h"
+#import "HBBytecode.h"
+#import "HBClosureTree.h"
 
 @implementation HBPartial
+{
+    HBBytecode* _bytecode;
+    BOOL _bytecodeIsUnsupported;
+    HBClosureTree* _closureTree;
+}
 
 - (BOOL) compile:(NSError**)error
 {
     @synchronized(self) {
-        if (!self._program) {
+        if (!self._program && self.archivedProgram) {
+            self._program = [self.archivedProgram program:error];
+            [HBAstOptimizingVisitor optimizeProgram:self._program];
+            [HBAstFreezingVisitor freezeProgram:self._program];
+        } else if (!self._program) {
             self._program = [HBParser astFromString:self.string error:error];
+            [HBAstOptimizingVisitor optimizeProgram:self._program];
+            [HBAstFreezingVisitor freezeProgram:self._program];
         }
     }
     return (nil != self._program);
@@ -46,12 +63,34 @@
     return self._program.statements;
 }
 
+- (HBBytecode*) bytecode
+{
+    @synchronized(self) {
+        if (!_bytecode && self._program && !_bytecodeIsUnsupported) {
+            _bytecode = [[HBAstBytecodeGenerationVisitor bytecodeForStatements:self.astStatements] retain];
+            _bytecodeIsUnsupported = (_bytecode == nil);
+        }
+        return [[_bytecode retain] autorelease];
+    }
+}
+
+- (HBClosureTree*) closureTree
+{
+    @synchronized(self) {
+        if (!_closureTree && self._program) _closureTree = [[HBClosureTree closureTreeForStatements:self.astStatements] retain];
+        return [[_closureTree retain] autorelease];
+    }
+}
+
 #pragma mark -
 
 - (void) dealloc
 {
     self.string = nil;
     self._program = nil;
+    self.archivedProgram = nil;
+    [_bytecode release];
+    [_closureTree release];
     [super dealloc];
 }
 
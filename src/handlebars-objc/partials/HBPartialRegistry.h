@@ -102,6 +102,24 @@
  */
 - (void) unregisterAllPartials;
 
+/** @name Inlined partials */
+
+/**
+ Generation of the registry
+ 
+ Templates that inline partials (see <[HBTemplate inlinesPartials]>) splice them into their program when they compile. The generation changes each time a partial is registered into or unregistered from the registry, so that these templates check the partials they inlined again. Values come from a counter shared by all registries.
+ @since v1.5.0
+ */
+@property (readonly) NSUInteger generation;
+
+/**
+ Latest generation of all registries
+ 
+ Partials inlined at this generation are current as long as it does not change.
+ @since v1.5.0
+ */
++ (NSUInteger) currentGeneration;
+
 /**
  Retrieve a partial by name using the objective-C keyed subscripting API
  
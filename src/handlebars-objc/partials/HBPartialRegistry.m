@@ -26,14 +26,34 @@
 //
 
 #import "HBPartialRegistry.h"
+#import "HBPartialRegistry_Private.h"
 #import "HBPartial.h"
 
 @interface HBPartialRegistry()
 @property (retain, nonatomic) NSMutableDictionary* partials;
+@property (readwrite) NSUInteger generation;
 @end
 
+// shared by all registries, so that a single comparison tells whether any of them changed
+static volatile NSUInteger hb_partial_registry_generation = 1;
+
 @implementation HBPartialRegistry
 
++ (NSUInteger) currentGeneration
+{
+    return hb_partial_registry_generation;
+}
+
++ (void) invalidateInlinedPartials
+{
+    __sync_add_and_fetch(&hb_partial_registry_generation, 1);
+}
+
+- (void) registryDidChange
+{
+    self.generation = __sync_add_and_fetch(&hb_partial_registry_generation, 1);
+}
+
 - (NSMutableDictionary*) partials
 {
     @synchronized(self) {
@@ -59,6 +79,7 @@
     @synchronized(self.partials) {
         self.partials[key] = partial;
     }
+    [self registryDidChange];
 }
 
 - (void) registerPartialString:(NSString*)partialString forName:(NSString*)partialName
@@ -93,6 +114,7 @@
     @synchronized(self.partials) {
         [self.partials removeObjectForKey:name];
     }
+    [self registryDidChange];
 }
 
 - (void) unregisterAllPartials;
@@ -100,6 +122,7 @@
     @synchronized(self.partials) {
         [self.partials removeAllObjects];
     }
+    [self registryDidChange];
 }
 
 // objc litteral compatibility
@@ -1,9 +1,8 @@
 //
-//  HBAstParserPostprocessingVisitor.h
+//  HBPartialRegistry_Private.h
 //  handlebars-objc
 //
-//  Created by Bertrand Guiheneuf on 3/23/14.
-//  Copyright (c) 2014 Fotonauts. All rights reserved.
+//  Created by Bertrand Guiheneuf on 10/17/26.
 //
 //  The MIT License
 //
@@ -26,8 +25,12 @@
 //  THE SOFTWARE.
 //
 
-#import "HBAstVisitor.h"
+#import "HBPartialRegistry.h"
 
-@interface HBAstParserPostprocessingVisitor : HBAstVisitor
+@interface HBPartialRegistry()
+
+// Moves every registry to a new generation, for changes made outside of registries that affect partial
+// resolution, such as the execution context a template shares.
++ (void) invalidateInlinedPartials;
 
 @end
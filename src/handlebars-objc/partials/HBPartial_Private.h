@@ -28,11 +28,18 @@
 #import "HBPartial.h"
 #import "HBAstProgram.h"
 
+@class HBArchivedProgram;
+@class HBBytecode;
+@class HBClosureTree;
+
 @interface HBPartial ()
 
 @property (retain, nonatomic) HBAstProgram* _program;
+@property (retain, nonatomic) HBArchivedProgram* archivedProgram; // precompiled partial, decoded instead of parsing string
 
 - (BOOL) compile:(NSError**)error;
 - (NSArray*) astStatements;
+- (HBBytecode*) bytecode; // statements lowered for the bytecode engine, generated the first time they are needed, nil when they do not fit. Partial must be compiled.
+- (HBClosureTree*) closureTree; // statements compiled for the closure engine, likewise
 
 @end
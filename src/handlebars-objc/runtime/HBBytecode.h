@@ -0,0 +1,109 @@
+//
+//  HBBytecode.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class HBAstEvaluationVisitor;
+
+//
+// Bytecode engine, see -[HBTemplate engine].
+//
+// Code is a flat array of instructions, generated from statements by HBAstBytecodeGenerationVisitor.
+// An instruction that needs operands is followed by the code computing them, in [pc + 1, operandsEnd).
+// Blocks are then followed by their statements in [operandsEnd, statementsEnd) and by their inverse
+// statements in [statementsEnd, end). Execution resumes at end.
+//
+// Values live in registers. An instruction that produces a value writes it to its register r, and the
+// code of its operands computes them to r + 1, r + 2... : positional parameters first, then named
+// parameters in the order of the parameters hash.
+//
+
+typedef NS_ENUM(uint8_t, HBBytecodeOpcode) {
+    HBBytecodeNop = 0,      // statement that renders nothing
+    HBBytecodeText,         // raw text. Constant is the HBAstRawText
+    HBBytecodeLiteral,      // r = constant, or nil with HBBytecodeNilLiteral
+    HBBytecodeLookup,       // r = key path lookup in current context. Constant is the HBAstContextualValue
+    HBBytecodeExpression,   // r = helper call, or key path lookup when the expression is not a helper call. Constant is the HBAstExpression
+    HBBytecodeEmit,         // renders r, escaped with HBBytecodeEscape
+    HBBytecodeBlock,        // block helper call, or section when the expression is not a helper call. Constant is the HBAstExpression
+    HBBytecodePartial,      // constant is the HBAstPartialTag, followed by the partial name. Operands are the context, then named parameters
+};
+
+// instruction flags
+enum {
+    HBBytecodeEscape = 1 << 0,
+    HBBytecodeNilLiteral = 1 << 1,
+    HBBytecodeHasParameters = 1 << 2,         // expression is a helper call whatever the registries contain
+    HBBytecodeHasPositionalParameters = 1 << 3, // array of positional parameters, possibly empty
+    HBBytecodeHasNamedParameters = 1 << 4,    // hash of named parameters, possibly empty
+    HBBytecodeHasContext = 1 << 5,            // partial tag with a context
+};
+
+// builtin block helpers, run inline by HBBytecodeBlock unless the application overrides them
+typedef NS_ENUM(uint8_t, HBBytecodeBuiltin) {
+    HBBytecodeBuiltinNone = 0,
+    HBBytecodeBuiltinIf,
+    HBBytecodeBuiltinUnless,
+    HBBytecodeBuiltinWith,
+    HBBytecodeBuiltinEach,
+};
+
+typedef struct {
+    HBBytecodeOpcode opcode;
+    HBBytecodeBuiltin builtin;
+    uint16_t flags;
+    uint16_t r;
+    uint16_t positionalCount;
+    uint32_t constant;
+    uint32_t operandsEnd;
+    uint32_t statementsEnd;
+    uint32_t end;
+} hb_bytecode_instruction;
+
+// Register file of the renders of a visitor. Statements take a frame of registerCount registers above the
+// top while they render: values are not retained, they live in the autorelease pool of the render.
+typedef struct {
+    id* values;
+    NSUInteger capacity;
+    NSUInteger top;
+} hb_bytecode_registers;
+
+@interface HBBytecode : NSObject
+
+@property (readonly, nonatomic) const hb_bytecode_instruction* instructions;
+@property (readonly, nonatomic) NSUInteger count;
+@property (readonly, nonatomic) NSUInteger registerCount;
+
+- (id) initWithInstructions:(const hb_bytecode_instruction*)instructions count:(NSUInteger)count constants:(NSArray*)constants registerCount:(NSUInteger)registerCount;
+
+- (id) constantAtIndex:(NSUInteger)index;
+
+// Run the code in the current context of visitor, appending to output
+- (void) renderWithVisitor:(HBAstEvaluationVisitor*)visitor toString:(NSMutableString*)output;
+- (void) renderWithVisitor:(HBAstEvaluationVisitor*)visitor toData:(NSMutableData*)output;
+
+@end
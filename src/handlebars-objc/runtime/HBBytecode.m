@@ -0,0 +1,381 @@
+//
+//  HBBytecode.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBBytecode.h"
+#import "HBRenderFunction.h"
+#import "HBRenderFunction_Private.h"
+#import "HBAstEvaluationVisitor.h"
+#import "HBAstEvaluationVisitor_Private.h"
+#import "HBAst.h"
+#import "HBContextStack.h"
+#import "HBContextState.h"
+#import "HBDataContext.h"
+#import "HBHelper.h"
+#import "HBPartial.h"
+#import "HBPartial_Private.h"
+
+// Blocks, helper calls and partials are rendered by the functions render functions use, see HBRenderFunction_Private.h
+
+// State of a rendering
+typedef struct {
+    HBAstEvaluationVisitor* visitor;
+    HBContextStack* contextStack;
+    hb_render_output output;
+    hb_bytecode_registers* registers; // of the visitor, see -[HBAstEvaluationVisitor bytecodeRegisters]
+} hb_vm;
+
+static NSString* const hb_vm_builtin_names[] = { nil, @"if", @"unless", @"with", @"each" };
+
+@implementation HBBytecode
+{
+    hb_bytecode_instruction* _instructions;
+    NSUInteger _count;
+    id* _constants;
+    NSUInteger _constantCount;
+    NSUInteger _registerCount;
+}
+
+- (id) initWithInstructions:(const hb_bytecode_instruction*)instructions count:(NSUInteger)count constants:(NSArray*)constants registerCount:(NSUInteger)registerCount
+{
+    self = [super init];
+    if (self) {
+        _count = count;
+        _instructions = malloc(MAX(count, 1) * sizeof(hb_bytecode_instruction));
+        memcpy(_instructions, instructions, count * sizeof(hb_bytecode_instruction));
+        
+        _constantCount = constants.count;
+        _constants = malloc(MAX(_constantCount, 1) * sizeof(id));
+        for (NSUInteger i = 0; i < _constantCount; i++) {
+            _constants[i] = [constants[i] retain];
+        }
+        
+        _registerCount = MAX(registerCount, 1);
+    }
+    return self;
+}
+
+- (const hb_bytecode_instruction*) instructions
+{
+    return _instructions;
+}
+
+- (NSUInteger) count
+{
+    return _count;
+}
+
+- (NSUInteger) registerCount
+{
+    return _registerCount;
+}
+
+- (id) constantAtIndex:(NSUInteger)index
+{
+    return _constants[index];
+}
+
+#pragma mark -
+#pragma mark Parameters
+
+// Parameters of an instruction, from its registers: positional parameters, then named parameters in the order
+// of the parameters hash. Positional parameters are NULL when the expression has none, and names when it has no hash.
+static inline const id* hb_vm_positional_parameters(const hb_bytecode_instruction* instruction, id* registers)
+{
+    return (instruction->flags & HBBytecodeHasPositionalParameters) ? registers + instruction->r + 1 : NULL;
+}
+
+static inline NSString* const* hb_vm_names(const hb_bytecode_instruction* instruction, HBAstParametersHash* hash)
+{
+    return (instruction->flags & HBBytecodeHasNamedParameters) ? hash.names : NULL;
+}
+
+static inline const id* hb_vm_named_values(const hb_bytecode_instruction* instruction, id* registers)
+{
+    return registers + instruction->r + 1 + instruction->positionalCount;
+}
+
+#pragma mark -
+#pragma mark Statements
+
+static void hb_vm_run(hb_vm* vm, HBBytecode* code, NSUInteger pc, NSUInteger end, NSUInteger base);
+
+// Registers of the frame starting at base. The register file grows when statements nest deeper than it
+// did before, so frames are addressed by their base: pointers do not survive rendering statements.
+static inline id* hb_vm_frame(hb_vm* vm, NSUInteger base)
+{
+    return vm->registers->values + base;
+}
+
+// statements get a frame of their own, above the registers in use: helpers may evaluate them while the
+// instruction that called them still needs its registers, and each evaluation clears its frame
+static void hb_vm_render(hb_vm* vm, HBBytecode* code, NSUInteger begin, NSUInteger end)
+{
+    if (begin == end) return;
+    
+    hb_bytecode_registers* registers = vm->registers;
+    NSUInteger base = registers->top;
+    NSUInteger count = code->_registerCount;
+    if (base + count > registers->capacity) {
+        NSUInteger capacity = MAX(MAX(2 * registers->capacity, base + count), (NSUInteger)32);
+        registers->values = realloc(registers->values, capacity * sizeof(id));
+        registers->capacity = capacity;
+    }
+    memset(registers->values + base, 0, count * sizeof(id));
+    registers->top = base + count;
+    hb_vm_run(vm, code, begin, end, base);
+    registers->top = base;
+}
+
+static void hb_vm_render_statements(hb_vm* vm, HBBytecode* code, NSUInteger begin, NSUInteger end, id context, HBDataContext* data, BOOL pushContext)
+{
+    if (begin == end) return;
+    
+    if (pushContext) [vm->contextStack push:[HBContextState stateWithContext:context data:data]];
+    hb_vm_render(vm, code, begin, end);
+    if (pushContext) [vm->contextStack pop];
+}
+
+// statements evaluators, as passed to helpers. Empty statements evaluate to nil.
+static NSString* hb_vm_evaluate_statements(HBAstEvaluationVisitor* visitor, HBBytecode* code, NSUInteger begin, NSUInteger end, id context, HBDataContext* data, BOOL pushContext)
+{
+    if (begin == end) return nil;
+    
+    NSMutableString* result = [NSMutableString string];
+    hb_vm vm = { visitor, visitor.contextStack, { result, nil }, visitor.bytecodeRegisters };
+    hb_vm_render_statements(&vm, code, begin, end, context, data, pushContext);
+    return result;
+}
+
+// statements of a block instruction, in [operandsEnd, statementsEnd), and its inverse statements, in [statementsEnd, end)
+typedef struct {
+    hb_vm* vm;
+    HBBytecode* code;
+    const hb_bytecode_instruction* instruction;
+} hb_vm_block;
+
+static void hb_vm_block_body(void* block, BOOL inverse, id context, HBDataContext* data, BOOL pushContext)
+{
+    hb_vm_block* vmBlock = block;
+    const hb_bytecode_instruction* instruction = vmBlock->instruction;
+    if (inverse) {
+        hb_vm_render_statements(vmBlock->vm, vmBlock->code, instruction->statementsEnd, instruction->end, context, data, pushContext);
+    } else {
+        hb_vm_render_statements(vmBlock->vm, vmBlock->code, instruction->operandsEnd, instruction->statementsEnd, context, data, pushContext);
+    }
+}
+
+#pragma mark -
+#pragma mark Helpers
+
+static id hb_vm_call_helper(hb_vm* vm, HBBytecode* code, const hb_bytecode_instruction* instruction, HBHelper* helper, HBAstExpression* expression, id* registers, HBHelperInvocationKind kind)
+{
+    HBStatementsEvaluator statements = nil;
+    HBStatementsEvaluator inverseStatements = nil;
+    if (kind == HBHelperInvocationBlock) {
+        HBAstEvaluationVisitor* visitor = vm->visitor;
+        NSUInteger statementsBegin = instruction->operandsEnd;
+        NSUInteger statementsEnd = instruction->statementsEnd;
+        NSUInteger end = instruction->end;
+        statements = ^(id context, HBDataContext* data) {
+            return hb_vm_evaluate_statements(visitor, code, statementsBegin, statementsEnd, context, data, true);
+        };
+        inverseStatements = ^(id context, HBDataContext* data) {
+            return hb_vm_evaluate_statements(visitor, code, statementsEnd, end, nil, nil, false);
+        };
+    }
+    
+    HBAstParametersHash* hash = expression.namedParameters;
+    return hb_render_invoke_helper(vm->visitor, helper, kind, hb_vm_positional_parameters(instruction, registers), instruction->positionalCount,
+                                   hb_vm_names(instruction, hash), hb_vm_named_values(instruction, registers), hash.count,
+                                   statements, inverseStatements);
+}
+
+// builtin if, unless, with and each helpers, when they are not overridden
+static void hb_vm_builtin(hb_vm* vm, HBBytecode* code, const hb_bytecode_instruction* instruction, HBAstExpression* expression, id* registers)
+{
+    hb_vm_block block = { vm, code, instruction };
+    hb_render_body body = { hb_vm_block_body, &block };
+    const id* positionalParameters = hb_vm_positional_parameters(instruction, registers);
+    HBAstParametersHash* hash = expression.namedParameters;
+    
+    switch (instruction->builtin) {
+        case HBBytecodeBuiltinIf:
+        case HBBytecodeBuiltinUnless:
+            hb_render_if_body(vm->visitor, instruction->builtin == HBBytecodeBuiltinUnless, positionalParameters, instruction->positionalCount,
+                              hb_vm_names(instruction, hash), hb_vm_named_values(instruction, registers), hash.count, &body);
+            break;
+        case HBBytecodeBuiltinWith:
+            hb_render_with_body(vm->visitor, positionalParameters, instruction->positionalCount, &body);
+            break;
+        case HBBytecodeBuiltinEach:
+            hb_render_each_body(vm->visitor, positionalParameters, instruction->positionalCount, &body);
+            break;
+        case HBBytecodeBuiltinNone:
+            break;
+    }
+}
+
+static void hb_vm_section(hb_vm* vm, HBBytecode* code, const hb_bytecode_instruction* instruction, id value)
+{
+    hb_vm_block block = { vm, code, instruction };
+    hb_render_body body = { hb_vm_block_body, &block };
+    hb_render_section_body(vm->visitor, value, &body);
+}
+
+#pragma mark -
+#pragma mark Partials
+
+static void hb_vm_partial(hb_vm* vm, HBBytecode* code, const hb_bytecode_instruction* instruction, NSUInteger pc, NSUInteger base)
+{
+    HBAstEvaluationVisitor* visitor = vm->visitor;
+    HBAstPartialTag* node = code->_constants[instruction->constant];
+    HBPartial* partial = hb_render_partial(visitor, code->_constants[instruction->constant + 1]);
+    if (!partial) return;
+    
+    hb_vm_run(vm, code, pc + 1, instruction->operandsEnd, base);
+    
+    BOOL hasContext = (instruction->flags & HBBytecodeHasContext) != 0;
+    if (hasContext) hb_render_push_context(visitor, hb_vm_frame(vm, base)[instruction->r]);
+    
+    if (instruction->flags & HBBytecodeHasNamedParameters) {
+        HBAstParametersHash* hash = node.namedParameters;
+        hb_render_merge_attributes(visitor, hash.names, hb_vm_named_values(instruction, hb_vm_frame(vm, base)), hash.count);
+    }
+    
+    HBBytecode* partialCode = partial.bytecode;
+    if (partialCode) {
+        hb_vm_render(vm, partialCode, 0, partialCode->_count);
+    } else {
+        // too large for the instruction format: interpreted
+        for (HBAstNode* statement in partial.astStatements) hb_render_output_append(vm->output, [visitor visitNode:statement]);
+    }
+    
+    if (hasContext) hb_render_pop_context(visitor);
+}
+
+#pragma mark -
+#pragma mark Machine
+
+static void hb_vm_run(hb_vm* vm, HBBytecode* code, NSUInteger pc, NSUInteger end, NSUInteger base)
+{
+    const hb_bytecode_instruction* instructions = code->_instructions;
+    id* constants = code->_constants;
+    
+    while (pc < end) {
+        const hb_bytecode_instruction* instruction = instructions + pc;
+        
+        switch (instruction->opcode) {
+            case HBBytecodeNop:
+                break;
+                
+            case HBBytecodeText:
+                hb_render_output_append_text(vm->output, constants[instruction->constant]);
+                break;
+                
+            case HBBytecodeLiteral:
+                hb_vm_frame(vm, base)[instruction->r] = (instruction->flags & HBBytecodeNilLiteral) ? nil : constants[instruction->constant];
+                break;
+                
+            case HBBytecodeLookup: {
+                id value = [vm->contextStack.current evaluateContextualValue:constants[instruction->constant]];
+                hb_vm_frame(vm, base)[instruction->r] = value;
+                break;
+            }
+                
+            case HBBytecodeExpression: {
+                HBAstExpression* expression = constants[instruction->constant];
+                HBHelper* helper = [vm->visitor helperForExpression:expression];
+                id value = nil;
+                if (helper) {
+                    hb_vm_run(vm, code, pc + 1, instruction->operandsEnd, base);
+                    value = hb_vm_call_helper(vm, code, instruction, helper, expression, hb_vm_frame(vm, base), HBHelperInvocationExpression);
+                } else if (instruction->flags & HBBytecodeHasParameters) {
+                    value = hb_render_missing_helper(vm->visitor, [expression.mainValue.keyPath[0] key]);
+                } else {
+                    value = [vm->contextStack.current evaluateContextualValue:expression.mainValue];
+                }
+                // helpers may have rendered statements, and moved the register file
+                hb_vm_frame(vm, base)[instruction->r] = value;
+                break;
+            }
+                
+            case HBBytecodeEmit:
+                hb_render_output_append_value(vm->visitor, vm->output, hb_vm_frame(vm, base)[instruction->r], (instruction->flags & HBBytecodeEscape) != 0);
+                break;
+                
+            case HBBytecodeBlock: {
+                HBAstExpression* expression = constants[instruction->constant];
+                HBHelper* helper = [vm->visitor helperForExpression:expression];
+                if (helper) {
+                    hb_vm_run(vm, code, pc + 1, instruction->operandsEnd, base);
+                    if (instruction->builtin != HBBytecodeBuiltinNone && hb_render_is_builtin_helper(helper, hb_vm_builtin_names[instruction->builtin])) {
+                        hb_vm_builtin(vm, code, instruction, expression, hb_vm_frame(vm, base));
+                    } else {
+                        hb_render_output_append(vm->output, hb_vm_call_helper(vm, code, instruction, helper, expression, hb_vm_frame(vm, base), HBHelperInvocationBlock));
+                    }
+                } else if (instruction->flags & HBBytecodeHasParameters) {
+                    hb_render_missing_helper(vm->visitor, [expression.mainValue.keyPath[0] key]);
+                } else {
+                    hb_vm_section(vm, code, instruction, [vm->contextStack.current evaluateContextualValue:expression.mainValue]);
+                }
+                break;
+            }
+                
+            case HBBytecodePartial:
+                hb_vm_partial(vm, code, instruction, pc, base);
+                break;
+        }
+        
+        pc = instruction->end;
+    }
+}
+
+#pragma mark -
+
+- (void) renderWithVisitor:(HBAstEvaluationVisitor*)visitor toString:(NSMutableString*)output
+{
+    hb_vm vm = { visitor, visitor.contextStack, { output, nil }, visitor.bytecodeRegisters };
+    hb_vm_render(&vm, self, 0, _count);
+}
+
+- (void) renderWithVisitor:(HBAstEvaluationVisitor*)visitor toData:(NSMutableData*)output
+{
+    hb_vm vm = { visitor, visitor.contextStack, { nil, output }, visitor.bytecodeRegisters };
+    hb_vm_render(&vm, self, 0, _count);
+}
+
+- (void) dealloc
+{
+    for (NSUInteger i = 0; i < _constantCount; i++) {
+        [_constants[i] release];
+    }
+    free(_constants);
+    free(_instructions);
+    [super dealloc];
+}
+
+@end
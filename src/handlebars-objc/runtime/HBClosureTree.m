@@ -0,0 +1,481 @@
+//
+//  HBClosureTree.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBClosureTree.h"
+#import "HBRenderFunction.h"
+#import "HBRenderFunction_Private.h"
+#import "HBAstEvaluationVisitor.h"
+#import "HBAstEvaluationVisitor_Private.h"
+#import "HBAst.h"
+#import "HBContextStack.h"
+#import "HBContextState.h"
+#import "HBDataContext.h"
+#import "HBHelper.h"
+#import "HBPartial.h"
+#import "HBPartial_Private.h"
+
+// Blocks, helper calls and partials are rendered by the functions render functions use, see HBRenderFunction_Private.h
+
+typedef struct hb_closure hb_closure;
+
+// State of a rendering
+typedef struct {
+    HBClosureTree* tree;
+    HBAstEvaluationVisitor* visitor;
+    HBContextStack* contextStack;
+    hb_render_output output;
+} hb_closure_state;
+
+// Closures compiled from values return the value. Closures compiled from statements append to output and return nil.
+typedef id (*hb_closure_function)(const hb_closure* closure, hb_closure_state* state);
+
+// builtin block helpers, run inline unless the application overrides them
+typedef NS_ENUM(NSUInteger, HBClosureBuiltin) {
+    HBClosureBuiltinNone = 0,
+    HBClosureBuiltinIf,
+    HBClosureBuiltinUnless,
+    HBClosureBuiltinWith,
+    HBClosureBuiltinEach,
+};
+
+static NSString* const hb_closure_builtin_names[] = { nil, @"if", @"unless", @"with", @"each" };
+
+struct hb_closure {
+    hb_closure_function function;
+    id node;                        // AST node the closure was compiled from
+    id constant;                    // literal value, or name of a partial
+    hb_closure** operands;          // expressions: positional parameters, then named parameters in the order of the parameters hash.
+    NSUInteger operandCount;        // partials: context if any, then named parameters
+    NSUInteger positionalCount;
+    hb_closure** statements;
+    NSUInteger statementCount;
+    hb_closure** inverseStatements;
+    NSUInteger inverseStatementCount;
+    BOOL hasParameters;             // expression is a helper call whatever the registries contain
+    BOOL hasPositionalParameters;   // array of positional parameters, possibly empty
+    BOOL hasNamedParameters;        // hash of named parameters, possibly empty
+    BOOL hasContext;                // partial tag with a context
+    HBClosureBuiltin builtin;
+};
+
+@interface HBClosureTree()
+{
+    hb_closure** _statements;
+    NSUInteger _statementCount;
+}
+- (void) renderWithState:(hb_closure_state*)state;
+@end
+
+#pragma mark -
+#pragma mark Parameters
+
+static void hb_closure_evaluate_operands(const hb_closure* closure, hb_closure_state* state, id* values)
+{
+    for (NSUInteger i = 0; i < closure->operandCount; i++) {
+        hb_closure* operand = closure->operands[i];
+        values[i] = operand->function(operand, state);
+    }
+}
+
+// Parameters of an expression, from the values of its operands: positional parameters, then named parameters in the
+// order of the parameters hash. Positional parameters are NULL when the expression has none, and names when it has no hash.
+static inline const id* hb_closure_positional_parameters(const hb_closure* closure, const id* values)
+{
+    return closure->hasPositionalParameters ? values : NULL;
+}
+
+static inline NSString* const* hb_closure_names(const hb_closure* closure, HBAstParametersHash* hash)
+{
+    return closure->hasNamedParameters ? hash.names : NULL;
+}
+
+#pragma mark -
+#pragma mark Statements
+
+static void hb_closure_render(hb_closure_state* state, hb_closure** statements, NSUInteger count)
+{
+    for (NSUInteger i = 0; i < count; i++) {
+        hb_closure* statement = statements[i];
+        statement->function(statement, state);
+    }
+}
+
+static void hb_closure_render_statements(hb_closure_state* state, hb_closure** statements, NSUInteger count, id context, HBDataContext* data, BOOL pushContext)
+{
+    if (count == 0) return;
+    
+    if (pushContext) [state->contextStack push:[HBContextState stateWithContext:context data:data]];
+    hb_closure_render(state, statements, count);
+    if (pushContext) [state->contextStack pop];
+}
+
+// statements evaluators, as passed to helpers. Empty statements evaluate to nil.
+static NSString* hb_closure_evaluate_statements(HBClosureTree* tree, HBAstEvaluationVisitor* visitor, hb_closure** statements, NSUInteger count, id context, HBDataContext* data, BOOL pushContext)
+{
+    if (count == 0) return nil;
+    
+    NSMutableString* result = [NSMutableString string];
+    hb_closure_state state = { tree, visitor, visitor.contextStack, { result, nil } };
+    hb_closure_render_statements(&state, statements, count, context, data, pushContext);
+    return result;
+}
+
+// statements and inverse statements of the closure of a block
+typedef struct {
+    hb_closure_state* state;
+    const hb_closure* closure;
+} hb_closure_block;
+
+static void hb_closure_block_body(void* block, BOOL inverse, id context, HBDataContext* data, BOOL pushContext)
+{
+    hb_closure_block* closureBlock = block;
+    const hb_closure* closure = closureBlock->closure;
+    if (inverse) {
+        hb_closure_render_statements(closureBlock->state, closure->inverseStatements, closure->inverseStatementCount, context, data, pushContext);
+    } else {
+        hb_closure_render_statements(closureBlock->state, closure->statements, closure->statementCount, context, data, pushContext);
+    }
+}
+
+#pragma mark -
+#pragma mark Helpers
+
+static id hb_closure_call_helper(const hb_closure* closure, hb_closure_state* state, HBHelper* helper, const id* values, HBHelperInvocationKind kind)
+{
+    HBStatementsEvaluator statements = nil;
+    HBStatementsEvaluator inverseStatements = nil;
+    if (kind == HBHelperInvocationBlock) {
+        HBClosureTree* tree = state->tree;
+        HBAstEvaluationVisitor* visitor = state->visitor;
+        statements = ^(id context, HBDataContext* data) {
+            return hb_closure_evaluate_statements(tree, visitor, closure->statements, closure->statementCount, context, data, true);
+        };
+        inverseStatements = ^(id context, HBDataContext* data) {
+            return hb_closure_evaluate_statements(tree, visitor, closure->inverseStatements, closure->inverseStatementCount, nil, nil, false);
+        };
+    }
+    
+    HBAstParametersHash* hash = [(HBAstExpression*)closure->node namedParameters];
+    return hb_render_invoke_helper(state->visitor, helper, kind, hb_closure_positional_parameters(closure, values), closure->positionalCount,
+                                   hb_closure_names(closure, hash), values + closure->positionalCount, hash.count,
+                                   statements, inverseStatements);
+}
+
+// builtin if, unless, with and each helpers, when they are not overridden
+static void hb_closure_builtin(const hb_closure* closure, hb_closure_state* state, const id* values)
+{
+    hb_closure_block block = { state, closure };
+    hb_render_body body = { hb_closure_block_body, &block };
+    const id* positionalParameters = hb_closure_positional_parameters(closure, values);
+    HBAstParametersHash* hash = [(HBAstExpression*)closure->node namedParameters];
+    
+    switch (closure->builtin) {
+        case HBClosureBuiltinIf:
+        case HBClosureBuiltinUnless:
+            hb_render_if_body(state->visitor, closure->builtin == HBClosureBuiltinUnless, positionalParameters, closure->positionalCount,
+                              hb_closure_names(closure, hash), values + closure->positionalCount, hash.count, &body);
+            break;
+        case HBClosureBuiltinWith:
+            hb_render_with_body(state->visitor, positionalParameters, closure->positionalCount, &body);
+            break;
+        case HBClosureBuiltinEach:
+            hb_render_each_body(state->visitor, positionalParameters, closure->positionalCount, &body);
+            break;
+        case HBClosureBuiltinNone:
+            break;
+    }
+}
+
+static void hb_closure_section(const hb_closure* closure, hb_closure_state* state, id value)
+{
+    hb_closure_block block = { state, closure };
+    hb_render_body body = { hb_closure_block_body, &block };
+    hb_render_section_body(state->visitor, value, &body);
+}
+
+#pragma mark -
+#pragma mark Closure functions
+
+static id hb_closure_nop(const hb_closure* closure, hb_closure_state* state)
+{
+    return nil;
+}
+
+static id hb_closure_text(const hb_closure* closure, hb_closure_state* state)
+{
+    hb_render_output_append_text(state->output, closure->node);
+    return nil;
+}
+
+static id hb_closure_literal(const hb_closure* closure, hb_closure_state* state)
+{
+    return closure->constant;
+}
+
+static id hb_closure_lookup(const hb_closure* closure, hb_closure_state* state)
+{
+    return [state->contextStack.current evaluateContextualValue:closure->node];
+}
+
+static id hb_closure_expression(const hb_closure* closure, hb_closure_state* state)
+{
+    HBAstExpression* expression = closure->node;
+    HBHelper* helper = [state->visitor helperForExpression:expression];
+    if (helper) {
+        id values[closure->operandCount + 1];
+        hb_closure_evaluate_operands(closure, state, values);
+        return hb_closure_call_helper(closure, state, helper, values, HBHelperInvocationExpression);
+    }
+    if (closure->hasParameters) return hb_render_missing_helper(state->visitor, [expression.mainValue.keyPath[0] key]);
+    return [state->contextStack.current evaluateContextualValue:expression.mainValue];
+}
+
+static id hb_closure_escaped_tag(const hb_closure* closure, hb_closure_state* state)
+{
+    hb_closure* value = closure->operands[0];
+    hb_render_output_append_value(state->visitor, state->output, value->function(value, state), YES);
+    return nil;
+}
+
+static id hb_closure_raw_tag(const hb_closure* closure, hb_closure_state* state)
+{
+    hb_closure* value = closure->operands[0];
+    hb_render_output_append_value(state->visitor, state->output, value->function(value, state), NO);
+    return nil;
+}
+
+static id hb_closure_block(const hb_closure* closure, hb_closure_state* state)
+{
+    HBAstExpression* expression = closure->node;
+    HBHelper* helper = [state->visitor helperForExpression:expression];
+    if (helper) {
+        id values[closure->operandCount + 1];
+        hb_closure_evaluate_operands(closure, state, values);
+        if (closure->builtin != HBClosureBuiltinNone && hb_render_is_builtin_helper(helper, hb_closure_builtin_names[closure->builtin])) {
+            hb_closure_builtin(closure, state, values);
+        } else {
+            hb_render_output_append(state->output, hb_closure_call_helper(closure, state, helper, values, HBHelperInvocationBlock));
+        }
+    } else if (closure->hasParameters) {
+        hb_render_missing_helper(state->visitor, [expression.mainValue.keyPath[0] key]);
+    } else {
+        hb_closure_section(closure, state, [state->contextStack.current evaluateContextualValue:expression.mainValue]);
+    }
+    return nil;
+}
+
+static id hb_closure_partial(const hb_closure* closure, hb_closure_state* state)
+{
+    HBAstEvaluationVisitor* visitor = state->visitor;
+    HBPartial* partial = hb_render_partial(visitor, closure->constant);
+    if (!partial) return nil;
+    
+    id values[closure->operandCount + 1];
+    hb_closure_evaluate_operands(closure, state, values);
+    
+    if (closure->hasContext) hb_render_push_context(visitor, values[0]);
+    
+    if (closure->hasNamedParameters) {
+        HBAstParametersHash* hash = [(HBAstPartialTag*)closure->node namedParameters];
+        hb_render_merge_attributes(visitor, hash.names, values + (closure->hasContext ? 1 : 0), hash.count);
+    }
+    
+    hb_closure_state partialState = *state;
+    [partial.closureTree renderWithState:&partialState];
+    
+    if (closure->hasContext) hb_render_pop_context(visitor);
+    return nil;
+}
+
+#pragma mark -
+#pragma mark Compilation
+
+static hb_closure* hb_closure_compile(HBAstNode* node);
+
+static hb_closure** hb_closure_compile_all(NSArray* nodes, NSUInteger* count)
+{
+    *count = nodes.count;
+    if (nodes.count == 0) return NULL;
+    
+    hb_closure** closures = malloc(nodes.count * sizeof(hb_closure*));
+    NSUInteger i = 0;
+    for (HBAstNode* node in nodes) {
+        closures[i++] = hb_closure_compile(node);
+    }
+    return closures;
+}
+
+static hb_closure* hb_closure_create(hb_closure_function function, id node)
+{
+    hb_closure* closure = calloc(1, sizeof(hb_closure));
+    closure->function = function;
+    closure->node = [node retain];
+    return closure;
+}
+
+// parameters are compiled in the order they are evaluated: positional parameters first, then named parameters
+static void hb_closure_compile_parameters(hb_closure* closure, HBAstExpression* expression)
+{
+    NSMutableArray* operands = [NSMutableArray arrayWithArray:expression.positionalParameters];
+    for (NSString* name in expression.namedParameters) {
+        [operands addObject:expression.namedParameters[name]];
+    }
+    closure->operands = hb_closure_compile_all(operands, &closure->operandCount);
+    closure->positionalCount = expression.positionalParameters.count;
+    closure->hasPositionalParameters = (expression.positionalParameters != nil);
+    closure->hasNamedParameters = (expression.namedParameters != nil);
+    closure->hasParameters = (expression.positionalParameters.count > 0 || expression.namedParameters.count > 0);
+}
+
+static HBClosureBuiltin hb_closure_builtin_of_expression(HBAstExpression* expression)
+{
+    HBAstContextualValue* mainValue = expression.mainValue;
+    if (mainValue.isDataValue || mainValue.keyPath.count != 1) return HBClosureBuiltinNone;
+    
+    NSString* name = [mainValue.keyPath[0] key];
+    if ([name isEqualToString:@"if"]) return HBClosureBuiltinIf;
+    if ([name isEqualToString:@"unless"]) return HBClosureBuiltinUnless;
+    if ([name isEqualToString:@"with"]) return HBClosureBuiltinWith;
+    if ([name isEqualToString:@"each"]) return HBClosureBuiltinEach;
+    return HBClosureBuiltinNone;
+}
+
+static hb_closure* hb_closure_compile(HBAstNode* node)
+{
+    if ([node isKindOfClass:[HBAstRawText class]]) {
+        return hb_closure_create(hb_closure_text, node);
+    }
+    
+    if ([node isKindOfClass:[HBAstSimpleTag class]]) {
+        HBAstSimpleTag* tag = (HBAstSimpleTag*)node;
+        if (!tag.expression) return hb_closure_create(hb_closure_nop, node);
+        hb_closure* closure = hb_closure_create(tag.escape ? hb_closure_escaped_tag : hb_closure_raw_tag, node);
+        closure->operands = hb_closure_compile_all(@[ tag.expression ], &closure->operandCount);
+        return closure;
+    }
+    
+    if ([node isKindOfClass:[HBAstBlock class]]) {
+        HBAstBlock* block = (HBAstBlock*)node;
+        hb_closure* closure = hb_closure_create(hb_closure_block, block.expression);
+        hb_closure_compile_parameters(closure, block.expression);
+        closure->builtin = hb_closure_builtin_of_expression(block.expression);
+        closure->statements = hb_closure_compile_all(block.statements, &closure->statementCount);
+        closure->inverseStatements = hb_closure_compile_all(block.inverseStatements, &closure->inverseStatementCount);
+        return closure;
+    }
+    
+    if ([node isKindOfClass:[HBAstPartialTag class]]) {
+        HBAstPartialTag* tag = (HBAstPartialTag*)node;
+        hb_closure* closure = hb_closure_create(hb_closure_partial, node);
+        closure->constant = [[tag.partialName sourceRepresentation] retain];
+        NSMutableArray* operands = [NSMutableArray array];
+        if (tag.context) [operands addObject:tag.context];
+        for (NSString* name in tag.namedParameters) {
+            [operands addObject:tag.namedParameters[name]];
+        }
+        closure->operands = hb_closure_compile_all(operands, &closure->operandCount);
+        closure->hasContext = (tag.context != nil);
+        closure->hasNamedParameters = (tag.namedParameters != nil);
+        return closure;
+    }
+    
+    if ([node isKindOfClass:[HBAstExpression class]]) {
+        hb_closure* closure = hb_closure_create(hb_closure_expression, node);
+        hb_closure_compile_parameters(closure, (HBAstExpression*)node);
+        return closure;
+    }
+    
+    if ([node isKindOfClass:[HBAstContextualValue class]]) {
+        return hb_closure_create(hb_closure_lookup, node);
+    }
+    
+    if ([node isKindOfClass:[HBAstString class]] || [node isKindOfClass:[HBAstNumber class]]) {
+        hb_closure* closure = hb_closure_create(hb_closure_literal, node);
+        closure->constant = [[(HBAstString*)node litteralValue] retain];
+        return closure;
+    }
+    
+    // comments, tags and other values render nothing
+    return hb_closure_create(hb_closure_nop, node);
+}
+
+static void hb_closure_free_all(hb_closure** closures, NSUInteger count);
+
+static void hb_closure_free(hb_closure* closure)
+{
+    hb_closure_free_all(closure->operands, closure->operandCount);
+    hb_closure_free_all(closure->statements, closure->statementCount);
+    hb_closure_free_all(closure->inverseStatements, closure->inverseStatementCount);
+    [closure->node release];
+    [closure->constant release];
+    free(closure);
+}
+
+static void hb_closure_free_all(hb_closure** closures, NSUInteger count)
+{
+    for (NSUInteger i = 0; i < count; i++) {
+        hb_closure_free(closures[i]);
+    }
+    free(closures);
+}
+
+#pragma mark -
+
+@implementation HBClosureTree
+
++ (instancetype) closureTreeForStatements:(NSArray*)statements
+{
+    HBClosureTree* tree = [[self alloc] init];
+    tree->_statements = hb_closure_compile_all(statements, &tree->_statementCount);
+    return [tree autorelease];
+}
+
+- (void) renderWithVisitor:(HBAstEvaluationVisitor*)visitor toString:(NSMutableString*)output
+{
+    hb_closure_state state = { self, visitor, visitor.contextStack, { output, nil } };
+    [self renderWithState:&state];
+}
+
+- (void) renderWithVisitor:(HBAstEvaluationVisitor*)visitor toData:(NSMutableData*)output
+{
+    hb_closure_state state = { self, visitor, visitor.contextStack, { nil, output } };
+    [self renderWithState:&state];
+}
+
+- (void) renderWithState:(hb_closure_state*)state
+{
+    state->tree = self;
+    hb_closure_render(state, _statements, _statementCount);
+}
+
+- (void) dealloc
+{
+    hb_closure_free_all(_statements, _statementCount);
+    [super dealloc];
+}
+
+@end
@@ -28,6 +28,7 @@
 #import <Foundation/Foundation.h>
 #import "HBHelper.h"
 #import "HBExecutionContextDelegate.h"
+#import "HBRenderFunction.h"
 
 @class HBHelperRegistry;
 @class HBPartialRegistry;
@@ -80,6 +81,42 @@
  */
 - (HBTemplate*) templateWithString:(NSString*)string;
 
+/**
+ Creates a template read from a UTF-8 file, that has access to the helpers and partials from the receiver.
+ 
+ The file is mapped and parsed when the template is compiled. See <[HBTemplate initWithContentsOfFile:]>.
+ @param path path of the template file
+ @since v1.5.0
+ */
+- (HBTemplate*) templateWithContentsOfFile:(NSString*)path;
+
+/**
+ Creates a template read from a UTF-8 stream, that has access to the helpers and partials from the receiver.
+ 
+ The stream is read when the template is compiled. See <[HBTemplate initWithInputStream:]>.
+ @param stream stream to read the template from
+ @since v1.5.0
+ */
+- (HBTemplate*) templateWithInputStream:(NSInputStream*)stream;
+
+/**
+ Creates a template from UTF-8 data, that has access to the helpers and partials from the receiver.
+ 
+ See <[HBTemplate initWithUTF8Data:]>.
+ @param data UTF-8 template
+ @since v1.5.0
+ */
+- (HBTemplate*) templateWithUTF8Data:(NSData*)data;
+
+/**
+ Creates a template from a render function generated ahead of time, that has access to the helpers and partials from the receiver.
+ 
+ See <[HBTemplate initWithRenderFunction:]>.
+ @param renderFunction render function generated by hbs-codegen
+ @since v1.5.0
+ */
+- (HBTemplate*) templateWithRenderFunction:(HBRenderFunction)renderFunction;
+
 /** @name managing helpers */
 
 /** 
@@ -176,10 +213,75 @@
  */
 - (HBPartial*) partialForName:(NSString*)name;
 
+/** @name Compiling templates in batch */
+
+/**
+ Compile a set of templates and partials concurrently
+
+ Templates and partials are normally compiled lazily, the first time they are rendered. This method lets you pay the whole compilation cost upfront (at application launch for instance) and spreads the work over all available cores.
+
+ Partials are registered in the receiving execution context before being compiled. Returned templates are created using <templateWithString:> and are thus bound to the receiver. Templates and partials that fail to compile are reported in the error dictionaries. Failing templates are still part of the returned dictionary, rendering them will report the parse error again.
+
+ @param templateStrings an NSDictionary whose keys are template names and values are template strings
+ @param partialStrings an NSDictionary whose keys are partial names and values are partial strings. Can be nil.
+ @param templateErrors pointer to a dictionary that is set to the parse errors of templates, keyed by template name. Can be NULL.
+ @param partialErrors pointer to a dictionary that is set to the parse errors of partials, keyed by partial name. Can be NULL.
+ @param compilationTime pointer to a time interval that is set to the wall-clock duration of the whole compilation. Can be NULL.
+ @return an NSDictionary whose keys are template names and values are compiled HBTemplate objects
+ @since v1.5.0
+ */
+- (NSDictionary*) compileTemplateStrings:(NSDictionary* /* NSString -> NSString */)templateStrings
+                          partialStrings:(NSDictionary* /* NSString -> NSString */)partialStrings
+                          templateErrors:(NSDictionary**)templateErrors
+                           partialErrors:(NSDictionary**)partialErrors
+                         compilationTime:(NSTimeInterval*)compilationTime;
+
+/** @name Precompiled templates */
+
+/**
+ Compile templates and partials into a precompiled archive
+ 
+ Compiled templates and partials are written in a compact binary format that can be loaded with <templatesWithContentsOfPrecompiledFile:error:> without running the parser at all. Use this method when building your application to precompile a fixed set of templates, and write the result to a file shipped along with it.
+ 
+ The receiver is not modified: partials are compiled on their own and are not registered.
+ 
+ @param templateStrings an NSDictionary whose keys are template names and values are template strings
+ @param partialStrings an NSDictionary whose keys are partial names and values are partial strings. Can be nil.
+ @param templateErrors pointer to a dictionary that is set to the parse errors of templates, keyed by template name. Can be NULL.
+ @param partialErrors pointer to a dictionary that is set to the parse errors of partials, keyed by partial name. Can be NULL.
+ @return the precompiled archive, or nil if a template or partial failed to compile
+ @since v1.5.0
+ */
+- (NSData*) precompiledDataWithTemplateStrings:(NSDictionary* /* NSString -> NSString */)templateStrings
+                                partialStrings:(NSDictionary* /* NSString -> NSString */)partialStrings
+                                templateErrors:(NSDictionary**)templateErrors
+                                 partialErrors:(NSDictionary**)partialErrors;
 
+/**
+ Load templates and partials from a precompiled archive file
+ 
+ The file is mapped in memory: loading it only reads the names of its templates and partials. Each of them is decoded the first time it is rendered, and static text is only copied out of the file when needed.
+ 
+ Partials of the archive are registered in the receiver. Returned templates are bound to the receiver, like templates created with <templateWithString:>.
+ 
+ @param path path of a file written with the result of <precompiledDataWithTemplateStrings:partialStrings:templateErrors:partialErrors:>
+ @param error pointer to an error object that is set if the file can't be read or is not a valid archive. Archives built by another version of handlebars-objc may be rejected.
+ @return an NSDictionary whose keys are template names and values are HBTemplate objects, or nil if an error occurred
+ @since v1.5.0
+ */
+- (NSDictionary*) templatesWithContentsOfPrecompiledFile:(NSString*)path error:(NSError**)error;
 
+/**
+ Load templates and partials from a precompiled archive
  
+ Same as <templatesWithContentsOfPrecompiledFile:error:>, for an archive already in memory. Templates keep a reference to data.
  
+ @param data a precompiled archive
+ @param error pointer to an error object that is set if data is not a valid archive
+ @return an NSDictionary whose keys are template names and values are HBTemplate objects, or nil if an error occurred
+ @since v1.5.0
+ */
+- (NSDictionary*) templatesWithPrecompiledData:(NSData*)data error:(NSError**)error;
 
 @end
 
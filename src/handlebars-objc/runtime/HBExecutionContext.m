@@ -28,10 +28,14 @@
 #import "HBExecutionContext.h"
 #import "HBExecutionContext_Private.h"
 #import "HBHelperRegistry.h"
+#import "HBHelperRegistry_Private.h"
 #import "HBPartialRegistry.h"
+#import "HBPartialRegistry_Private.h"
 #import "HBTemplate.h"
 #import "HBTemplate_Private.h"
 #import "HBPartial.h"
+#import "HBPartial_Private.h"
+#import "HBAstArchive.h"
 
 @interface _HBGlobalExecutionContext : HBExecutionContext
 - (NSString*) localizedString:(NSString*)string;
@@ -76,6 +80,26 @@
     return _helpers;
 }
 
+// templates bound their helper calls against the previous registry
+- (void) setHelpers:(HBHelperRegistry*)helpers
+{
+    @synchronized(self) {
+        if (helpers == _helpers) return;
+        [_helpers release];
+        _helpers = [helpers retain];
+    }
+    [HBHelperRegistry invalidateHelperBindings];
+}
+
+// delegates can provide helpers and partials, which templates never bind nor inline
+- (void) setDelegate:(id<HBExecutionContextDelegate>)delegate
+{
+    if (delegate == _delegate) return;
+    _delegate = delegate;
+    [HBHelperRegistry invalidateHelperBindings];
+    [HBPartialRegistry invalidateInlinedPartials];
+}
+
 - (void) registerHelperBlock:(HBHelperBlock)block forName:(NSString*)name
 {
     [self.helpers registerHelperBlock:block forName:name];
@@ -128,6 +152,16 @@
     return _partials;
 }
 
+- (void) setPartials:(HBPartialRegistry*)partials
+{
+    @synchronized(self) {
+        if (partials == _partials) return;
+        [_partials release];
+        _partials = [partials retain];
+    }
+    [HBPartialRegistry invalidateInlinedPartials];
+}
+
 - (void) registerPartialString:(NSString*)partialString forName:(NSString*)name
 {
     [self.partials registerPartialString:partialString forName:name];
@@ -174,16 +208,173 @@
 #pragma mark -
 #pragma mark Instanciating templates
 
-- (HBTemplate*) templateWithString:(NSString*)string
+- (HBTemplate*) bindTemplate:(HBTemplate*)template
 {
-    HBTemplate* template = [[HBTemplate alloc] initWithString:string];
     if ([[self class] globalExecutionContext] != self) {
         template.sharedExecutionContext = self;
     }
-    return [template autorelease];
+    return template;
+}
+
+- (HBTemplate*) templateWithString:(NSString*)string
+{
+    return [self bindTemplate:[[[HBTemplate alloc] initWithString:string] autorelease]];
 }
 
+- (HBTemplate*) templateWithContentsOfFile:(NSString*)path
+{
+    return [self bindTemplate:[[[HBTemplate alloc] initWithContentsOfFile:path] autorelease]];
+}
+
+- (HBTemplate*) templateWithInputStream:(NSInputStream*)stream
+{
+    return [self bindTemplate:[[[HBTemplate alloc] initWithInputStream:stream] autorelease]];
+}
+
+- (HBTemplate*) templateWithUTF8Data:(NSData*)data
+{
+    return [self bindTemplate:[[[HBTemplate alloc] initWithUTF8Data:data] autorelease]];
+}
+
+- (HBTemplate*) templateWithRenderFunction:(HBRenderFunction)renderFunction
+{
+    return [self bindTemplate:[[[HBTemplate alloc] initWithRenderFunction:renderFunction] autorelease]];
+}
+
+#pragma mark -
+#pragma mark Batch compilation
+
+- (NSDictionary*) compileTemplateStrings:(NSDictionary* /* NSString -> NSString */)templateStrings
+                          partialStrings:(NSDictionary* /* NSString -> NSString */)partialStrings
+                          templateErrors:(NSDictionary**)templateErrors
+                           partialErrors:(NSDictionary**)partialErrors
+                         compilationTime:(NSTimeInterval*)compilationTime
+{
+    NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
+
+    // Build a flat list of things to compile. Templates first, then partials.
+    NSMutableArray* names = [NSMutableArray array];
+    NSMutableArray* compilables = [NSMutableArray array];
+
+    NSMutableDictionary* templates = [NSMutableDictionary dictionaryWithCapacity:templateStrings.count];
+    for (NSString* name in templateStrings) {
+        HBTemplate* template = [self templateWithString:templateStrings[name]];
+        templates[name] = template;
+        [names addObject:name];
+        [compilables addObject:template];
+    }
+    NSUInteger templateCount = compilables.count;
+
+    if (partialStrings) [self registerPartialStrings:partialStrings];
+    for (NSString* name in partialStrings) {
+        [names addObject:name];
+        [compilables addObject:self.partials[name]];
+    }
+
+    // Compile concurrently. HBParser is reentrant and each template or partial is only
+    // touched by one worker, so the only shared state is the errors array, where each
+    // worker owns a distinct slot.
+    NSUInteger count = compilables.count;
+    NSError** errors = calloc(count, sizeof(NSError*));
+    dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+        @autoreleasepool {
+            NSError* error = nil;
+            id compilable = compilables[index];
+            if (index < templateCount) {
+                [(HBTemplate*)compilable compile:&error];
+            } else {
+                [(HBPartial*)compilable compile:&error];
+            }
+            errors[index] = [error retain];
+        }
+    });
+
+    // Collect errors
+    NSMutableDictionary* collectedTemplateErrors = [NSMutableDictionary dictionary];
+    NSMutableDictionary* collectedPartialErrors = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < count; i++) {
+        if (errors[i]) {
+            NSMutableDictionary* collectedErrors = (i < templateCount) ? collectedTemplateErrors : collectedPartialErrors;
+            collectedErrors[names[i]] = errors[i];
+            [errors[i] release];
+        }
+    }
+    free(errors);
+
+    if (templateErrors) *templateErrors = collectedTemplateErrors;
+    if (partialErrors) *partialErrors = collectedPartialErrors;
+    if (compilationTime) *compilationTime = [NSDate timeIntervalSinceReferenceDate] - startTime;
+
+    return templates;
+}
+
+
+#pragma mark -
+#pragma mark Precompiled templates
+
+- (NSData*) precompiledDataWithTemplateStrings:(NSDictionary* /* NSString -> NSString */)templateStrings
+                                partialStrings:(NSDictionary* /* NSString -> NSString */)partialStrings
+                                templateErrors:(NSDictionary**)templateErrors
+                                 partialErrors:(NSDictionary**)partialErrors
+{
+    NSMutableDictionary* templatePrograms = [NSMutableDictionary dictionaryWithCapacity:templateStrings.count];
+    NSMutableDictionary* collectedTemplateErrors = [NSMutableDictionary dictionary];
+    for (NSString* name in templateStrings) {
+        HBTemplate* template = [[HBTemplate alloc] initWithString:templateStrings[name]];
+        NSError* error = nil;
+        [template compile:&error];
+        if (error) collectedTemplateErrors[name] = error;
+        else if (template.program) templatePrograms[name] = template.program;
+        [template release];
+    }
     
+    NSMutableDictionary* partialPrograms = [NSMutableDictionary dictionaryWithCapacity:partialStrings.count];
+    NSMutableDictionary* collectedPartialErrors = [NSMutableDictionary dictionary];
+    for (NSString* name in partialStrings) {
+        HBPartial* partial = [[HBPartial alloc] init];
+        partial.string = partialStrings[name];
+        NSError* error = nil;
+        [partial compile:&error];
+        if (error) collectedPartialErrors[name] = error;
+        else if (partial._program) partialPrograms[name] = partial._program;
+        [partial release];
+    }
+    
+    if (templateErrors) *templateErrors = collectedTemplateErrors;
+    if (partialErrors) *partialErrors = collectedPartialErrors;
+    if (collectedTemplateErrors.count > 0 || collectedPartialErrors.count > 0) return nil;
+    
+    return [HBAstArchive archivedDataWithTemplatePrograms:templatePrograms partialPrograms:partialPrograms];
+}
+
+- (NSDictionary*) templatesWithContentsOfPrecompiledFile:(NSString*)path error:(NSError**)error
+{
+    NSData* data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedAlways error:error];
+    if (!data) return nil;
+    
+    return [self templatesWithPrecompiledData:data error:error];
+}
+
+- (NSDictionary*) templatesWithPrecompiledData:(NSData*)data error:(NSError**)error
+{
+    NSDictionary* templatePrograms = nil;
+    NSDictionary* partialPrograms = nil;
+    if (![HBAstArchive readArchivedData:data templatePrograms:&templatePrograms partialPrograms:&partialPrograms error:error]) return nil;
+    
+    for (NSString* name in partialPrograms) {
+        HBPartial* partial = [[HBPartial alloc] init];
+        partial.archivedProgram = partialPrograms[name];
+        [self.partials registerPartial:partial forName:name];
+        [partial release];
+    }
+    
+    NSMutableDictionary* templates = [NSMutableDictionary dictionaryWithCapacity:templatePrograms.count];
+    for (NSString* name in templatePrograms) {
+        templates[name] = [self bindTemplate:[[[HBTemplate alloc] initWithArchivedProgram:templatePrograms[name]] autorelease]];
+    }
+    return templates;
+}
+
 #pragma mark -
 #pragma mark Localization
 
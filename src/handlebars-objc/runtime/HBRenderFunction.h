@@ -0,0 +1,94 @@
+//
+//  HBRenderFunction.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "HBHelperCallingInfo.h"
+
+@class HBAstEvaluationVisitor;
+@class HBHelper;
+@class HBPartial;
+
+/**
+ Render functions are generated from templates ahead of time, by the hbs-codegen tool, and linked in applications.
+ 
+ A render function appends the rendering of its template to output, and produces the same result as the template it was generated from. Static text is compiled to constant byte arrays, key paths to direct lookups and builtin block helpers to inline control flow. Helpers and partials are still resolved at render time: a builtin helper overridden by the application is called like any other helper.
+ 
+ Create templates from render functions with <[HBExecutionContext templateWithRenderFunction:]>.
+ @since v1.5.0
+ */
+typedef void (*HBRenderFunction)(HBAstEvaluationVisitor* visitor, NSMutableString* output);
+
+// Version of the support functions below. Generated code checks it at compile time: generated sources
+// must be generated again with the hbs-codegen tool of the version of handlebars-objc they are linked with.
+#define HB_RENDER_FUNCTION_VERSION 1
+
+// -- Support functions called by generated code. Not meant to be called directly. --
+
+// static text, as a UTF-8 byte array. The string made from it is cached in *string.
+extern void hb_render_append_text(NSMutableString* output, NSString** string, const char* bytes, NSUInteger length);
+
+// result of a helper or of a partial. Anything but a string is ignored.
+extern void hb_render_append(NSMutableString* output, id value);
+
+// value of a {{simple tag}}, escaped according to current escaping mode unless it is a triple-stash tag
+extern void hb_render_append_value(HBAstEvaluationVisitor* visitor, NSMutableString* output, id value, BOOL escape);
+
+// key path lookup in current context. See -[HBContextState evaluateKeys:count:parentLevels:isDataValue:]
+extern id hb_render_lookup(HBAstEvaluationVisitor* visitor, NSUInteger parentLevels, BOOL isDataValue, NSString* const* keys, NSUInteger count);
+
+// helpers
+extern HBHelper* hb_render_helper(HBAstEvaluationVisitor* visitor, NSString* name);
+extern BOOL hb_render_is_builtin_helper(HBHelper* helper, NSString* name);
+extern id hb_render_missing_helper(HBAstEvaluationVisitor* visitor, NSString* name); // reports the error, returns nil
+
+// Parameters are passed as C arrays. positionalParameters and names are NULL when the expression has none, nil values are passed as NSNull.
+extern id hb_render_call_helper(HBAstEvaluationVisitor* visitor, HBHelper* helper, HBHelperInvocationKind kind,
+                                const id* positionalParameters, NSUInteger positionalCount,
+                                NSString* const* names, const id* namedValues, NSUInteger namedCount,
+                                HBRenderFunction statements, HBRenderFunction inverseStatements);
+
+// builtin block helpers, inlined when not overridden. Same parameters as hb_render_call_helper.
+extern void hb_render_if(HBAstEvaluationVisitor* visitor, NSMutableString* output, BOOL unless,
+                         const id* positionalParameters, NSUInteger positionalCount,
+                         NSString* const* names, const id* namedValues, NSUInteger namedCount,
+                         HBRenderFunction statements, HBRenderFunction inverseStatements);
+extern void hb_render_with(HBAstEvaluationVisitor* visitor, NSMutableString* output,
+                           const id* positionalParameters, NSUInteger positionalCount,
+                           HBRenderFunction statements);
+extern void hb_render_each(HBAstEvaluationVisitor* visitor, NSMutableString* output,
+                           const id* positionalParameters, NSUInteger positionalCount,
+                           HBRenderFunction statements, HBRenderFunction inverseStatements);
+
+// block that is not a helper call: iterates arrays, tests scalars and pushes other values as context
+extern void hb_render_section(HBAstEvaluationVisitor* visitor, NSMutableString* output, id value, HBRenderFunction statements, HBRenderFunction inverseStatements);
+
+// partials. hb_render_partial returns the compiled partial, or nil after reporting an error.
+extern HBPartial* hb_render_partial(HBAstEvaluationVisitor* visitor, NSString* name);
+extern void hb_render_push_context(HBAstEvaluationVisitor* visitor, id context);
+extern void hb_render_pop_context(HBAstEvaluationVisitor* visitor);
+extern void hb_render_merge_attributes(HBAstEvaluationVisitor* visitor, NSString* const* names, const id* values, NSUInteger count);
+extern void hb_render_partial_statements(HBAstEvaluationVisitor* visitor, NSMutableString* output, HBPartial* partial);
@@ -0,0 +1,429 @@
+//
+//  HBRenderFunction.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBRenderFunction.h"
+#import "HBRenderFunction_Private.h"
+#import "HBAstEvaluationVisitor.h"
+#import "HBAstEvaluationVisitor_Private.h"
+#import "HBAst.h"
+#import "HBContextStack.h"
+#import "HBContextState.h"
+#import "HBDataContext.h"
+#import "HBContextRendering.h"
+#import "HBHelper.h"
+#import "HBHelperUtils.h"
+#import "HBHelperCallingInfo_Private.h"
+#import "HBBuiltinHelpersRegistry.h"
+#import "HBTemplate.h"
+#import "HBTemplate_Private.h"
+#import "HBPartial.h"
+#import "HBPartial_Private.h"
+#import "HBErrorHandling_Private.h"
+#import "HBEscapedString.h"
+#import "HBEscapedString_Private.h"
+
+// All functions below mirror what HBAstEvaluationVisitor does for the corresponding AST nodes. The bytecode and
+// closure engines use them too, see HBRenderFunction_Private.h.
+
+#pragma mark -
+#pragma mark Output
+
+void hb_render_append_text(NSMutableString* output, NSString** string, const char* bytes, NSUInteger length)
+{
+    NSString* text = *string;
+    if (!text) {
+        // bytes are static: the string never copies them
+        text = (NSString*)CFStringCreateWithBytesNoCopy(kCFAllocatorDefault, (const UInt8*)bytes, length, kCFStringEncodingUTF8, false, kCFAllocatorNull);
+        if (!__sync_bool_compare_and_swap(string, nil, text)) {
+            [text release];
+            text = *string;
+        }
+    }
+    [output appendString:text];
+}
+
+void hb_render_output_append(hb_render_output output, id value)
+{
+    if (!value || ![value isKindOfClass:[NSString class]]) return;
+    if (output.data) {
+        hb_append_utf8_string(output.data, value);
+    } else if ([value isKindOfClass:[HBEscapedString class]]) {
+        [output.string appendString:[value actualString]];
+    } else {
+        [output.string appendString:value];
+    }
+}
+
+void hb_render_output_append_value(HBAstEvaluationVisitor* visitor, hb_render_output output, id value, BOOL escape)
+{
+    NSString* renderedValue = renderForHandlebars(value);
+    if (escape && (![renderedValue isKindOfClass:[HBEscapedString class]]))
+        renderedValue = [visitor escapeStringAccordingToCurrentMode:renderedValue];
+    
+    hb_render_output_append(output, renderedValue);
+}
+
+void hb_render_output_append_text(hb_render_output output, HBAstRawText* node)
+{
+    if (output.data) {
+        hb_append_raw_text(output.data, node);
+    } else {
+        hb_render_output_append(output, node.litteralValue);
+    }
+}
+
+void hb_render_append(NSMutableString* output, id value)
+{
+    hb_render_output_append((hb_render_output){ output, nil }, value);
+}
+
+void hb_render_append_value(HBAstEvaluationVisitor* visitor, NSMutableString* output, id value, BOOL escape)
+{
+    hb_render_output_append_value(visitor, (hb_render_output){ output, nil }, value, escape);
+}
+
+#pragma mark -
+#pragma mark Values
+
+id hb_render_lookup(HBAstEvaluationVisitor* visitor, NSUInteger parentLevels, BOOL isDataValue, NSString* const* keys, NSUInteger count)
+{
+    return [visitor.contextStack.current evaluateKeys:keys count:count parentLevels:parentLevels isDataValue:isDataValue];
+}
+
+NSArray* hb_render_positional_parameters(const id* values, NSUInteger count)
+{
+    if (!values) return nil;
+    NSMutableArray* parameters = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [parameters addObject:values[i] ? values[i] : [NSNull null]];
+    }
+    return parameters;
+}
+
+NSDictionary* hb_render_named_parameters(NSString* const* names, const id* values, NSUInteger count)
+{
+    if (!names) return nil;
+    NSMutableDictionary* parameters = [NSMutableDictionary dictionaryWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        parameters[names[i]] = values[i] ? values[i] : [NSNull null];
+    }
+    return parameters;
+}
+
+// callingInfo[name], without building the dictionary. Last value wins, like in a dictionary.
+static id hb_render_named_parameter(NSString* const* names, const id* values, NSUInteger count, NSString* name)
+{
+    if (!names) return nil;
+    for (NSUInteger i = count; i > 0; i--) {
+        if ([names[i - 1] isEqualToString:name]) return values[i - 1] ? values[i - 1] : [NSNull null];
+    }
+    return nil;
+}
+
+// callingInfo[0]
+static id hb_render_first_parameter(const id* values, NSUInteger count)
+{
+    if (!values || count == 0) return nil;
+    return values[0] ? values[0] : [NSNull null];
+}
+
+#pragma mark -
+#pragma mark Statements
+
+static void hb_render_statements(HBAstEvaluationVisitor* visitor, NSMutableString* output, HBRenderFunction statements, id context, HBDataContext* data, BOOL pushContext)
+{
+    if (!statements) return;
+    
+    if (pushContext) [visitor.contextStack push:[HBContextState stateWithContext:context data:data]];
+    statements(visitor, output);
+    if (pushContext) [visitor.contextStack pop];
+}
+
+// statements evaluators, as passed to helpers. Empty statements evaluate to nil.
+static NSString* hb_render_evaluate_statements(HBAstEvaluationVisitor* visitor, HBRenderFunction statements, id context, HBDataContext* data, BOOL pushContext)
+{
+    if (!statements) return nil;
+    
+    NSMutableString* result = [NSMutableString string];
+    hb_render_statements(visitor, result, statements, context, data, pushContext);
+    return result;
+}
+
+// body of the statements of render functions
+typedef struct {
+    HBAstEvaluationVisitor* visitor;
+    NSMutableString* output;
+    HBRenderFunction statements;
+    HBRenderFunction inverseStatements;
+} hb_render_function_block;
+
+static void hb_render_function_body(void* block, BOOL inverse, id context, HBDataContext* data, BOOL pushContext)
+{
+    hb_render_function_block* functions = block;
+    hb_render_statements(functions->visitor, functions->output, inverse ? functions->inverseStatements : functions->statements, context, data, pushContext);
+}
+
+void hb_render_section_body(HBAstEvaluationVisitor* visitor, id value, const hb_render_body* body)
+{
+    HBContextState* current = visitor.contextStack.current;
+    HBDataContext* currentData = current.dataContext;
+    
+    if ([HBHelperUtils isEnumerableByIndex:value]) {
+        // Array-like context
+        id<NSFastEnumeration> arrayLike = value;
+        NSInteger index = 0;
+        HBDataContext* arrayData = [current dataContextCopyOrNew];
+        for (id arrayElement in arrayLike) {
+            arrayData[@"index"] = @(index);
+            body->render(body->block, NO, arrayElement, arrayData, true);
+            index++;
+        }
+        [arrayData release];
+        
+        if (index == 0) body->render(body->block, YES, nil, nil, false);
+    } else if (value == nil || [value isKindOfClass:[NSString class]] || [value isKindOfClass:[NSNumber class]]) {
+        // String of scalar context
+        if ([HBHelperUtils evaluateObjectAsBool:value]) {
+            body->render(body->block, NO, value, currentData, true);
+        } else {
+            body->render(body->block, YES, nil, nil, false);
+        }
+    } else {
+        // Dictionary-like context
+        body->render(body->block, NO, value, currentData, true);
+    }
+}
+
+void hb_render_section(HBAstEvaluationVisitor* visitor, NSMutableString* output, id value, HBRenderFunction statements, HBRenderFunction inverseStatements)
+{
+    hb_render_function_block block = { visitor, output, statements, inverseStatements };
+    hb_render_body body = { hb_render_function_body, &block };
+    hb_render_section_body(visitor, value, &body);
+}
+
+#pragma mark -
+#pragma mark Helpers
+
+HBHelper* hb_render_helper(HBAstEvaluationVisitor* visitor, NSString* name)
+{
+    return [visitor.template helperForName:name];
+}
+
+BOOL hb_render_is_builtin_helper(HBHelper* helper, NSString* name)
+{
+    // builtin registry always returns the same helper objects
+    return helper == [[HBBuiltinHelpersRegistry builtinRegistry] helperForName:name];
+}
+
+id hb_render_missing_helper(HBAstEvaluationVisitor* visitor, NSString* name)
+{
+    if (!visitor.error) // we report only one error for now.
+        visitor.error = [HBHelperMissingError HBHelperMissingErrorWithHelperName:name];
+    return nil;
+}
+
+id hb_render_invoke_helper(HBAstEvaluationVisitor* visitor, HBHelper* helper, HBHelperInvocationKind kind,
+                           const id* positionalParameters, NSUInteger positionalCount,
+                           NSString* const* names, const id* namedValues, NSUInteger namedCount,
+                           HBStatementsEvaluator statements, HBStatementsEvaluator inverseStatements)
+{
+    HBHelperCallingInfo* callingInfo = [[HBHelperCallingInfo alloc] init];
+    
+    callingInfo.context = visitor.contextStack.current.context;
+    callingInfo.data = visitor.contextStack.current.dataContext;
+    callingInfo.positionalParameters = hb_render_positional_parameters(positionalParameters, positionalCount);
+    callingInfo.namedParameters = hb_render_named_parameters(names, namedValues, namedCount);
+    if (kind == HBHelperInvocationBlock) {
+        callingInfo.statements = statements;
+        callingInfo.inverseStatements = inverseStatements;
+    } else {
+        HBStatementsEvaluator noopStatementsEvaluator = ^(id context, HBDataContext* data) {
+            return @"";
+        };
+        callingInfo.statements = noopStatementsEvaluator;
+        callingInfo.inverseStatements = noopStatementsEvaluator;
+    }
+    callingInfo.template = visitor.template;
+    callingInfo.evaluationVisitor = visitor;
+    callingInfo.invocationKind = kind;
+    
+    NSString* helperResult = helper.block(callingInfo);
+    [callingInfo release];
+    
+    return helperResult;
+}
+
+id hb_render_call_helper(HBAstEvaluationVisitor* visitor, HBHelper* helper, HBHelperInvocationKind kind,
+                         const id* positionalParameters, NSUInteger positionalCount,
+                         NSString* const* names, const id* namedValues, NSUInteger namedCount,
+                         HBRenderFunction statements, HBRenderFunction inverseStatements)
+{
+    return hb_render_invoke_helper(visitor, helper, kind, positionalParameters, positionalCount, names, namedValues, namedCount, ^(id context, HBDataContext* data) {
+        return hb_render_evaluate_statements(visitor, statements, context, data, true);
+    }, ^(id context, HBDataContext* data) {
+        return hb_render_evaluate_statements(visitor, inverseStatements, nil, nil, false);
+    });
+}
+
+void hb_render_if_body(HBAstEvaluationVisitor* visitor, BOOL unless,
+                       const id* positionalParameters, NSUInteger positionalCount,
+                       NSString* const* names, const id* namedValues, NSUInteger namedCount,
+                       const hb_render_body* body)
+{
+    id value = hb_render_first_parameter(positionalParameters, positionalCount);
+    id includeZero = hb_render_named_parameter(names, namedValues, namedCount, @"includeZero");
+    
+    HBContextState* current = visitor.contextStack.current;
+    if ([HBBuiltinHelpersRegistry evaluateCondition:value includeZero:includeZero] != unless) {
+        body->render(body->block, NO, current.context, current.dataContext, true);
+    } else {
+        body->render(body->block, YES, nil, nil, false);
+    }
+}
+
+void hb_render_if(HBAstEvaluationVisitor* visitor, NSMutableString* output, BOOL unless,
+                  const id* positionalParameters, NSUInteger positionalCount,
+                  NSString* const* names, const id* namedValues, NSUInteger namedCount,
+                  HBRenderFunction statements, HBRenderFunction inverseStatements)
+{
+    hb_render_function_block block = { visitor, output, statements, inverseStatements };
+    hb_render_body body = { hb_render_function_body, &block };
+    hb_render_if_body(visitor, unless, positionalParameters, positionalCount, names, namedValues, namedCount, &body);
+}
+
+void hb_render_with_body(HBAstEvaluationVisitor* visitor, const id* positionalParameters, NSUInteger positionalCount, const hb_render_body* body)
+{
+    id value = hb_render_first_parameter(positionalParameters, positionalCount);
+    body->render(body->block, NO, value, visitor.contextStack.current.dataContext, true);
+}
+
+void hb_render_with(HBAstEvaluationVisitor* visitor, NSMutableString* output,
+                    const id* positionalParameters, NSUInteger positionalCount,
+                    HBRenderFunction statements)
+{
+    hb_render_function_block block = { visitor, output, statements, NULL };
+    hb_render_body body = { hb_render_function_body, &block };
+    hb_render_with_body(visitor, positionalParameters, positionalCount, &body);
+}
+
+void hb_render_each_body(HBAstEvaluationVisitor* visitor, const id* positionalParameters, NSUInteger positionalCount, const hb_render_body* body)
+{
+    HBContextState* current = visitor.contextStack.current;
+    id expression = (positionalParameters && positionalCount > 0) ? hb_render_first_parameter(positionalParameters, positionalCount) : current.context;
+    HBDataContext* currentData = current.dataContext;
+    
+    if (expression && [HBHelperUtils isEnumerableByIndex:expression]) {
+        // Array-like context
+        id<NSFastEnumeration> arrayLike = expression;
+        
+        NSInteger objectCount = 0;
+        for (id arrayElement in arrayLike) { (void)arrayElement; objectCount++; }
+        
+        NSInteger index = 0;
+        HBDataContext* arrayData = currentData ? [currentData copy] : [HBDataContext new];
+        for (id arrayElement in arrayLike) {
+            arrayData[@"index"] = @(index);
+            arrayData[@"first"] = @(index == 0);
+            arrayData[@"last"] = @(index == (objectCount-1));
+            body->render(body->block, NO, arrayElement, arrayData, true);
+            index++;
+        }
+        [arrayData release];
+        
+        // special case for empty array-like contexts. Evaluate inverse section if they're empty (as per .js implementation).
+        if (index == 0) body->render(body->block, YES, nil, nil, false);
+        
+    } else if (expression && [HBHelperUtils isEnumerableByKey:expression]) {
+        // Dictionary-like context
+        if (![expression conformsToProtocol:@protocol(NSFastEnumeration)]) return;
+        id<NSFastEnumeration> dictionaryLike = expression;
+        
+        HBDataContext* dictionaryData = currentData ? [currentData copy] : [HBDataContext new];
+        for (id key in dictionaryLike) {
+            dictionaryData[@"key"] = key;
+            body->render(body->block, NO, [(id)dictionaryLike objectForKeyedSubscript:key], dictionaryData, true);
+        }
+        [dictionaryData release];
+    }
+}
+
+void hb_render_each(HBAstEvaluationVisitor* visitor, NSMutableString* output,
+                    const id* positionalParameters, NSUInteger positionalCount,
+                    HBRenderFunction statements, HBRenderFunction inverseStatements)
+{
+    hb_render_function_block block = { visitor, output, statements, inverseStatements };
+    hb_render_body body = { hb_render_function_body, &block };
+    hb_render_each_body(visitor, positionalParameters, positionalCount, &body);
+}
+
+#pragma mark -
+#pragma mark Partials
+
+HBPartial* hb_render_partial(HBAstEvaluationVisitor* visitor, NSString* name)
+{
+    if (visitor.error) return nil;
+    
+    HBPartial* partial = [visitor.template partialForName:name];
+    if (!partial) {
+        visitor.error = [HBPartialMissingError HBPartialMissingErrorWithPartialName:name];
+        return nil;
+    }
+    
+    NSError* partialParseError = nil;
+    [partial compile:&partialParseError];
+    
+    if (partialParseError) {
+        visitor.error = partialParseError;
+        return nil;
+    }
+    
+    return partial;
+}
+
+void hb_render_push_context(HBAstEvaluationVisitor* visitor, id context)
+{
+    HBDataContext* data = visitor.contextStack.current.dataContext;
+    [visitor.contextStack push:[HBContextState stateWithContext:context data:data]];
+}
+
+void hb_render_pop_context(HBAstEvaluationVisitor* visitor)
+{
+    [visitor.contextStack pop];
+}
+
+void hb_render_merge_attributes(HBAstEvaluationVisitor* visitor, NSString* const* names, const id* values, NSUInteger count)
+{
+    visitor.contextStack.current.mergedAttributes = hb_render_named_parameters(names, values, count);
+}
+
+// partials are interpreted: they are resolved at render time and may not be known when templates are generated
+void hb_render_partial_statements(HBAstEvaluationVisitor* visitor, NSMutableString* output, HBPartial* partial)
+{
+    for (HBAstNode* statement in partial.astStatements) {
+        hb_render_append(output, [visitor visitNode:statement]);
+    }
+}
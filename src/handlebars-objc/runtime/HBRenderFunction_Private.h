@@ -0,0 +1,74 @@
+//
+//  HBRenderFunction_Private.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+#import "HBRenderFunction.h"
+
+@class HBDataContext;
+@class HBAstRawText;
+
+//
+// What render functions, bytecode and closures share. The hb_render_* functions of HBRenderFunction.h are
+// written on top of these, for the statements of render functions. The bytecode and closure engines call
+// them with their own statements.
+//
+
+// Output of a rendering: a string, or UTF-8 data when data is set
+typedef struct {
+    NSMutableString* string;
+    NSMutableData* data;
+} hb_render_output;
+
+extern void hb_render_output_append(hb_render_output output, id value);
+extern void hb_render_output_append_value(HBAstEvaluationVisitor* visitor, hb_render_output output, id value, BOOL escape);
+extern void hb_render_output_append_text(hb_render_output output, HBAstRawText* node);
+
+// Statements and inverse statements of a block, as an engine stores them. render appends the statements, or the
+// inverse statements, to the output of the rendering in progress. When pushContext is set, they render in a new
+// context state for context and data. Empty statements render nothing and push no context.
+typedef struct {
+    void (*render)(void* block, BOOL inverse, id context, HBDataContext* data, BOOL pushContext);
+    void* block;
+} hb_render_body;
+
+// Parameters are passed as in hb_render_call_helper. They are read before any statement renders: the bytecode
+// engine passes its registers, which move when statements nest deeper than they did before.
+extern NSArray* hb_render_positional_parameters(const id* values, NSUInteger count);
+extern NSDictionary* hb_render_named_parameters(NSString* const* names, const id* values, NSUInteger count);
+
+// helper call, with the statements evaluators of block helpers: nil for others
+extern id hb_render_invoke_helper(HBAstEvaluationVisitor* visitor, HBHelper* helper, HBHelperInvocationKind kind,
+                                  const id* positionalParameters, NSUInteger positionalCount,
+                                  NSString* const* names, const id* namedValues, NSUInteger namedCount,
+                                  HBStatementsEvaluator statements, HBStatementsEvaluator inverseStatements);
+
+// hb_render_section, hb_render_if, hb_render_with and hb_render_each on statements of body
+extern void hb_render_section_body(HBAstEvaluationVisitor* visitor, id value, const hb_render_body* body);
+extern void hb_render_if_body(HBAstEvaluationVisitor* visitor, BOOL unless,
+                              const id* positionalParameters, NSUInteger positionalCount,
+                              NSString* const* names, const id* namedValues, NSUInteger namedCount,
+                              const hb_render_body* body);
+extern void hb_render_with_body(HBAstEvaluationVisitor* visitor, const id* positionalParameters, NSUInteger positionalCount, const hb_render_body* body);
+extern void hb_render_each_body(HBAstEvaluationVisitor* visitor, const id* positionalParameters, NSUInteger positionalCount, const hb_render_body* body);
@@ -27,9 +27,22 @@
 
 #import <Foundation/Foundation.h>
 #import "HBHelper.h"
+#import "HBRenderFunction.h"
 
 @class HBHelperRegistry;
 @class HBPartialRegistry;
+@class HBTemplateAnalysis;
+@class HBTemplateProfile;
+
+/**
+ Engines templates can be rendered with. See <[HBTemplate engine]>.
+ @since v1.5.0
+ */
+typedef NS_ENUM(NSInteger, HBTemplateEngine) {
+    HBTemplateEngineInterpreter = 0, // syntax tree evaluated node by node
+    HBTemplateEngineBytecode,        // syntax tree lowered to instructions, run by a virtual machine
+    HBTemplateEngineClosures         // syntax tree compiled to a tree of C functions called directly
+};
 
 /** 
  The HBTemplate is the class representing templates in HBHandlebars. 
@@ -61,6 +74,57 @@
  */
 - (id) initWithString:(NSString*)string;
 
+/**
+ Initialize a template with the contents of a UTF-8 file
+ 
+ The file is mapped in memory and parsed when the template is compiled. Large templates are never held in memory as an NSString: this only keeps the file mapped. <templateString> remains nil.
+ 
+ @param path Path of the template file
+ @since v1.5.0
+ */
+- (id) initWithContentsOfFile:(NSString*)path;
+
+/**
+ Initialize a template with UTF-8 bytes read from a file descriptor
+ 
+ The descriptor is read up to end of file when the template is compiled. It must stay open until then, and is not closed by the template. Its bytes are kept, and compiling the template again does not read it again. <templateString> remains nil.
+ 
+ @param fd File descriptor to read the template from
+ @since v1.5.0
+ */
+- (id) initWithFileDescriptor:(int)fd;
+
+/**
+ Initialize a template with UTF-8 bytes read from a stream
+ 
+ The stream is read up to its end when the template is compiled. If it is not open yet, it is opened then closed by the template. Its bytes are kept, and compiling the template again does not read it again. <templateString> remains nil.
+ 
+ @param stream Stream to read the template from
+ @since v1.5.0
+ */
+- (id) initWithInputStream:(NSInputStream*)stream;
+
+/**
+ Initialize a template with UTF-8 data
+ 
+ The template is parsed from data as is, without ever being converted to an NSString. Raw text of the template keeps referring to data: rendering it with <renderDataWithContext:error:> copies its bytes without transcoding them. <templateString> remains nil.
+ 
+ @param data UTF-8 template
+ @since v1.5.0
+ */
+- (id) initWithUTF8Data:(NSData*)data;
+
+/**
+ Initialize a template with a render function generated ahead of time
+ 
+ Render functions are generated from templates by the hbs-codegen tool, and linked in the application: the template is never parsed at run time. Helpers and partials are resolved at render time, like they are for other templates. <templateString> remains nil.
+ 
+ @param renderFunction Render function generated by hbs-codegen
+ @see [HBExecutionContext templateWithRenderFunction:]
+ @since v1.5.0
+ */
+- (id) initWithRenderFunction:(HBRenderFunction)renderFunction;
+
 /**
  Render a template 
  
@@ -72,6 +136,17 @@
  */
 - (NSString*)renderWithContext:(id)context error:(NSError**)error;
 
+/**
+ Render a template to UTF-8 data
+ 
+ This method renders the template like <renderWithContext:error:> does, but produces UTF-8 data instead of a string, ready to be written to a file or sent over the network. Raw text of the template is copied from the UTF-8 template source, and values are transcoded as they are appended: the rendered document never exists as an NSString.
+ 
+ @param context The object containing the data used in the template.
+ @param error Pointer to an NSError object that will be set in case an error occurs during rendering.
+ @since v1.5.0
+ */
+- (NSData*)renderDataWithContext:(id)context error:(NSError**)error;
+
 /** @name Compilation */
 
 /**
@@ -84,6 +159,95 @@
  */
 - (BOOL) compile:(NSError**)error; // done automatically when rendering. Can be called at will, upfront if wanted.
 
+/**
+ Edit the template string and compile the result incrementally
+ 
+ This method replaces the characters in range of <templateString> with string, like -[NSMutableString replaceCharactersInRange:withString:] would, and compiles the new template. If the template was already compiled, only the top-level statements touched by the edit are parsed again: the cost of an edit is proportional to the size of the edit and of the statements around it, rather than to the size of the template. This makes it suitable for live previews in a template editor.
+ 
+ Template must have been created with a string.
+ 
+ @param range range of templateString to replace
+ @param string replacement string
+ @param error pointer to an error object that is set in case of parsing error.
+ @return YES if the new template was compiled. Returns NO if an error occurred.
+ @since v1.5.0
+ */
+- (BOOL) replaceCharactersInRange:(NSRange)range withString:(NSString*)string error:(NSError**)error;
+
+/**
+ Engine used to render the template
+ 
+ By default, templates are rendered by evaluating their syntax tree node by node. With HBTemplateEngineBytecode, compiling the template also lowers its syntax tree to a flat array of instructions, run by a small virtual machine that dispatches with a switch rather than with messages, keeps intermediate values in registers, and inlines the builtin if, unless, with and each helpers unless they are overridden. Partials the template renders run on the same engine.
+ 
+ With HBTemplateEngineClosures, compiling the template turns each node of its syntax tree into a closure: a C function bound to the data of the node and to the closures of its children. Rendering calls these functions directly, without dispatching on node types, and inlines builtin helpers the same way.
+ 
+ All engines produce the same output. The engine can be changed at any time, and has no effect on templates created with a render function.
+ @since v1.5.0
+ */
+@property (assign, nonatomic) HBTemplateEngine engine;
+
+/**
+ Whether compiling the template splices the partials it renders into it
+ 
+ When set, partials included without a context nor parameters are resolved when the template compiles rather than each time they are rendered, and their statements take the place of the partial tag in the compiled template, so that rendering them does not look them up by name nor render them into a separate string. Partials included by inlined partials are inlined too, except recursive ones. Partials that are missing or fail to compile when the template compiles are still resolved when rendering, and report their errors then.
+ 
+ Partials are only inlined from partial registries: templates that have an execution context whose delegate provides partials do not inline any. The template remembers which partials it inlined, and splices them again before rendering when one of them is registered again or unregistered.
+ 
+ Defaults to NO. Has no effect on templates created with a render function.
+ @since v1.5.0
+ */
+@property (assign, nonatomic) BOOL inlinesPartials;
+
+/**
+ Whether values looked up several times in the same scope are looked up once
+ 
+ Compiled templates know which key paths a scope of the template refers to more than once, like `{{user.profile.name}}` repeated in a `{{#with order}}` block. When set, the first lookup of such a key path in a scope is remembered, and the following ones reuse its value instead of walking the key path again.
+ 
+ Note: when set, a helper that modifies the objects it is given, or the `@data` variables of its scope, is not seen by the mustaches that follow it in the scope: they render the value the key path had when it was first looked up. Only set it on templates whose helpers do not modify their contexts.
+ 
+ Defaults to NO, every mustache reads the current value of its key path.
+ @since v1.5.0
+ */
+@property (assign, nonatomic) BOOL cachesRepeatedLookups;
+
+/** @name Profiling */
+
+/**
+ What earlier renders of the template looked like
+ 
+ When set, renders reserve room for output of the length the profile expects, rather than guessing it from the length of the template, and loop bodies reserve room for what they usually render. Compiling the template prepares each mustache for the classes of the objects it looked values up in, so that the first renders do not have to resolve how to read them.
+ 
+ Profiles are recorded by setting <recordsProfile>, and can be saved and loaded again, see <HBTemplateProfile>. Defaults to nil. Has no effect on templates created with a render function.
+ @since v1.5.0
+ */
+@property (retain, nonatomic) HBTemplateProfile* profile;
+
+/**
+ Whether renders of the template are recorded in its profile
+ 
+ Setting it creates an empty <profile> if the template has none. Recording renders counts the length of what they render, how blocks render, and which classes mustaches look values up in. Renders that are recorded are evaluated node by node, whatever the <engine>, and do not use inlined partials nor folded conditions, which would hide blocks of the template. Partials are rendered, but not profiled.
+ 
+ Defaults to NO.
+ @since v1.5.0
+ */
+@property (assign, nonatomic) BOOL recordsProfile;
+
+/** @name Analysis */
+
+/**
+ Find what the template refers to
+ 
+ This method compiles the template if needed, then walks it to find every key path and data variable it can look up, the helpers it calls and the partials it renders, including those the partials it renders refer to, transitively. Key paths are reported with the scope they are looked up in, for instance the elements of an array the template iterates over. Partials and helpers are resolved the way they would be if the template was rendered now.
+ 
+ Use it to know which values of your model objects a template needs before rendering it, for instance to fetch only these from a store, or to build cache keys from them.
+ 
+ @param error pointer to an error object that is set in case of parsing error.
+ @return the analysis of the template, or nil if an error occurred or the template was created with a render function.
+ @see HBTemplateAnalysis
+ @since v1.5.0
+ */
+- (HBTemplateAnalysis*) analyze:(NSError**)error;
+
 /** @name Helpers and partials */
 
 /**
@@ -31,33 +31,182 @@
 #import "HBAstEvaluationVisitor.h"
 #import "HBParser.h"
 #import "HBHelperRegistry.h"
+#import "HBHelperRegistry_Private.h"
 #import "HBBuiltinHelpersRegistry.h"
 #import "HBExecutionContext.h"
 #import "HBExecutionContext_Private.h"
 #import "HBPartial.h"
 #import "HBPartialRegistry.h"
-#import "HBAstParserPostprocessingVisitor.h"
+#import "HBPartialRegistry_Private.h"
+#import "HBAstFreezingVisitor.h"
+#import "HBAstOptimizingVisitor.h"
+#import "HBAstPartialInliningVisitor.h"
+#import "HBAstConditionFoldingVisitor.h"
+#import "HBAstAnalysisVisitor.h"
+#import "HBAstArchive.h"
+#import "HBAstBytecodeGenerationVisitor.h"
+#import "HBBytecode.h"
+#import "HBClosureTree.h"
+#import "HBTemplateProfile.h"
+#import "HBTemplateProfile_Private.h"
+
+@interface HBTemplate()
+{
+    NSUInteger _inlinedPartialsGeneration;
+    NSUInteger _foldedConditionsGeneration;
+    BOOL _foldedConditionsWithHelperBindings;
+    HBTemplateProfileSites* _profileSites;
+    BOOL _bytecodeIsUnsupported; // executableProgram does not fit the bytecode format, see +[HBAstBytecodeGenerationVisitor bytecodeForStatements:]
+}
+@end
 
 @implementation HBTemplate
 
 - (id) initWithString:(NSString*)string
 {
-    self = [super init];
+    self = [self init];
     if (self) {
         self.templateString = string;
     }
     return self;
 }
 
+- (id) initWithContentsOfFile:(NSString*)path
+{
+    self = [self init];
+    if (self) {
+        self.templateSource = [NSURL fileURLWithPath:path];
+    }
+    return self;
+}
+
+- (id) initWithFileDescriptor:(int)fd
+{
+    self = [self init];
+    if (self) {
+        self.templateSource = @(fd);
+    }
+    return self;
+}
+
+- (id) initWithInputStream:(NSInputStream*)stream
+{
+    self = [self init];
+    if (self) {
+        self.templateSource = stream;
+    }
+    return self;
+}
+
+- (id) initWithUTF8Data:(NSData*)data
+{
+    self = [self init];
+    if (self) {
+        self.templateSource = [[data copy] autorelease];
+    }
+    return self;
+}
+
+- (id) initWithArchivedProgram:(HBArchivedProgram*)program
+{
+    self = [self init];
+    if (self) {
+        self.templateSource = program;
+    }
+    return self;
+}
+
+- (id) initWithRenderFunction:(HBRenderFunction)renderFunction
+{
+    self = [self init];
+    if (self) {
+        self.renderFunction = renderFunction;
+    }
+    return self;
+}
+
 - (void) setTemplateString:(NSString *)templateString
 {
     if (templateString != _templateString) {
         [_templateString release];
         _templateString = [templateString retain];
+        self.templateSource = nil;
+        self.renderFunction = NULL;
         self.program = nil; // this guy is invalid now. 
     }
 }
 
+// renders on other threads keep the program they started with, see -getProgram:executableProgram:bytecode:closureTree:
+- (void) setProgram:(HBAstProgram*)program
+{
+    @synchronized(self) {
+        if (program != _program) {
+            [_program release];
+            _program = [program retain];
+            self.inlinedProgram = nil;
+            self.foldedProgram = nil;
+            self.foldedHelpers = nil;
+            self.bytecode = nil;
+            self.closureTree = nil;
+            [_profileSites release];
+            _profileSites = nil;
+            [self prepareProfiledLookups];
+        }
+    }
+}
+
+- (void) setInlinedProgram:(HBAstProgram*)inlinedProgram
+{
+    if (inlinedProgram != _inlinedProgram) {
+        [_inlinedProgram release];
+        _inlinedProgram = [inlinedProgram retain];
+        self.foldedProgram = nil;
+        self.foldedHelpers = nil;
+        self.bytecode = nil;
+        self.closureTree = nil;
+    }
+    if (!inlinedProgram) {
+        self.inlinedPartials = nil;
+        _inlinedPartialsGeneration = 0;
+    }
+}
+
+- (void) setFoldedProgram:(HBAstProgram*)foldedProgram
+{
+    if (foldedProgram != _foldedProgram) {
+        [_foldedProgram release];
+        _foldedProgram = [foldedProgram retain];
+        self.bytecode = nil;
+        self.closureTree = nil;
+    }
+}
+
+// programs that did not fit the bytecode format may fit once they change
+- (void) setBytecode:(HBBytecode*)bytecode
+{
+    if (bytecode != _bytecode) {
+        [_bytecode release];
+        _bytecode = [bytecode retain];
+    }
+    _bytecodeIsUnsupported = NO;
+}
+
+- (HBAstProgram*) executableProgram
+{
+    if (self.foldedProgram) return self.foldedProgram;
+    return self.inlinedProgram ? self.inlinedProgram : self.program;
+}
+
+- (void) getProgram:(HBAstProgram**)program executableProgram:(HBAstProgram**)executableProgram bytecode:(HBBytecode**)bytecode closureTree:(HBClosureTree**)closureTree
+{
+    @synchronized(self) {
+        *program = [[self.program retain] autorelease];
+        *executableProgram = [[self.executableProgram retain] autorelease];
+        *bytecode = [[self.bytecode retain] autorelease];
+        *closureTree = [[self.closureTree retain] autorelease];
+    }
+}
+
 - (NSString*)renderWithContext:(id)context error:(NSError**)error
 {
     NSError* parseError = nil;
@@ -77,19 +226,259 @@
     return renderedString;
 }
 
+- (NSData*)renderDataWithContext:(id)context error:(NSError**)error
+{
+    NSError* parseError = nil;
+    [self compile:&parseError];
+    
+    if (parseError) {
+        if (error) *error = parseError;
+        return nil;
+    }
+    
+    HBAstEvaluationVisitor* visitor = [[HBAstEvaluationVisitor alloc] initWithTemplate:self];
+    NSData* renderedData = [visitor evaluateDataWithContext:context];
+    
+    if (error) *error = [[visitor.error retain] autorelease];
+    [visitor release];
+    
+    return renderedData;
+}
+
 - (BOOL) compile:(NSError**)error
 {
+    if (self.renderFunction) return YES;
+    
     if (nil == self.program) {
-        self.program = [HBParser astFromString:self.templateString error:error];
-        if (!*error && self.program) {
-            HBAstParserPostprocessingVisitor* postProcessingVisitor = [[HBAstParserPostprocessingVisitor alloc] init];
-            [postProcessingVisitor visitNode:self.program];
-            [postProcessingVisitor release];
+        // whitespace control is applied by the parsers, and archived programs were parsed already
+        HBAstProgram* program = nil;
+        if ([self.templateSource isKindOfClass:[HBArchivedProgram class]]) {
+            program = [(HBArchivedProgram*)self.templateSource program:error];
+        } else {
+            program = [self parseTemplate:error];
+        }
+        
+        // compiled programs are kept resident: drop what only parsing needed. Programs are frozen
+        // before they are set, so that profiles prepare the lookups renders will use.
+        [HBAstOptimizingVisitor optimizeProgram:program];
+        [HBAstFreezingVisitor freezeProgram:program];
+        self.program = program;
+    }
+    
+    // partials may have been registered again since they were inlined, and helpers since conditions were folded.
+    // Other threads may be rendering: they took their own snapshot of the programs replaced here.
+    @synchronized(self) {
+        [self updateInlinedPartials];
+        [self updateFoldedConditions];
+        
+        // the engine may change between renderings
+        if (self.engine == HBTemplateEngineBytecode && self.program && !self.bytecode && !_bytecodeIsUnsupported) {
+            self.bytecode = [HBAstBytecodeGenerationVisitor bytecodeForStatements:self.executableProgram.statements];
+            _bytecodeIsUnsupported = (self.bytecode == nil);
+        }
+        if (self.engine == HBTemplateEngineClosures && self.program && !self.closureTree) {
+            self.closureTree = [HBClosureTree closureTreeForStatements:self.executableProgram.statements];
         }
     }
     return (nil != self.program);
 }
 
+- (void) updateInlinedPartials
+{
+    if (!self.inlinesPartials || !self.program) {
+        self.inlinedProgram = nil;
+        return;
+    }
+    
+    // no partial registered or unregistered anywhere since partials were inlined
+    NSUInteger generation = [HBPartialRegistry currentGeneration];
+    if (_inlinedPartialsGeneration == generation) return;
+    
+    if (![self canInlinePartials]) {
+        self.inlinedProgram = nil;
+    } else if (!self.inlinedProgram || ![self inlinedPartialsAreCurrent]) {
+        NSMutableDictionary* inlinedPartials = [NSMutableDictionary dictionary];
+        HBAstProgram* inlinedProgram = [HBAstPartialInliningVisitor programByInliningPartialsOfProgram:self.program forTemplate:self inlinedPartials:inlinedPartials];
+        self.inlinedProgram = (inlinedProgram != self.program) ? inlinedProgram : nil;
+        self.inlinedPartials = self.inlinedProgram ? inlinedPartials : nil;
+    }
+    _inlinedPartialsGeneration = generation;
+}
+
+// whether the partials spliced in are still those their names resolve to
+- (BOOL) inlinedPartialsAreCurrent
+{
+    for (NSString* name in self.inlinedPartials) {
+        if ([self partialForName:name] != self.inlinedPartials[name]) return NO;
+    }
+    return YES;
+}
+
+- (void) updateFoldedConditions
+{
+    HBAstProgram* program = self.inlinedProgram ? self.inlinedProgram : self.program;
+    if (!program) return;
+    
+    // no helper registered or unregistered anywhere since conditions were folded
+    NSUInteger generation = [HBHelperRegistry currentGeneration];
+    if (self.foldedHelpers && _foldedConditionsGeneration == generation) return;
+    
+    if (!self.foldedHelpers || ![self foldedHelpersAreCurrent]) {
+        NSMutableDictionary* foldedHelpers = [NSMutableDictionary dictionary];
+        _foldedConditionsWithHelperBindings = self.canBindHelpers;
+        HBAstProgram* foldedProgram = [HBAstConditionFoldingVisitor programByFoldingConditionsOfProgram:program forTemplate:self helpers:foldedHelpers];
+        self.foldedProgram = (foldedProgram != program) ? foldedProgram : nil;
+        self.foldedHelpers = foldedHelpers;
+    }
+    _foldedConditionsGeneration = generation;
+}
+
+// whether the helpers of literal conditions are still those they resolved to when folding
+- (BOOL) foldedHelpersAreCurrent
+{
+    if (self.foldedHelpers.count == 0) return YES;
+    if (self.canBindHelpers != _foldedConditionsWithHelperBindings) return NO;
+    for (NSString* name in self.foldedHelpers) {
+        id helper = [self helperForName:name];
+        if ((helper ? helper : [NSNull null]) != self.foldedHelpers[name]) return NO;
+    }
+    return YES;
+}
+
+static BOOL delegateProvidesPartials(HBExecutionContext* executionContext)
+{
+    id<HBExecutionContextDelegate> delegate = executionContext.delegate;
+    return [delegate respondsToSelector:@selector(partialWithName:forExecutionContext:)] || [delegate respondsToSelector:@selector(partialStringWithName:forExecutionContext:)];
+}
+
+- (BOOL) canInlinePartials
+{
+    if (delegateProvidesPartials(self.templateLocalExecutionContext)) return NO;
+    if (delegateProvidesPartials(self.sharedExecutionContext)) return NO;
+    if (delegateProvidesPartials([HBExecutionContext globalExecutionContext])) return NO;
+    
+    return YES;
+}
+
+// UTF-8 length of a range of a string, without copying it
+static NSUInteger utf8Length(NSString* string, NSRange range)
+{
+    NSUInteger length = 0;
+    [string getBytes:NULL maxLength:NSUIntegerMax usedLength:&length encoding:NSUTF8StringEncoding options:0 range:range remainingRange:NULL];
+    return length;
+}
+
+- (BOOL) replaceCharactersInRange:(NSRange)range withString:(NSString*)string error:(NSError**)error
+{
+    NSAssert(self.templateSource == nil && self.renderFunction == NULL, @"only templates created with a string can be edited");
+    
+    NSString* oldString = self.templateString ? self.templateString : @"";
+    HBAstProgram* oldProgram = [[self.program retain] autorelease];
+    self.templateString = [oldString stringByReplacingCharactersInRange:range withString:string];
+    
+    NSError* parseError = nil;
+    if (!oldProgram) {
+        [self compile:&parseError];
+        if (error) *error = parseError;
+        return (nil != self.program);
+    }
+    
+    NSData* source = oldProgram.sourceData ? oldProgram.sourceData : [oldString dataUsingEncoding:NSUTF8StringEncoding];
+    NSRange byteRange = NSMakeRange(utf8Length(oldString, NSMakeRange(0, range.location)), utf8Length(oldString, range));
+    NSRange reparsedStatements;
+    HBAstProgram* program = [HBParser astByReplacingBytesInRange:byteRange withBytes:[string dataUsingEncoding:NSUTF8StringEncoding] inProgram:oldProgram source:source reparsedStatements:&reparsedStatements error:&parseError];
+    
+    if (program) {
+        reparsedStatements = [HBAstOptimizingVisitor optimizeProgram:program statementsInRange:reparsedStatements];
+        [HBAstFreezingVisitor freezeProgram:program statementsInRange:reparsedStatements];
+    }
+    self.program = program;
+    
+    if (error) *error = parseError;
+    return (nil != self.program);
+}
+
+// Templates created from a file are read while they are parsed. File descriptors and streams can only be read once:
+// their bytes are kept as the template source, for compilations that parse the template again.
+- (HBAstProgram*) parseTemplate:(NSError**)error
+{
+    id source = self.templateSource;
+    if ([source isKindOfClass:[NSURL class]]) return [HBParser astFromContentsOfFile:[source path] error:error];
+    if ([source isKindOfClass:[NSInputStream class]] || [source isKindOfClass:[NSNumber class]]) {
+        // templates compiled on several threads at once must not share the reads
+        @synchronized(self) {
+            source = self.templateSource;
+            if (![source isKindOfClass:[NSData class]]) {
+                NSData* data = [source isKindOfClass:[NSNumber class]] ? [HBParser dataFromFileDescriptor:[source intValue] error:error] : [HBParser dataFromInputStream:source error:error];
+                if (!data) return nil;
+                self.templateSource = data;
+                source = data;
+            }
+        }
+    }
+    if ([source isKindOfClass:[NSData class]]) return [HBParser astFromUTF8Data:source error:error];
+    
+    return [HBParser astFromString:self.templateString error:error];
+}
+
+#pragma mark -
+#pragma mark Profiling
+
+- (void) setProfile:(HBTemplateProfile*)profile
+{
+    @synchronized(self) {
+        if (profile != _profile) {
+            [_profile release];
+            _profile = [profile retain];
+            [self prepareProfiledLookups];
+        }
+    }
+}
+
+- (void) setRecordsProfile:(BOOL)recordsProfile
+{
+    _recordsProfile = recordsProfile;
+    if (recordsProfile && !self.profile) self.profile = [[HBTemplateProfile new] autorelease];
+}
+
+- (HBTemplateProfileSites*) profileSites
+{
+    if (!self.program) return nil;
+    @synchronized(self) {
+        if (!_profileSites) _profileSites = [[HBTemplateProfileSites alloc] initWithProgram:self.program];
+        return [[_profileSites retain] autorelease];
+    }
+}
+
+// Profiles loaded from a previous run know which classes lookups will see. Prepared once, under the
+// template lock, when the profile or the program is set: renders only read the caches filled here.
+- (void) prepareProfiledLookups
+{
+    if (!self.profile || !self.program) return;
+    [self.profile prepareLookupsOfSites:self.profileSites];
+}
+
+- (NSUInteger) estimatedOutputLength
+{
+    NSUInteger profiledLength = self.renderFunction ? 0 : [self.profile estimatedOutputLength];
+    if (profiledLength > 0) return profiledLength;
+    
+    id templateSource = self.templateSource;
+    NSUInteger templateLength = [templateSource isKindOfClass:[NSData class]] ? [templateSource length] : self.templateString.length;
+    return 1.2 * templateLength;
+}
+
+#pragma mark -
+#pragma mark Analysis
+
+- (HBTemplateAnalysis*) analyze:(NSError**)error
+{
+    if (self.renderFunction) return nil;
+    if (![self compile:error]) return nil;
+    
+    return [HBAstAnalysisVisitor analysisOfProgram:self.program forTemplate:self];
+}
+
 #pragma mark -
 #pragma mark Helpers
 
@@ -105,7 +494,8 @@
 {
     HBHelper* helper = nil;
     
-    helper = self.helpers[name];
+    // the template local context is only created when something is registered in it
+    helper = self.templateLocalExecutionContext.helpers[name];
     if (!helper && self.sharedExecutionContext) helper = [self.sharedExecutionContext helperForName:name];
     if (!helper) helper = [[HBExecutionContext globalExecutionContext] helperForName:name];
     if (!helper) helper = [HBBuiltinHelpersRegistry builtinRegistry][name];
@@ -113,6 +503,53 @@
     return helper;
 }
 
+// The global registry is the same for every template, so it is not part of the scope
+- (void) getHelperBindingScope:(NSUInteger*)localToken shared:(NSUInteger*)sharedToken
+{
+    *localToken = self.templateLocalExecutionContext.helpers.bindingToken;
+    *sharedToken = self.sharedExecutionContext.helpers.bindingToken;
+}
+
+static BOOL delegateProvidesHelpers(HBExecutionContext* executionContext)
+{
+    return [executionContext.delegate respondsToSelector:@selector(helperBlockWithName:forExecutionContext:)];
+}
+
+- (BOOL) canBindHelpers
+{
+    if (delegateProvidesHelpers(self.templateLocalExecutionContext)) return NO;
+    if (delegateProvidesHelpers(self.sharedExecutionContext)) return NO;
+    if (delegateProvidesHelpers([HBExecutionContext globalExecutionContext])) return NO;
+    
+    return YES;
+}
+
+// Conditions of this template were folded, and its partials inlined, against the previous execution
+// contexts. Only this template is affected: other templates keep theirs.
+- (void) executionContextsDidChange
+{
+    @synchronized(self) {
+        _foldedConditionsGeneration = 0;
+        _inlinedPartialsGeneration = 0;
+    }
+}
+
+- (void) setTemplateLocalExecutionContext:(HBExecutionContext*)templateLocalExecutionContext
+{
+    if (templateLocalExecutionContext == _templateLocalExecutionContext) return;
+    [_templateLocalExecutionContext release];
+    _templateLocalExecutionContext = [templateLocalExecutionContext retain];
+    [self executionContextsDidChange];
+}
+
+- (void) setSharedExecutionContext:(HBExecutionContext*)sharedExecutionContext
+{
+    if (sharedExecutionContext == _sharedExecutionContext) return;
+    [_sharedExecutionContext release];
+    _sharedExecutionContext = [sharedExecutionContext retain];
+    [self executionContextsDidChange];
+}
+
 #pragma mark -
 #pragma mark Partials
 
@@ -128,7 +565,7 @@
 {
     HBPartial* partial = nil;
     
-    partial = self.partials[name];
+    partial = self.templateLocalExecutionContext.partials[name];
     if (!partial && self.sharedExecutionContext) partial = [self.sharedExecutionContext partialForName:name];
     if (!partial) partial = [[HBExecutionContext globalExecutionContext] partialForName:name];
     
@@ -178,9 +615,16 @@
 - (void) dealloc
 {
     self.templateString = nil;
+    self.templateSource = nil;
     self.program = nil;
+    self.inlinedProgram = nil;
+    self.foldedProgram = nil;
+    self.foldedHelpers = nil;
+    self.bytecode = nil;
+    self.closureTree = nil;
     self.templateLocalExecutionContext = nil;
     self.sharedExecutionContext = nil;
+    self.profile = nil;
 
     [super dealloc];
 }
@@ -0,0 +1,92 @@
+//
+//  HBTemplateAnalysis.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ A key path a template refers to, and the scope it is looked up in. See <[HBTemplate analyze:]>.
+ @since v1.5.0
+ */
+@interface HBTemplateKeyPathReference : NSObject
+
+/**
+ Keys of the key path, separated by dots, without leading "this" and ".." components: "user.name" for `{{../user.name}}`. For data variables, the first key is the name of the variable: "index" for `{{@index}}`. The key path of `{{this}}`, which refers to the context itself, is "this".
+ */
+@property (readonly, nonatomic) NSString* keyPath;
+
+/**
+ Whether the key path is a data variable, such as `{{@index}}`, rather than a key path of the context
+ */
+@property (readonly, nonatomic) BOOL isDataValue;
+
+/**
+ Context the key path is looked up in, as the blocks and partials that set it, outermost first
+ 
+ An empty scope is the context the template is rendered with. Inside `{{#each orders}}{{#with customer}}`, the scope is @[@"#each orders", @"#with customer"]: the key path is looked up in the customer of each order. Partials rendered with a context add an element such as @">card customer". ".." components are resolved already: `{{../total}}` in the same place has the scope @[@"#each orders"]. The builtin if and unless helpers leave the context unchanged, and are not part of scopes.
+ */
+@property (readonly, nonatomic) NSArray* /* NSString */ scope;
+
+@end
+
+/**
+ What a template refers to, as found by <[HBTemplate analyze:]>
+ 
+ Analysis is static: it reports everything the template can refer to, whichever branches rendering takes. It cannot know about values helpers read by themselves, such as values of the contexts they are given, nor about key paths that are only known when rendering, like those of the lookup helper.
+ @since v1.5.0
+ */
+@interface HBTemplateAnalysis : NSObject
+
+/**
+ Key paths of contexts the template and the partials it renders refer to, as HBTemplateKeyPathReference objects, in the order they first appear
+ */
+@property (readonly, nonatomic) NSArray* keyPaths;
+
+/**
+ Data variables the template and the partials it renders refer to, as HBTemplateKeyPathReference objects, in the order they first appear
+ */
+@property (readonly, nonatomic) NSArray* dataKeyPaths;
+
+/**
+ Names of the helpers the template and the partials it renders call
+ 
+ Mustaches without parameters are helper calls when a helper with their name is registered when the template is analyzed, like they are when it is rendered.
+ */
+@property (readonly, nonatomic) NSSet* helperNames;
+
+/**
+ Names of the partials the template renders, and of the partials they render
+ */
+@property (readonly, nonatomic) NSSet* partialNames;
+
+/**
+ Names of the partials that were missing, or failed to compile, when the template was analyzed
+ 
+ What these partials refer to is not part of the analysis.
+ */
+@property (readonly, nonatomic) NSSet* unresolvedPartialNames;
+
+@end
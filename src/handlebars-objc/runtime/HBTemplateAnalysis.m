@@ -0,0 +1,158 @@
+//
+//  HBTemplateAnalysis.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBTemplateAnalysis.h"
+#import "HBTemplateAnalysis_Private.h"
+
+@interface HBTemplateKeyPathReference ()
+
+@property (readwrite, copy, nonatomic) NSString* keyPath;
+@property (readwrite, assign, nonatomic) BOOL isDataValue;
+@property (readwrite, copy, nonatomic) NSArray* scope;
+
+@end
+
+@implementation HBTemplateKeyPathReference
+
+- (id) initWithKeyPath:(NSString*)keyPath isDataValue:(BOOL)isDataValue scope:(NSArray*)scope
+{
+    self = [super init];
+    if (self) {
+        self.keyPath = keyPath;
+        self.isDataValue = isDataValue;
+        self.scope = scope;
+    }
+    return self;
+}
+
+- (BOOL) isEqual:(id)object
+{
+    if (object == self) return YES;
+    if (![object isKindOfClass:[HBTemplateKeyPathReference class]]) return NO;
+    HBTemplateKeyPathReference* reference = object;
+    return reference.isDataValue == self.isDataValue && [reference.keyPath isEqualToString:self.keyPath] && [reference.scope isEqualToArray:self.scope];
+}
+
+- (NSUInteger) hash
+{
+    return self.keyPath.hash ^ (self.scope.count << 1) ^ (self.isDataValue ? 1 : 0);
+}
+
+- (NSString*) description
+{
+    NSString* keyPath = self.isDataValue ? [@"@" stringByAppendingString:self.keyPath] : self.keyPath;
+    if (self.scope.count == 0) return keyPath;
+    return [NSString stringWithFormat:@"%@ in %@", keyPath, [self.scope componentsJoinedByString:@" / "]];
+}
+
+- (void) dealloc
+{
+    self.keyPath = nil;
+    self.scope = nil;
+    [super dealloc];
+}
+
+@end
+
+@implementation HBTemplateAnalysis
+{
+    NSMutableOrderedSet* _keyPaths;
+    NSMutableOrderedSet* _dataKeyPaths;
+    NSMutableSet* _helperNames;
+    NSMutableSet* _partialNames;
+    NSMutableSet* _unresolvedPartialNames;
+}
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        _keyPaths = [NSMutableOrderedSet new];
+        _dataKeyPaths = [NSMutableOrderedSet new];
+        _helperNames = [NSMutableSet new];
+        _partialNames = [NSMutableSet new];
+        _unresolvedPartialNames = [NSMutableSet new];
+    }
+    return self;
+}
+
+- (void) addKeyPathReference:(HBTemplateKeyPathReference*)reference
+{
+    [(reference.isDataValue ? _dataKeyPaths : _keyPaths) addObject:reference];
+}
+
+- (void) addHelperName:(NSString*)name
+{
+    [_helperNames addObject:name];
+}
+
+- (void) addPartialName:(NSString*)name
+{
+    [_partialNames addObject:name];
+}
+
+- (void) addUnresolvedPartialName:(NSString*)name
+{
+    [_unresolvedPartialNames addObject:name];
+}
+
+- (NSArray*) keyPaths
+{
+    return [_keyPaths array];
+}
+
+- (NSArray*) dataKeyPaths
+{
+    return [_dataKeyPaths array];
+}
+
+- (NSSet*) helperNames
+{
+    return [[_helperNames copy] autorelease];
+}
+
+- (NSSet*) partialNames
+{
+    return [[_partialNames copy] autorelease];
+}
+
+- (NSSet*) unresolvedPartialNames
+{
+    return [[_unresolvedPartialNames copy] autorelease];
+}
+
+- (void) dealloc
+{
+    [_keyPaths release];
+    [_dataKeyPaths release];
+    [_helperNames release];
+    [_partialNames release];
+    [_unresolvedPartialNames release];
+    [super dealloc];
+}
+
+@end
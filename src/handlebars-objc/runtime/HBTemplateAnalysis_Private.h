@@ -0,0 +1,44 @@
+//
+//  HBTemplateAnalysis_Private.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBTemplateAnalysis.h"
+
+@interface HBTemplateKeyPathReference ()
+
+- (id) initWithKeyPath:(NSString*)keyPath isDataValue:(BOOL)isDataValue scope:(NSArray*)scope;
+
+@end
+
+@interface HBTemplateAnalysis ()
+
+// filled by HBAstAnalysisVisitor
+- (void) addKeyPathReference:(HBTemplateKeyPathReference*)reference;
+- (void) addHelperName:(NSString*)name;
+- (void) addPartialName:(NSString*)name;
+- (void) addUnresolvedPartialName:(NSString*)name;
+
+@end
@@ -0,0 +1,75 @@
+//
+//  HBTemplateProfile.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ What renders of a template looked like, to render it faster. See <[HBTemplate profile]>.
+ 
+ A profile learns the typical length of what the template renders, which branch each conditional block takes, how many times loops iterate and how much they render, and the classes of the objects each mustache looks values up in.
+ 
+ Profiles can be saved with <propertyList>, and loaded again with <initWithPropertyList:>, for instance to reuse what was learnt in a previous run of the application. A profile only applies to the template it was recorded for: when the template changes, what it knows about blocks and lookups is ignored, and forgotten when renders are recorded again.
+ @since v1.5.0
+ */
+@interface HBTemplateProfile : NSObject
+
+/**
+ Initialize a profile saved with <propertyList>
+ 
+ @param propertyList property list returned by <propertyList>
+ @return the profile, or nil if propertyList is not a valid profile
+ @since v1.5.0
+ */
+- (id) initWithPropertyList:(id)propertyList;
+
+/**
+ Property list representation of the profile
+ 
+ The representation is made of dictionaries, arrays, strings and numbers only. It can be written with NSPropertyListSerialization or NSJSONSerialization, and loaded again with <initWithPropertyList:>.
+ @since v1.5.0
+ */
+- (id) propertyList;
+
+/**
+ Number of renders recorded
+ @since v1.5.0
+ */
+@property (readonly) NSUInteger renderCount;
+
+/**
+ Average length of the renders recorded, in characters, or bytes for UTF-8 renders
+ @since v1.5.0
+ */
+@property (readonly) NSUInteger averageOutputLength;
+
+/**
+ Length of the longest render recorded
+ @since v1.5.0
+ */
+@property (readonly) NSUInteger maximumOutputLength;
+
+@end
@@ -0,0 +1,381 @@
+//
+//  HBTemplateProfile.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBTemplateProfile.h"
+#import "HBTemplateProfile_Private.h"
+#import "HBAstVisitor.h"
+#import "HBObjectPropertyAccess.h"
+
+static const NSInteger HBTemplateProfileVersion = 1;
+
+// Numbers blocks and collects contextual values, in template order
+@interface HBAstProfileSitesVisitor : HBAstVisitor
+@property (assign, nonatomic) CFMutableDictionaryRef blockIndexes;
+@property (retain, nonatomic) NSMutableArray* lookups;
+@property (retain, nonatomic) NSMutableString* signature; // what the sites are, for fingerprints
+@end
+
+@interface HBTemplateProfileSites ()
+{
+    CFMutableDictionaryRef _blockIndexes;
+}
+@property (readwrite, copy, nonatomic) NSString* fingerprint;
+@property (readwrite, retain, nonatomic) NSArray* lookups;
+@end
+
+@implementation HBTemplateProfileSites
+
+- (id) initWithProgram:(HBAstProgram*)program
+{
+    self = [super init];
+    if (self) {
+        _blockIndexes = CFDictionaryCreateMutable(NULL, 0, NULL, NULL);
+        HBAstProfileSitesVisitor* visitor = [[HBAstProfileSitesVisitor alloc] initWithRootAstNode:program];
+        visitor.blockIndexes = _blockIndexes;
+        visitor.lookups = [NSMutableArray array];
+        visitor.signature = [NSMutableString string];
+        [visitor visitNode:program];
+        
+        self.lookups = visitor.lookups;
+        
+        // 64-bit FNV-1a of the signature
+        uint64_t hash = 14695981039346656037ULL;
+        NSData* signature = [visitor.signature dataUsingEncoding:NSUTF8StringEncoding];
+        const uint8_t* bytes = [signature bytes];
+        for (NSUInteger i = 0; i < signature.length; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+        self.fingerprint = [NSString stringWithFormat:@"%016llx-%lu-%lu", hash, (unsigned long)CFDictionaryGetCount(_blockIndexes), (unsigned long)self.lookups.count];
+        [visitor release];
+    }
+    return self;
+}
+
+- (NSUInteger) blockCount
+{
+    return CFDictionaryGetCount(_blockIndexes);
+}
+
+- (NSUInteger) indexOfBlock:(HBAstBlock*)block
+{
+    const void* index = NULL;
+    if (!CFDictionaryGetValueIfPresent(_blockIndexes, block, &index)) return NSNotFound;
+    return (NSUInteger)index;
+}
+
+- (void) dealloc
+{
+    CFRelease(_blockIndexes);
+    self.fingerprint = nil;
+    self.lookups = nil;
+    [super dealloc];
+}
+
+@end
+
+@interface HBTemplateProfile ()
+{
+    NSUInteger _totalOutputLength;
+}
+@property (readwrite) NSUInteger renderCount;
+@property (readwrite) NSUInteger maximumOutputLength;
+@property (copy, nonatomic) NSString* fingerprint; // of the sites blocks and lookupClassNames were recorded for
+@property (retain, nonatomic) NSData* blocks; // hb_block_profile of each block, replaced rather than modified
+@property (retain, nonatomic) NSArray* lookupClassNames; // for each lookup, for each key, names of receiver classes
+@end
+
+@implementation HBTemplateProfile
+
+- (id) initWithPropertyList:(id)propertyList
+{
+    self = [self init];
+    if (!self) return nil;
+    
+    NSDictionary* dictionary = [propertyList isKindOfClass:[NSDictionary class]] ? propertyList : nil;
+    NSNumber* version = dictionary[@"version"];
+    if (![version isKindOfClass:[NSNumber class]] || [version integerValue] != HBTemplateProfileVersion) {
+        [self release];
+        return nil;
+    }
+    
+    for (NSString* key in @[ @"renderCount", @"totalOutputLength", @"maximumOutputLength" ]) {
+        if (![dictionary[key] isKindOfClass:[NSNumber class]]) {
+            [self release];
+            return nil;
+        }
+    }
+    self.renderCount = [dictionary[@"renderCount"] unsignedIntegerValue];
+    _totalOutputLength = [dictionary[@"totalOutputLength"] unsignedIntegerValue];
+    self.maximumOutputLength = [dictionary[@"maximumOutputLength"] unsignedIntegerValue];
+    
+    // sites are optional: they are forgotten if malformed
+    NSString* fingerprint = dictionary[@"fingerprint"];
+    NSArray* blocks = dictionary[@"blocks"];
+    NSArray* lookups = dictionary[@"lookups"];
+    if ([fingerprint isKindOfClass:[NSString class]] && [blocks isKindOfClass:[NSArray class]] && [lookups isKindOfClass:[NSArray class]]) {
+        NSMutableData* blockProfiles = [NSMutableData dataWithLength:blocks.count * sizeof(hb_block_profile)];
+        hb_block_profile* profiles = [blockProfiles mutableBytes];
+        BOOL valid = YES;
+        for (NSUInteger i = 0; i < blocks.count && valid; i++) {
+            NSArray* counters = blocks[i];
+            valid = [counters isKindOfClass:[NSArray class]] && counters.count == 4;
+            for (NSUInteger j = 0; j < 4 && valid; j++) {
+                valid = [counters[j] isKindOfClass:[NSNumber class]];
+            }
+            if (!valid) break;
+            profiles[i].evaluations = [counters[0] unsignedIntegerValue];
+            profiles[i].iterations = [counters[1] unsignedIntegerValue];
+            profiles[i].inverses = [counters[2] unsignedIntegerValue];
+            profiles[i].outputLength = [counters[3] unsignedIntegerValue];
+        }
+        for (NSArray* keys in lookups) {
+            if (!valid) break;
+            valid = [keys isKindOfClass:[NSArray class]];
+            for (NSArray* classNames in (valid ? keys : nil)) {
+                valid = valid && [classNames isKindOfClass:[NSArray class]];
+                for (NSString* className in (valid ? classNames : nil)) {
+                    valid = valid && [className isKindOfClass:[NSString class]];
+                }
+            }
+        }
+        if (valid) {
+            self.fingerprint = fingerprint;
+            self.blocks = blockProfiles;
+            self.lookupClassNames = lookups;
+        }
+    }
+    
+    return self;
+}
+
+- (id) propertyList
+{
+    @synchronized(self) {
+        NSMutableDictionary* propertyList = [NSMutableDictionary dictionary];
+        propertyList[@"version"] = @(HBTemplateProfileVersion);
+        propertyList[@"renderCount"] = @(self.renderCount);
+        propertyList[@"totalOutputLength"] = @(_totalOutputLength);
+        propertyList[@"maximumOutputLength"] = @(self.maximumOutputLength);
+        
+        if (self.fingerprint) {
+            NSUInteger blockCount = self.blocks.length / sizeof(hb_block_profile);
+            const hb_block_profile* profiles = [self.blocks bytes];
+            NSMutableArray* blocks = [NSMutableArray arrayWithCapacity:blockCount];
+            for (NSUInteger i = 0; i < blockCount; i++) {
+                [blocks addObject:@[ @(profiles[i].evaluations), @(profiles[i].iterations), @(profiles[i].inverses), @(profiles[i].outputLength) ]];
+            }
+            propertyList[@"fingerprint"] = self.fingerprint;
+            propertyList[@"blocks"] = blocks;
+            propertyList[@"lookups"] = self.lookupClassNames ? self.lookupClassNames : @[];
+        }
+        
+        return propertyList;
+    }
+}
+
+- (NSUInteger) averageOutputLength
+{
+    @synchronized(self) {
+        return self.renderCount ? _totalOutputLength / self.renderCount : 0;
+    }
+}
+
+// renders of about the average length fit, without reserving room for the longest ones
+- (NSUInteger) estimatedOutputLength
+{
+    NSUInteger averageOutputLength = self.averageOutputLength;
+    return MIN(averageOutputLength + averageOutputLength / 4, self.maximumOutputLength);
+}
+
+// whether blocks and lookups were recorded for sites. Caller must hold the lock.
+- (BOOL) appliesToSites:(HBTemplateProfileSites*)sites
+{
+    return [self.fingerprint isEqualToString:sites.fingerprint] && self.blocks.length == sites.blockCount * sizeof(hb_block_profile);
+}
+
+- (NSData*) blockProfilesForSites:(HBTemplateProfileSites*)sites
+{
+    @synchronized(self) {
+        if (![self appliesToSites:sites]) return nil;
+        return [[self.blocks retain] autorelease];
+    }
+}
+
+- (void) recordRenderWithOutputLength:(NSUInteger)outputLength blocks:(const hb_block_profile*)blocks sites:(HBTemplateProfileSites*)sites
+{
+    @synchronized(self) {
+        self.renderCount++;
+        _totalOutputLength += outputLength;
+        self.maximumOutputLength = MAX(self.maximumOutputLength, outputLength);
+        
+        // the template changed: what was recorded about its blocks and lookups does not apply anymore
+        if (![self appliesToSites:sites]) {
+            self.fingerprint = sites.fingerprint;
+            self.blocks = [NSMutableData dataWithLength:sites.blockCount * sizeof(hb_block_profile)];
+            self.lookupClassNames = nil;
+        }
+        
+        NSMutableData* blockProfiles = [[self.blocks mutableCopy] autorelease];
+        hb_block_profile* profiles = [blockProfiles mutableBytes];
+        for (NSUInteger i = 0; i < sites.blockCount; i++) {
+            profiles[i].evaluations += blocks[i].evaluations;
+            profiles[i].iterations += blocks[i].iterations;
+            profiles[i].inverses += blocks[i].inverses;
+            profiles[i].outputLength += blocks[i].outputLength;
+        }
+        self.blocks = blockProfiles;
+        
+        // classes recorded first are kept when there are more than caches hold
+        NSMutableArray* lookupClassNames = [NSMutableArray arrayWithCapacity:sites.lookups.count];
+        [sites.lookups enumerateObjectsUsingBlock:^(HBAstContextualValue* value, NSUInteger index, BOOL* stop) {
+            NSArray* recordedKeys = (index < self.lookupClassNames.count) ? self.lookupClassNames[index] : nil;
+            NSMutableArray* keys = [NSMutableArray arrayWithCapacity:value.lookupKeyCount];
+            hb_property_cache* caches = value.propertyCaches;
+            for (NSUInteger key = 0; key < value.lookupKeyCount; key++) {
+                NSMutableOrderedSet* classNames = [NSMutableOrderedSet orderedSet];
+                if (key < recordedKeys.count) [classNames addObjectsFromArray:recordedKeys[key]];
+                for (Class objectClass in [HBObjectPropertyAccess classesInCache:(caches ? &caches[key] : NULL)]) {
+                    if (classNames.count >= HB_PROPERTY_CACHE_SIZE) break;
+                    [classNames addObject:NSStringFromClass(objectClass)];
+                }
+                [keys addObject:[classNames array]];
+            }
+            [lookupClassNames addObject:keys];
+        }];
+        self.lookupClassNames = lookupClassNames;
+    }
+}
+
+- (void) prepareLookupsOfSites:(HBTemplateProfileSites*)sites
+{
+    NSArray* lookupClassNames = nil;
+    @synchronized(self) {
+        if (![self appliesToSites:sites]) return;
+        lookupClassNames = [[self.lookupClassNames retain] autorelease];
+    }
+    
+    [sites.lookups enumerateObjectsUsingBlock:^(HBAstContextualValue* value, NSUInteger index, BOOL* stop) {
+        if (index >= lookupClassNames.count) {
+            *stop = YES;
+            return;
+        }
+        NSArray* keys = lookupClassNames[index];
+        for (NSUInteger key = 0; key < value.lookupKeyCount && key < keys.count; key++) {
+            for (NSString* className in keys[key]) {
+                Class objectClass = NSClassFromString(className);
+                if (objectClass) [HBObjectPropertyAccess addClass:objectClass toCache:&[value allocatePropertyCaches][key] forKey:value.lookupKeys[key]];
+            }
+        }
+    }];
+}
+
+- (void) dealloc
+{
+    self.fingerprint = nil;
+    self.blocks = nil;
+    self.lookupClassNames = nil;
+    [super dealloc];
+}
+
+@end
+
+@implementation HBAstProfileSitesVisitor
+
+- (void) visitNodes:(NSArray*)nodes
+{
+    for (HBAstNode* node in nodes) {
+        [self visitNode:node];
+    }
+}
+
+- (id) visitProgram:(HBAstProgram*)node
+{
+    [self visitNodes:node.statements];
+    return nil;
+}
+
+- (id) visitBlock:(HBAstBlock*)node
+{
+    CFDictionarySetValue(self.blockIndexes, node, (const void*)(NSUInteger)CFDictionaryGetCount(self.blockIndexes));
+    [self.signature appendString:@"#"];
+    if (node.expression) [self visitNode:node.expression];
+    [self visitNodes:node.statements];
+    [self.signature appendString:@"^"];
+    [self visitNodes:node.inverseStatements];
+    [self.signature appendString:@"/"];
+    return nil;
+}
+
+- (id) visitPartialTag:(HBAstPartialTag*)node
+{
+    [self.signature appendFormat:@">%@", node.partialName.sourceRepresentation];
+    if (node.context) [self visitNode:node.context];
+    [self visitParametersHash:node.namedParameters];
+    return nil;
+}
+
+- (id) visitSimpleTag:(HBAstSimpleTag*)node
+{
+    if (node.expression) [self visitNode:node.expression];
+    return nil;
+}
+
+- (id) visitExpression:(HBAstExpression*)node
+{
+    [self.signature appendString:@"("];
+    if (node.mainValue) [self visitNode:node.mainValue];
+    [self visitNodes:node.positionalParameters];
+    [self visitParametersHash:node.namedParameters];
+    [self.signature appendString:@")"];
+    return nil;
+}
+
+- (id) visitParametersHash:(HBAstParametersHash*)node
+{
+    for (NSString* name in node) {
+        [self.signature appendFormat:@"%@=", name];
+        [self visitNode:node[name]];
+    }
+    return nil;
+}
+
+- (id) visitContextualValue:(HBAstContextualValue*)node
+{
+    [node compileLookupDescriptor];
+    [self.lookups addObject:node];
+    [self.signature appendFormat:@"%@%@ ", node.isDataValue ? @"@" : @"", node.sourceRepresentation];
+    return nil;
+}
+
+- (void) dealloc
+{
+    self.lookups = nil;
+    self.signature = nil;
+    [super dealloc];
+}
+
+@end
@@ -0,0 +1,70 @@
+//
+//  HBTemplateProfile_Private.h
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBTemplateProfile.h"
+
+@class HBAstProgram;
+@class HBAstBlock;
+
+// How a block rendered, summed over renders
+typedef struct {
+    NSUInteger evaluations;  // times the block was rendered
+    NSUInteger iterations;   // times its statements were rendered: branch taken by conditions, trip count of loops
+    NSUInteger inverses;     // times its inverse statements were rendered
+    NSUInteger outputLength; // length of its statements rendered
+} hb_block_profile;
+
+// Blocks and contextual values of a program, numbered in the order they appear in the template, so that profiles saved
+// by a process apply to the same template parsed by another. fingerprint identifies the template they were numbered in.
+@interface HBTemplateProfileSites : NSObject
+
+- (id) initWithProgram:(HBAstProgram*)program;
+
+@property (readonly, nonatomic) NSString* fingerprint;
+@property (readonly, nonatomic) NSUInteger blockCount;
+@property (readonly, nonatomic) NSArray* /* HBAstContextualValue */ lookups;
+
+- (NSUInteger) indexOfBlock:(HBAstBlock*)block; // NSNotFound for blocks of other programs
+
+@end
+
+@interface HBTemplateProfile ()
+
+// output length renders can be expected to fit in, 0 when no render was recorded
+- (NSUInteger) estimatedOutputLength;
+
+// hb_block_profile of each block of sites, nil when the profile was recorded for another template
+- (NSData*) blockProfilesForSites:(HBTemplateProfileSites*)sites;
+
+// Adds a render, where each block of sites rendered as blocks tells. Receiver classes of lookups are read from the
+// inline caches of the lookups of sites.
+- (void) recordRenderWithOutputLength:(NSUInteger)outputLength blocks:(const hb_block_profile*)blocks sites:(HBTemplateProfileSites*)sites;
+
+// Fills the inline caches of the lookups of sites with the receiver classes recorded
+- (void) prepareLookupsOfSites:(HBTemplateProfileSites*)sites;
+
+@end
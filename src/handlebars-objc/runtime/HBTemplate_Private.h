@@ -31,15 +31,46 @@
 @class HBAstProgram;
 @class HBExecutionContext;
 @class HBPartial;
+@class HBArchivedProgram;
+@class HBBytecode;
+@class HBClosureTree;
+@class HBTemplateProfileSites;
 
 @interface HBTemplate()
 
 @property (readwrite) BOOL compiled;
 @property (retain, nonatomic) HBAstProgram* program;
+@property (retain, nonatomic) HBAstProgram* inlinedProgram; // program with its partials spliced in, when the template inlines partials. Dropped when program changes.
+@property (retain, nonatomic) NSDictionary* inlinedPartials; // partials spliced into inlinedProgram, by name
+@property (retain, nonatomic) HBAstProgram* foldedProgram; // inlinedProgram, or program, with its constant conditions folded. Dropped when they change.
+@property (retain, nonatomic) NSDictionary* foldedHelpers; // what the helpers of literal conditions resolved to when folding, by name
+@property (readonly, nonatomic) HBAstProgram* executableProgram; // program rendered: foldedProgram, inlinedProgram or program, the first there is
+@property (retain, nonatomic) HBBytecode* bytecode; // executableProgram lowered for the bytecode engine when it is the engine in use. Dropped when program changes.
+@property (retain, nonatomic) HBClosureTree* closureTree; // executableProgram compiled for the closure engine when it is the engine in use. Dropped when program changes.
+@property (retain, nonatomic) id templateSource; // file URL, NSInputStream, file descriptor NSNumber, UTF-8 NSData or HBArchivedProgram, when there is no templateString
+@property (assign, nonatomic) HBRenderFunction renderFunction; // generated ahead of time. Such templates have no program.
 @property (retain, nonatomic) HBExecutionContext* templateLocalExecutionContext;
 @property (retain, nonatomic) HBExecutionContext* sharedExecutionContext;
+@property (readonly, nonatomic) HBTemplateProfileSites* profileSites; // blocks and lookups of program, numbered for profiles. Dropped when program changes.
+
+// What a render executes. Compiling replaces derived programs, bytecode and closure trees when registries
+// change, maybe while other threads render: renders take these together, once, under the template lock.
+- (void) getProgram:(HBAstProgram**)program executableProgram:(HBAstProgram**)executableProgram bytecode:(HBBytecode**)bytecode closureTree:(HBClosureTree**)closureTree;
+
+// output length renders are expected to fit in, from the profile or from the length of the template
+- (NSUInteger) estimatedOutputLength;
+
+// precompiled template, see -[HBExecutionContext templatesWithPrecompiledData:error:]
+- (id) initWithArchivedProgram:(HBArchivedProgram*)program;
 
 - (HBHelper*) helperForName:(NSString*)name;
+
+// Helper calls are bound to the helper they resolve to, see -[HBAstExpression helperBinding]. A binding
+// is valid for every template resolving helpers through the registries whose tokens it carries (template
+// local and shared, see -[HBHelperRegistry bindingToken]), as long as +[HBHelperRegistry currentGeneration]
+// does not change. Templates whose execution contexts have a delegate providing helpers cannot bind them.
+- (void) getHelperBindingScope:(NSUInteger*)localToken shared:(NSUInteger*)sharedToken;
+@property (readonly, nonatomic) BOOL canBindHelpers;
 - (HBPartial*) partialForName:(NSString*)name;
 
 - (NSString*) escapeString:(NSString*)rawString forTargetFormat:(NSString*)formatName;
@@ -13,7 +13,34 @@
 
 - (NSString*) renderTemplate:(NSString*)template withContext:(id)context withHelpers:(NSDictionary*)helpers withPartials:(NSDictionary*)partials error:(NSError**)error
 {
-    return [HBHandlebars renderTemplateString:template withContext:context withHelperBlocks:helpers withPartialStrings:partials error:error];
+    NSString* result = [HBHandlebars renderTemplateString:template withContext:context withHelperBlocks:helpers withPartialStrings:partials error:error];
+    
+    // every template is also rendered to UTF-8 data, which must hold the same text
+    HBTemplate* hbTemplate = [[[HBTemplate alloc] initWithUTF8Data:[template dataUsingEncoding:NSUTF8StringEncoding]] autorelease];
+    if (helpers) [hbTemplate.helpers registerHelperBlocks:helpers];
+    if (partials) [hbTemplate.partials registerPartialStrings:partials];
+    NSError* dataError = nil;
+    NSData* data = [hbTemplate renderDataWithContext:context error:&dataError];
+    if (result) {
+        XCTAssertEqualObjects(data, [result dataUsingEncoding:NSUTF8StringEncoding]);
+    }
+    if (error) XCTAssertEqual(dataError == nil, *error == nil);
+    
+    // and by the other engines, which must render the same
+    for (NSNumber* engine in @[ @(HBTemplateEngineBytecode), @(HBTemplateEngineClosures) ]) {
+        HBTemplate* engineTemplate = [[[HBTemplate alloc] initWithString:template] autorelease];
+        engineTemplate.engine = [engine integerValue];
+        if (helpers) [engineTemplate.helpers registerHelperBlocks:helpers];
+        if (partials) [engineTemplate.partials registerPartialStrings:partials];
+        NSError* engineError = nil;
+        NSString* engineResult = [engineTemplate renderWithContext:context error:&engineError];
+        if (result) {
+            XCTAssertEqualObjects(engineResult, result);
+        }
+        if (error) XCTAssertEqual(engineError == nil, *error == nil);
+    }
+    
+    return result;
 }
 
 - (NSString*) renderTemplate:(NSString*)template withContext:(id)context withHelpers:(NSDictionary*)helpers withPartials:(NSDictionary*)partials
@@ -0,0 +1,149 @@
+//
+//  HBTestCompiledEngines.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "HBHandlebars.h"
+#import "HBTemplate_Private.h"
+
+@interface HBTestCompiledEngines : XCTestCase
+
+@end
+
+@implementation HBTestCompiledEngines
+
+- (void)testCompiledEngines
+{
+    NSString* templateString = @"<ul>{{#each people}}<li class=\"{{#if @first}}first{{/if}}\">{{@index}}: {{> person}}{{#unless age}} ({{../unknown}}){{/unless}}</li>{{else}}<li>nobody</li>{{/each}}</ul>{{#with boss}}{{upper name suffix=\"!\"}}{{/with}}{{#shout}}{{boss.name}}{{/shout}}";
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    [executionContext registerPartialString:@"{{firstName}} {{{lastName}}}" forName:@"person"];
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) {
+        return [[callingInfo[0] uppercaseString] stringByAppendingString:callingInfo[@"suffix"]];
+    } forName:@"upper"];
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) {
+        return [callingInfo.statements(callingInfo.context, callingInfo.data) stringByAppendingString:@"!!"];
+    } forName:@"shout"];
+    
+    NSMutableArray* people = [NSMutableArray array];
+    for (NSInteger i = 0; i < 10; i++) {
+        [people addObject:@{ @"firstName" : [NSString stringWithFormat:@"first%ld", (long)i], @"lastName" : @"<b>last</b>", @"age" : @(i % 3) }];
+    }
+    NSArray* contexts = @[ @{ @"people" : people, @"boss" : @{ @"name" : @"b&b" }, @"unknown" : @"?" },
+                           @{ @"people" : @[], @"boss" : @{ @"name" : @"b" } } ];
+    
+    HBTemplate* interpreted = [executionContext templateWithString:templateString];
+    NSString* brokenString = [@"{{missingHelper 1}}{{> missing}}" stringByAppendingString:templateString];
+    NSArray* engines = @[ @(HBTemplateEngineBytecode), @(HBTemplateEngineClosures) ];
+    NSError* error = nil;
+    for (NSNumber* engine in engines) {
+        HBTemplate* compiled = [executionContext templateWithString:templateString];
+        compiled.engine = [engine integerValue];
+        for (id context in contexts) {
+            NSString* expected = [interpreted renderWithContext:context error:&error];
+            XCTAssertNil(error);
+            XCTAssertEqualObjects([compiled renderWithContext:context error:&error], expected);
+            XCTAssertEqualObjects([compiled renderDataWithContext:context error:&error], [expected dataUsingEncoding:NSUTF8StringEncoding]);
+            XCTAssertNil(error);
+        }
+        XCTAssertEqualObjects([compiled renderWithContext:contexts[1] error:&error], @"<ul><li>nobody</li></ul>B!b!!");
+        
+        // overridden builtin helpers are called like any other helper
+        [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return callingInfo.inverseStatements(callingInfo.context, callingInfo.data); } forName:@"each"];
+        XCTAssertEqualObjects([compiled renderWithContext:contexts[0] error:&error], [interpreted renderWithContext:contexts[0] error:&error]);
+        [executionContext unregisterHelperForName:@"each"];
+        
+        // only the first error is reported
+        HBTemplate* broken = [executionContext templateWithString:brokenString];
+        broken.engine = [engine integerValue];
+        NSString* expected = [[executionContext templateWithString:brokenString] renderWithContext:contexts[1] error:&error];
+        XCTAssertEqual(error.code, (NSInteger)HBErrorCodeHelperMissingError);
+        error = nil;
+        XCTAssertEqualObjects([broken renderWithContext:contexts[1] error:&error], expected);
+        XCTAssertEqual(error.code, (NSInteger)HBErrorCodeHelperMissingError);
+        error = nil;
+    }
+}
+
+- (void)testBytecodeEngineRegisters
+{
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) {
+        return [NSString stringWithFormat:@"%lu", (unsigned long)callingInfo.positionalParameters.count];
+    } forName:@"count"];
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) {
+        return [NSString stringWithFormat:@"(%@%@)", callingInfo[0], callingInfo.statements(callingInfo.context, callingInfo.data)];
+    } forName:@"wrap"];
+    [executionContext registerPartialString:@"{{#wrap depth}}{{#if next}}{{#with next}}{{> nested}}{{/with}}{{/if}}{{/wrap}}" forName:@"nested"];
+    
+    // statements nest deeper than the register file of the first frame
+    NSMutableDictionary* context = [NSMutableDictionary dictionaryWithObject:@200 forKey:@"depth"];
+    NSMutableString* expected = [NSMutableString stringWithString:@"(200"];
+    NSMutableDictionary* level = context;
+    for (NSInteger depth = 199; depth > 0; depth--) {
+        NSMutableDictionary* next = [NSMutableDictionary dictionaryWithObject:@(depth) forKey:@"depth"];
+        level[@"next"] = next;
+        level = next;
+        [expected appendFormat:@"(%ld", (long)depth];
+    }
+    [expected appendString:[@"" stringByPaddingToLength:200 withString:@")" startingAtIndex:0]];
+    HBTemplate* template = [executionContext templateWithString:@"{{> nested}}"];
+    template.engine = HBTemplateEngineBytecode;
+    NSError* error = nil;
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], expected);
+    XCTAssertNil(error);
+    
+    // more parameters than instructions can address are interpreted
+    NSMutableString* templateString = [NSMutableString stringWithString:@"{{count"];
+    for (NSInteger i = 0; i < UINT16_MAX + 10; i++) [templateString appendString:@" 1"];
+    [templateString appendString:@"}}"];
+    HBTemplate* large = [executionContext templateWithString:templateString];
+    large.engine = HBTemplateEngineBytecode;
+    XCTAssertEqualObjects([large renderWithContext:nil error:&error], ([NSString stringWithFormat:@"%d", UINT16_MAX + 10]));
+    XCTAssertNil(large.bytecode);
+    XCTAssertNil(error);
+}
+
+- (void)testCompiledEnginesAfterTemplateEdits
+{
+    NSArray* engines = @[ @(HBTemplateEngineBytecode), @(HBTemplateEngineClosures) ];
+    NSDictionary* context = @{ @"name" : @"Ann", @"town" : @"Oslo" };
+    NSError* error = nil;
+    for (NSNumber* engine in engines) {
+        HBTemplate* template = [[[HBTemplate alloc] initWithString:@"Hi {{name}}"] autorelease];
+        template.engine = [engine integerValue];
+        XCTAssertEqualObjects([template renderWithContext:context error:&error], @"Hi Ann");
+        
+        // edits must not render the code compiled before them
+        XCTAssert([template replaceCharactersInRange:NSMakeRange(0, 2) withString:@"Bye" error:&error]);
+        XCTAssertEqualObjects([template renderWithContext:context error:&error], @"Bye Ann");
+        template.templateString = @"{{town}}!";
+        XCTAssertEqualObjects([template renderWithContext:context error:&error], @"Oslo!");
+        XCTAssertEqualObjects([template renderDataWithContext:context error:&error], [@"Oslo!" dataUsingEncoding:NSUTF8StringEncoding]);
+        XCTAssertNil(error);
+    }
+}
+
+@end
@@ -0,0 +1,77 @@
+//
+//  HBTestConditionFolding.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "HBHandlebars.h"
+#import "HBTemplate_Private.h"
+#import "HBAst.h"
+
+@interface HBTestConditionFolding : XCTestCase
+
+@end
+
+@implementation HBTestConditionFolding
+
+- (void)testFoldedConditions
+{
+    NSString* templateString = @"{{#if true}}a{{else}}b{{/if}}{{#unless false}}c{{/unless}}{{#is \"x\" \"x\"}}d{{/is}}{{#gt 2 1}}e{{/gt}}{{#lt \"3\" 2}}f{{else}}g{{/lt}}{{#if 0 includeZero=true}}{{../x}}{{/if}}";
+    id context = @{ @"x" : @"X" };
+    HBTemplate* template = [[[HBTemplate alloc] initWithString:templateString] autorelease];
+    NSError* error = nil;
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"acdegX");
+    XCTAssertNil(error);
+    
+    // blocks whose statements refer to parent contexts are kept
+    NSArray* statements = template.foldedProgram.statements;
+    XCTAssertEqual(statements.count, (NSUInteger)6);
+    XCTAssert([statements[0] isKindOfClass:[HBAstRawText class]]);
+    XCTAssert([statements.lastObject isKindOfClass:[HBAstBlock class]]);
+    
+    // overridden helpers are called
+    [template.helpers registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return @"?"; } forName:@"if"];
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"?cdeg?");
+    [template.helpers removeHelperForName:@"if"];
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"acdegX");
+    XCTAssertNil(error);
+    
+    // and conditions are folded again while other threads render
+    __block volatile NSInteger failures = 0;
+    dispatch_apply(400, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+        @autoreleasepool {
+            if (index % 20 == 0) {
+                [template.helpers registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return @"?"; } forName:@"if"];
+            } else if (index % 20 == 10) {
+                [template.helpers removeHelperForName:@"if"];
+            }
+            NSString* result = [template renderWithContext:context error:nil];
+            if (![result isEqual:@"acdegX"] && ![result isEqual:@"?cdeg?"]) __sync_add_and_fetch(&failures, 1);
+        }
+    });
+    XCTAssertEqual(failures, (NSInteger)0);
+}
+
+@end
@@ -9,6 +9,10 @@
 #import <XCTest/XCTest.h>
 #import "HBHandlebars.h"
 #import "HBExecutionContext_Private.h"
+#import "HBTemplate_Private.h"
+#import "HBAst.h"
+#import "HBPartial_Private.h"
+#include <errno.h>
 
 @interface HBTestExecutionContext : XCTestCase
 
@@ -29,6 +33,7 @@
 
 @end
 
+
 @implementation HBTestExecutionContext
 
 - (void)testHelperBlocksDelegationOnExecutionContext
@@ -54,6 +59,95 @@
     XCTAssertEqualObjects(evaluation, @"h1-h2");
 }
 
+- (void)testHelperRegistrationsAfterRenderingAreHonored
+{
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    HBTemplate* template = [executionContext templateWithString:@"{{helper1}}-{{#helper2}}in{{/helper2}}"];
+    NSDictionary* context = @{ @"helper1" : @"v1", @"helper2" : @"v2" };
+    
+    NSError* error = nil;
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"v1-in");
+    
+    // helper calls are now bound to "not a helper"
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return @"h1"; } forName:@"helper1"];
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return @"h2"; } forName:@"helper2"];
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"h1-h2");
+    
+    // template local helpers take precedence
+    [template.helpers registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return @"local"; } forName:@"helper1"];
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"local-h2");
+    
+    [template.helpers removeAllHelpers];
+    [executionContext unregisterHelperForName:@"helper2"];
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"h1-in");
+    
+    // helpers provided by a delegate are never bound
+    SimpleExecutionContextDelegate* delegate = [[SimpleExecutionContextDelegate new] autorelease];
+    executionContext.delegate = delegate;
+    delegate.helperBlocks[@"helper1"] = ^(HBHelperCallingInfo* callingInfo) { return @"d1"; };
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"d1-in");
+    delegate.helperBlocks[@"helper1"] = ^(HBHelperCallingInfo* callingInfo) { return @"d2"; };
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"d2-in");
+    executionContext.delegate = nil;
+    XCTAssertNil(error);
+}
+
+
+- (void)testTemplateLifecycleKeepsOtherBindings
+{
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return @"h1"; } forName:@"helper1"];
+    HBTemplate* template = [executionContext templateWithString:@"{{helper1}}"];
+    NSError* error = nil;
+    XCTAssertEqualObjects([template renderWithContext:nil error:&error], @"h1");
+    
+    // creating, rendering and releasing templates leaves helper bindings and inlined partials alone
+    NSUInteger helperGeneration = [HBHelperRegistry currentGeneration];
+    NSUInteger partialGeneration = [HBPartialRegistry currentGeneration];
+    @autoreleasepool {
+        HBTemplate* other = [[[HBTemplate alloc] initWithString:@"{{helper1}}"] autorelease];
+        XCTAssertEqualObjects([other renderWithContext:@{ @"helper1" : @"v1" } error:&error], @"v1");
+        XCTAssertNotNil(other.helpers);
+        XCTAssertNotNil(other.partials);
+        XCTAssertEqualObjects([HBHandlebars renderTemplateString:@"{{helper1}}" withContext:@{ @"helper1" : @"v1" } error:&error], @"v1");
+    }
+    XCTAssertEqual([HBHelperRegistry currentGeneration], helperGeneration);
+    XCTAssertEqual([HBPartialRegistry currentGeneration], partialGeneration);
+    
+    // but a template moved to another execution context resolves its helpers again
+    template.sharedExecutionContext = [[HBExecutionContext new] autorelease];
+    XCTAssertEqualObjects([template renderWithContext:@{ @"helper1" : @"v1" } error:&error], @"v1");
+    template.sharedExecutionContext = executionContext;
+    XCTAssertEqualObjects([template renderWithContext:@{ @"helper1" : @"v1" } error:&error], @"h1");
+    XCTAssertNil(error);
+}
+
+- (void)testHelperBindingsAreSharedByTemplatesOfAnExecutionContext
+{
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return @"h1"; } forName:@"helper1"];
+    [executionContext registerPartialString:@"{{helper1}}" forName:@"partial"];
+    HBTemplate* template1 = [executionContext templateWithString:@"1:{{> partial}}"];
+    HBTemplate* template2 = [executionContext templateWithString:@"2:{{> partial}}"];
+    NSError* error = nil;
+    XCTAssertEqualObjects([template1 renderWithContext:nil error:&error], @"1:h1");
+    XCTAssertEqualObjects([template2 renderWithContext:nil error:&error], @"2:h1");
+    
+    // the partial's helper call is bound once for both templates
+    HBPartial* partial = [executionContext partialForName:@"partial"];
+    HBAstExpression* expression = ((HBAstSimpleTag*)partial.astStatements[0]).expression;
+    id binding = expression.helperBinding;
+    XCTAssertNotNil(binding);
+    XCTAssertEqualObjects([template1 renderWithContext:nil error:&error], @"1:h1");
+    XCTAssertEqualObjects([template2 renderWithContext:nil error:&error], @"2:h1");
+    XCTAssertEqual(expression.helperBinding, binding);
+    
+    // while templates with their own helpers bind it to these
+    [template2.helpers registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return @"local"; } forName:@"helper1"];
+    XCTAssertEqualObjects([template2 renderWithContext:nil error:&error], @"2:local");
+    XCTAssertEqualObjects([template1 renderWithContext:nil error:&error], @"1:h1");
+    XCTAssertNil(error);
+}
 
 - (void)testPartialStringsDelegationOnExecutionContext
 {
@@ -108,6 +202,29 @@
 }
 
 
+- (void)testDelegatedPartialsAreNotInlined
+{
+    SimpleExecutionContextDelegate* delegate = [[SimpleExecutionContextDelegate new] autorelease];
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    [executionContext registerPartialString:@"<b>{{name}}</b>{{> price}}" forName:@"card"];
+    HBTemplate* template = [executionContext templateWithString:@"{{#each items}}{{> card}};{{/each}}"];
+    template.inlinesPartials = YES;
+    id context = @{ @"items" : @[ @{ @"name" : @"a", @"price" : @1 }, @{ @"name" : @"b", @"price" : @2 } ] };
+    
+    // templates whose partials are provided by a delegate do not inline them
+    delegate.partialStrings[@"price"] = @" ({{price}})";
+    executionContext.delegate = delegate;
+    NSError* error = nil;
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"<b>a</b> (1);<b>b</b> (2);");
+    XCTAssertNil(error);
+    XCTAssertNil(template.inlinedProgram);
+    
+    delegate.partialStrings[@"price"] = @" {{price}}EUR";
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"<b>a</b> 1EUR;<b>b</b> 2EUR;");
+    XCTAssertNil(error);
+}
+
+
 - (void)testLocalizationDelegationOnExecutionContext
 {
     SimpleExecutionContextDelegate* delegate = [[SimpleExecutionContextDelegate new] autorelease];
@@ -163,7 +280,77 @@
     
     XCTAssertEqualObjects(evaluation, @"hel\\\"lo");
 }
+
+- (void)testBatchCompilationOnExecutionContext
+{
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+
+    NSMutableDictionary* templateStrings = [NSMutableDictionary dictionary];
+    for (NSInteger i = 0; i < 200; i++) {
+        templateStrings[[NSString stringWithFormat:@"template%ld", (long)i]] = [NSString stringWithFormat:@"%ld: {{#each items}}{{> item}}{{/each}}", (long)i];
+    }
+    templateStrings[@"broken"] = @"{{#each items}}";
+
+    NSDictionary* partialStrings = @{ @"item" : @"[{{name}}]", @"brokenPartial" : @"{{name" };
+
+    NSDictionary* templateErrors = nil;
+    NSDictionary* partialErrors = nil;
+    NSTimeInterval compilationTime = -1;
+    NSDictionary* templates = [executionContext compileTemplateStrings:templateStrings partialStrings:partialStrings templateErrors:&templateErrors partialErrors:&partialErrors compilationTime:&compilationTime];
+
+    XCTAssertEqual(templates.count, templateStrings.count);
+    XCTAssertEqualObjects([templateErrors allKeys], @[ @"broken" ]);
+    XCTAssertEqualObjects([partialErrors allKeys], @[ @"brokenPartial" ]);
+    XCTAssert(compilationTime >= 0);
+
+    NSError* error = nil;
+    NSString* evaluation = [templates[@"template42"] renderWithContext:@{ @"items" : @[ @{ @"name" : @"a" }, @{ @"name" : @"b" } ] } error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(evaluation, @"42: [a][b]");
+}
+
+- (void)testTemplatesReadFromFilesAndStreamsOnExecutionContext
+{
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    [executionContext registerPartialString:@"[{{name}}]" forName:@"item"];
+
+    NSData* data = [@"héllo {{#each items}}{{> item}}{{/each}}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    XCTAssert([data writeToFile:path atomically:NO]);
+
+    NSArray* templates = @[ [executionContext templateWithContentsOfFile:path], [executionContext templateWithInputStream:[NSInputStream inputStreamWithData:data]] ];
+    for (HBTemplate* template in templates) {
+        NSError* error = nil;
+        NSString* evaluation = [template renderWithContext:@{ @"items" : @[ @{ @"name" : @"a" }, @{ @"name" : @"b" } ] } error:&error];
+        XCTAssertNil(error);
+        XCTAssertNil(template.templateString);
+        XCTAssertEqualObjects(evaluation, @"héllo [a][b]");
+    }
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testTemplatesReadFromStreamsCompileAgain
+{
+    NSData* data = [@"héllo {{#each items}}{{name}}{{/if}}" dataUsingEncoding:NSUTF8StringEncoding];
+    HBTemplate* template = [[[HBTemplate alloc] initWithInputStream:[NSInputStream inputStreamWithData:data]] autorelease];
     
+    // a failed compilation is not followed by one of the empty rest of the stream
+    NSError* error = nil;
+    XCTAssertFalse([template compile:&error]);
+    XCTAssertNotNil(error);
+    error = nil;
+    XCTAssertFalse([template compile:&error]);
+    XCTAssertNotNil(error);
+    
+    // read errors are reported as such
+    template = [[[HBTemplate alloc] initWithFileDescriptor:-1] autorelease];
+    error = nil;
+    XCTAssertFalse([template compile:&error]);
+    XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+    XCTAssertEqual(error.code, (NSInteger)EBADF);
+}
+
 @end
 
 
@@ -241,4 +428,4 @@
     else return nil;
 }
 
-@end
\ No newline at end of file
+@end
@@ -0,0 +1,73 @@
+//
+//  HBTestFixtures.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import "HBTestFixtures.h"
+
+@implementation HBTestCorpus
+
++ (NSArray*) templates
+{
+    NSArray* templates = @[
+        @"<html>\n<head><title>{{title}}</title></head>\n<body>\n{{> header}}\n<h1>{{title}}</h1>\n{{#if author}}<p class=\"author\">by {{author.firstName}} {{author.lastName}}</p>{{/if}}\n{{{body}}}\n{{> footer year=2014}}\n</body>\n</html>\n",
+        @"<ul class=\"people\">\n{{#each people}}\n  <li class=\"{{#if @first}}first{{/if}}\">{{@index}}: {{firstName}} {{lastName}} ({{age}})</li>\n{{else}}\n  <li>{{localize 'nobody'}}</li>\n{{/each}}\n</ul>\n",
+        @"{{! not part of the output }}\n<div class=\"entry\">\n  {{#with story}}\n    <div class=\"intro\">{{{intro}}}</div>\n    <div class=\"body\">{{{body}}}</div>\n    {{#unless published}}<em>draft</em>{{/unless}}\n  {{/with}}\n</div>\n",
+        @"{{#each comments}}\n<h2><a href=\"/posts/{{../permalink}}#{{id}}\">{{title}}</a></h2>\n<div>{{format body maxLength=200 ellipsis=\"...\" strip=true}}</div>\n{{~/each}}\n",
+        @"{{#each items}}{{#if (gt price 10)}}<b>{{currency price 'EUR'}}</b>{{else}}{{price}}{{/if}}{{/each}} \\{{escaped}} {{{{raw}}}} {{not parsed}} {{{{/raw}}}}",
+    ];
+    
+    NSMutableArray* corpus = [NSMutableArray array];
+    for (NSString* template in templates) {
+        // a little bit of everything, and some large templates too
+        [corpus addObject:template];
+        [corpus addObject:[@"" stringByPaddingToLength:template.length * 50 withString:template startingAtIndex:0]];
+    }
+    return corpus;
+}
+
++ (NSArray*) staticTextTemplates
+{
+    NSString* paragraph = @"<p class=\"lead\">Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.</p>\n";
+    NSMutableArray* corpus = [NSMutableArray array];
+    for (NSUInteger paragraphs = 1; paragraphs <= 1000; paragraphs *= 10) {
+        NSString* text = [@"" stringByPaddingToLength:paragraph.length * paragraphs withString:paragraph startingAtIndex:0];
+        [corpus addObject:[NSString stringWithFormat:@"<html><head><title>{{title}}</title></head>\n<body>\n%@{{> footer}}\n%@</body></html>\n", text, text]];
+    }
+    return corpus;
+}
+
+@end
+
+
+@implementation CountingPerson
+
+- (NSString*) name
+{
+    self.nameReads++;
+    return @"Ann";
+}
+
+@end
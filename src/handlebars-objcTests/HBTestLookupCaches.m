@@ -0,0 +1,126 @@
+//
+//  HBTestLookupCaches.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "HBHandlebars.h"
+#import "HBTemplate_Private.h"
+#import "HBAst.h"
+#import "HBObjectPropertyAccess.h"
+#import "HBTestFixtures.h"
+
+@interface HBTestLookupCaches : XCTestCase
+
+@end
+
+@implementation HBTestLookupCaches
+
+- (void)testRepeatedLookupsAreCached
+{
+    CountingPerson* person = [[CountingPerson new] autorelease];
+    id context = @{ @"order" : @{ @"user" : person } };
+    HBTemplate* template = [[[HBTemplate alloc] initWithString:@"{{#with order}}{{user.name}} {{user.name}}{{#if user}} {{user.name}}{{/if}}{{/with}}"] autorelease];
+    
+    // every mustache reads its key path unless the template opts in
+    XCTAssertEqualObjects([template renderWithContext:context error:nil], @"Ann Ann Ann");
+    XCTAssertEqual(person.nameReads, (NSInteger)3);
+    
+    person.nameReads = 0;
+    template.cachesRepeatedLookups = YES;
+    // once in the scope of with, where it is repeated, and once in the scope of if
+    XCTAssertEqualObjects([template renderWithContext:context error:nil], @"Ann Ann Ann");
+    XCTAssertEqual(person.nameReads, (NSInteger)2);
+    
+    // cache keys are interned by the program, and released with it
+    HBTemplate* other = [[[HBTemplate alloc] initWithString:@"{{user.name}} {{user.name}}"] autorelease];
+    XCTAssertTrue([other compile:nil]);
+    XCTAssertEqual(template.program.lookupCacheKeys.count, (NSUInteger)1);
+    XCTAssertEqualObjects(other.program.lookupCacheKeys.allKeys, template.program.lookupCacheKeys.allKeys);
+    XCTAssertNotEqual(other.program.lookupCacheKeys.allValues[0], template.program.lookupCacheKeys.allValues[0]);
+    
+    person.nameReads = 0;
+    template.engine = HBTemplateEngineClosures;
+    XCTAssertEqualObjects([template renderWithContext:context error:nil], @"Ann Ann Ann");
+    XCTAssertEqual(person.nameReads, (NSInteger)2);
+    
+    person.nameReads = 0;
+    template.cachesRepeatedLookups = NO;
+    XCTAssertEqualObjects([template renderWithContext:context error:nil], @"Ann Ann Ann");
+    XCTAssertEqual(person.nameReads, (NSInteger)3);
+}
+
+- (void)testHelpersModifyingContextsNeedLookupCachingCleared
+{
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) {
+        callingInfo.context[@"name"] = @"Bob";
+        return @"";
+    } forName:@"rename"];
+    
+    for (NSNumber* engine in @[ @(HBTemplateEngineInterpreter), @(HBTemplateEngineBytecode), @(HBTemplateEngineClosures) ]) {
+        HBTemplate* template = [executionContext templateWithString:@"{{name}} {{rename}}{{name}}"];
+        template.engine = [engine integerValue];
+        template.cachesRepeatedLookups = YES;
+        
+        // the repeated lookup reuses the value read before the helper ran
+        XCTAssertEqualObjects([template renderWithContext:[NSMutableDictionary dictionaryWithObject:@"Ann" forKey:@"name"] error:nil], @"Ann Ann");
+        
+        template.cachesRepeatedLookups = NO;
+        XCTAssertEqualObjects([template renderWithContext:[NSMutableDictionary dictionaryWithObject:@"Ann" forKey:@"name"] error:nil], @"Ann Bob");
+    }
+}
+
+- (void)testPropertyAccessInlineCaches
+{
+    CountingPerson* person = [[CountingPerson new] autorelease];
+    NSArray* objects = @[ @{ @"name" : @"Bob" }, [NSMutableDictionary dictionaryWithObject:@"Cid" forKey:@"name"], person, @"string", @[ @1 ], [NSNull null] ];
+    NSArray* expectedValues = @[ @"Bob", @"Cid", @"Ann", [NSNull null], [NSNull null], [NSNull null] ];
+    
+    // first pass fills the cache, and later passes read through it, the same values as the generic path
+    hb_property_cache cache = { 0 };
+    for (NSInteger pass = 0; pass < 3; pass++) {
+        for (NSUInteger i = 0; i < objects.count; i++) {
+            id value = [HBObjectPropertyAccess valueForKey:@"name" onObject:objects[i] cache:&cache];
+            XCTAssertEqualObjects(value ? value : [NSNull null], expectedValues[i]);
+            XCTAssertEqualObjects(value, [HBObjectPropertyAccess valueForKey:@"name" onObject:objects[i]]);
+        }
+    }
+    XCTAssertEqual(person.nameReads, (NSInteger)6);
+    
+    // scalar properties are still boxed
+    hb_property_cache readsCache = { 0 };
+    for (NSInteger pass = 0; pass < 2; pass++) {
+        XCTAssertEqualObjects([HBObjectPropertyAccess valueForKey:@"nameReads" onObject:person cache:&readsCache], @6);
+    }
+    
+    // through templates, with a lookup site seeing several classes
+    HBTemplate* template = [[[HBTemplate alloc] initWithString:@"{{#each objects}}{{name}},{{/each}}"] autorelease];
+    for (NSInteger pass = 0; pass < 2; pass++) {
+        XCTAssertEqualObjects([template renderWithContext:@{ @"objects" : objects } error:nil], @"Bob,Cid,Ann,,,,");
+    }
+}
+
+@end
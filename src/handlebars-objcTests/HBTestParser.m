@@ -29,6 +29,17 @@
 #import "HBAst.h"
 #import "HBAstParserTestVisitor.h"
 #import "HBParser.h"
+#import "HBAstArchive.h"
+#import "HBTemplate.h"
+#import "HBTemplate_Private.h"
+#import "HBTextScanner.h"
+#import "HBErrorHandling.h"
+#import "HBAstFreezingVisitor.h"
+#import "HBTemplateProfile_Private.h"
+#import "HBTestFixtures.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <malloc/malloc.h>
 
 extern int hb_debug;
 
@@ -37,14 +48,58 @@ extern int hb_debug;
 
 @implementation HBTestParser
 
+// Every test goes through both parser implementations, which must agree on the
+// resulting AST, or on the line and position of the parse error.
+
 - (NSString*)astString:(NSString*)handlebarsString error:(NSError**)error
+{
+    NSError* flexBisonError = nil;
+    NSString* flexBisonSpans = nil;
+    NSString* flexBisonResult = [self astString:handlebarsString implementation:HBParserImplementationFlexBison spans:&flexBisonSpans error:&flexBisonError];
+    
+    NSError* recursiveDescentError = nil;
+    NSString* recursiveDescentSpans = nil;
+    NSString* recursiveDescentResult = [self astString:handlebarsString implementation:HBParserImplementationRecursiveDescent spans:&recursiveDescentSpans error:&recursiveDescentError];
+    
+    XCTAssertEqualObjects(recursiveDescentResult, flexBisonResult, @"parsers disagree on '%@'", handlebarsString);
+    XCTAssertEqualObjects(recursiveDescentSpans, flexBisonSpans, @"parsers disagree on source spans of '%@'", handlebarsString);
+    XCTAssertEqual(recursiveDescentError == nil, flexBisonError == nil, @"parsers disagree on '%@'", handlebarsString);
+    if (flexBisonError && recursiveDescentError) {
+        XCTAssertEqual(((HBParseError*)recursiveDescentError).lineNumber, ((HBParseError*)flexBisonError).lineNumber, @"parsers disagree on '%@'", handlebarsString);
+        XCTAssertEqual(((HBParseError*)recursiveDescentError).positionInBuffer, ((HBParseError*)flexBisonError).positionInBuffer, @"parsers disagree on '%@'", handlebarsString);
+    }
+    
+    if (error) *error = flexBisonError;
+    return flexBisonResult;
+}
+
+- (NSString*)astString:(NSString*)handlebarsString implementation:(HBParserImplementation)implementation error:(NSError**)error
+{
+    return [self astString:handlebarsString implementation:implementation spans:NULL error:error];
+}
+
+// source spans of statements, nested ones in brackets
+- (NSString*)spansOfStatements:(NSArray*)statements
+{
+    NSMutableString* spans = [NSMutableString string];
+    for (HBAstNode* statement in statements) {
+        [spans appendFormat:@"%lu+%lu ", (unsigned long)statement.sourceSpan.location, (unsigned long)statement.sourceSpan.length];
+        if ([statement isKindOfClass:[HBAstBlock class]]) {
+            [spans appendFormat:@"[%@|%@] ", [self spansOfStatements:((HBAstBlock*)statement).statements], [self spansOfStatements:((HBAstBlock*)statement).inverseStatements]];
+        }
+    }
+    return spans;
+}
+
+- (NSString*)astString:(NSString*)handlebarsString implementation:(HBParserImplementation)implementation spans:(NSString**)spans error:(NSError**)error
 {
     NSError* parseError = nil;
-    HBAstProgram* program = [HBParser astFromString:handlebarsString error:&parseError];
+    HBAstProgram* program = [HBParser astFromString:handlebarsString implementation:implementation error:&parseError];
     if (parseError) {
         if (error) *error = parseError;
         return nil;
     }
+    if (spans) *spans = [self spansOfStatements:program.statements];
     
     HBAstParserTestVisitor* visitor = [[HBAstParserTestVisitor alloc] initWithRootAstNode:program];
     NSString* parsedString = [visitor testStringRepresentation];
@@ -342,5 +397,483 @@ extern int hb_debug;
     
     XCTAssertEqualObjects([self astString:@"aaa {{{{foo}}}} {{a}} {{{{/foo}}}} bbbb" error:&error], @"CONTENT[ 'aaa ' ]\nBLOCK:\n  {{ ID:foo [] }}\n  PROGRAM:\n    CONTENT[ ' {{a}} ' ]\n\nCONTENT[ ' bbbb' ]\n");
     XCTAssert(!error, @"evaluation should not generate an error");
+    
+    // raw content spans lines
+    XCTAssertEqualObjects([self astString:@"{{{{foo}}}}\n{{a}}\n{{{{{/foo}}}} {{b}}" error:&error], @"BLOCK:\n  {{ ID:foo [] }}\n  PROGRAM:\n    CONTENT[ '\n{{a}}\n{' ]\n\nCONTENT[ ' ' ]\n{{ ID:b [] }}\n");
+    XCTAssert(!error, @"evaluation should not generate an error");
+}
+
+- (void) testLexerCornerCasesParseIdentically
+{
+    // lexer rules overlap in many ways: both parsers must resolve them identically
+    NSArray* templates = @[
+        @"{{foo 1~}}", @"{{foo 1.5x}}", @"{{foo -1}}", @"{{foo true.bar}}", @"{{foo truex}}", @"{{./foo}}", @"{{../foo}}",
+        @"{{elsewhere}}", @"{{ else }}", @"{{#a}}{{~ else ~}}{{/a}}", @"{{[foo bar]}}", @"{{[a]b]}}", @"{{foo \n bar}}", @"{{foo\n}}",
+        @"{{foo \"a\\\"b\" 'c\\'d'}}", @"{{foo \"a\\\"}}", @"{{! a}b }}", @"{{!}}", @"{{!-- a --}}", @"{{&foo}}", @"{{{foo}}}", @"{{{foo}~}}",
+        @"{{{{a}}}}x\ny{{{{/a}}}}", @"{{{{a}}}}{{{{/a}}}}", @"{{^}}", @"{{^a}}{{else}}{{/a}}", @"{{#a}}{{else}}{{else}}{{/a}}",
+        @"{{> 12}}", @"{{> \"a b\" c d=e}}", @"{{> a b c}}", @"{{foo a=b c}}", @"{{foo (bar}}", @"\\\\\\{{foo}}", @"{", @"}}}}",
+    ];
+    for (NSString* template in templates) {
+        [self parseSummary:template];
+    }
+}
+
+- (void) testIdentifiersAreInterned
+{
+    HBAstProgram* program1 = [HBParser astFromString:@"{{foo.bar}}" error:nil];
+    HBAstProgram* program2 = [HBParser astFromString:@"{{#with baz}}{{../foo/bar}}{{/with}}" error:nil];
+
+    NSArray* keyPath1 = [[program1.statements[0] expression] mainValue].keyPath;
+    NSArray* keyPath2 = [[[program2.statements[0] statements][0] expression] mainValue].keyPath;
+
+    XCTAssertEqual([keyPath1[0] key], [keyPath2[1] key], @"identical identifiers should share one string instance");
+    XCTAssertEqual([keyPath1[1] key], [keyPath2[2] key], @"identical identifiers should share one string instance");
+
+    XCTAssertTrue([keyPath2[0] isParentContextReference]);
+    XCTAssertFalse([keyPath2[1] isParentContextReference]);
+    XCTAssertFalse([keyPath1[0] isCurrentContextReference]);
+}
+
+- (void) testStatementSourceSpans
+{
+    NSString* template = @"a {{foo}} \\{{b}} {{#x}}y{{else}}z{{/x}}{{! c }}é{{{{r}}}}x{{{{/r}}}}";
+    HBAstProgram* program = [HBParser astFromString:template error:nil];
+    NSData* source = [template dataUsingEncoding:NSUTF8StringEncoding];
+    
+    NSMutableArray* spannedStrings = [NSMutableArray array];
+    NSUInteger end = 0;
+    for (HBAstNode* statement in program.statements) {
+        XCTAssertEqual(statement.sourceSpan.location, end, @"top-level statements tile the template");
+        end = NSMaxRange(statement.sourceSpan);
+        [spannedStrings addObject:[[[NSString alloc] initWithData:[source subdataWithRange:statement.sourceSpan] encoding:NSUTF8StringEncoding] autorelease]];
+    }
+    XCTAssertEqual(end, source.length);
+    XCTAssertEqualObjects(spannedStrings, (@[ @"a ", @"{{foo}}", @" ", @"\\{{", @"b}} ", @"{{#x}}y{{else}}z{{/x}}", @"{{! c }}", @"é", @"{{{{r}}}}x{{{{/r}}}}" ]));
+    
+    HBAstBlock* block = program.statements[5];
+    XCTAssertEqual([block.statements[0] sourceSpan].location, (NSUInteger)23);
+    XCTAssertEqual([block.inverseStatements[0] sourceSpan].location, (NSUInteger)32);
+}
+
+// Incremental compilation must produce what a compilation of the whole edited template produces
+
+- (NSString*) compiledSummaryOfTemplate:(HBTemplate*)template compiled:(BOOL)compiled error:(NSError*)error
+{
+    if (!compiled) return error ? [self summaryOfProgram:nil error:error] : @"EMPTY";
+    
+    // top-level statements positions in the template, then the AST
+    HBAstProgram* program = template.program;
+    NSMutableString* summary = [NSMutableString string];
+    for (NSUInteger i = 0; i < program.statements.count; i++) {
+        NSRange span = [program.statements[i] sourceSpan];
+        [summary appendFormat:@"%lu+%lu ", (unsigned long)(span.location + [program sourceOffsetOfStatementAtIndex:i]), (unsigned long)span.length];
+    }
+    [summary appendString:[self summaryOfProgram:program error:nil]];
+    return summary;
+}
+
+- (void) testIncrementalCompilationMatchesFullCompilation
+{
+    NSArray* fragments = @[ @"a", @" ", @"\n", @"{", @"}", @"{{", @"}}", @"\\", @"~", @"#", @"/", @"else", @"{{foo}}", @"{{~bar~}}", @" {{#if a}}", @"{{/if}} ", @"{{else}}", @"{{! c }}", @"{{{{raw}}}}", @"{{{{/raw}}}}", @"{{> p}}", @"é", @"x y" ];
+    NSArray* bases = [[HBTestCorpus templates] arrayByAddingObject:@"a {{~foo~}} b {{#x}} {{y}} {{/x}} \\{{z}} {{! c }} d"];
+    
+    uint32_t seed = 1;
+    for (NSInteger round = 0; round < 400; round++) {
+        NSString* base = bases[round % bases.count];
+        HBTemplate* template = [[[HBTemplate alloc] initWithString:base] autorelease];
+        NSError* error = nil;
+        XCTAssert([template compile:&error]);
+        
+        for (NSInteger edit = 0; edit < 4; edit++) {
+            NSString* string = template.templateString;
+            seed = seed * 1103515245 + 12345;
+            NSUInteger location = (seed >> 8) % (string.length + 1);
+            seed = seed * 1103515245 + 12345;
+            NSUInteger length = MIN((seed >> 8) % 6, string.length - location);
+            seed = seed * 1103515245 + 12345;
+            NSString* replacement = ((seed >> 8) % 3 == 0) ? @"" : fragments[(seed >> 12) % fragments.count];
+            
+            error = nil;
+            BOOL compiled = [template replaceCharactersInRange:NSMakeRange(location, length) withString:replacement error:&error];
+            XCTAssertEqualObjects(template.templateString, [string stringByReplacingCharactersInRange:NSMakeRange(location, length) withString:replacement]);
+            
+            HBTemplate* reference = [[[HBTemplate alloc] initWithString:template.templateString] autorelease];
+            NSError* referenceError = nil;
+            BOOL referenceCompiled = [reference compile:&referenceError];
+            
+            XCTAssertEqualObjects([self compiledSummaryOfTemplate:template compiled:compiled error:error], [self compiledSummaryOfTemplate:reference compiled:referenceCompiled error:referenceError], @"incremental compilation differs after replacing %@ with '%@' in '%@'", NSStringFromRange(NSMakeRange(location, length)), replacement, string);
+        }
+    }
 }
+
+- (void) testIncrementalCompilationReusesUntouchedStatements
+{
+    NSString* base = [HBTestCorpus templates][1];
+    HBTemplate* template = [[[HBTemplate alloc] initWithString:base] autorelease];
+    NSError* error = nil;
+    XCTAssert([template compile:&error]);
+    NSArray* oldStatements = template.program.statements;
+    
+    // type in a raw text in the middle of the template
+    NSRange text = [base rangeOfString:@"<title>" options:0 range:NSMakeRange(base.length / 2, base.length / 2)];
+    XCTAssert([template replaceCharactersInRange:NSMakeRange(NSMaxRange(text), 0) withString:@"My " error:&error]);
+    XCTAssert([template replaceCharactersInRange:NSMakeRange(NSMaxRange(text) + 3, 0) withString:@"page: " error:&error]);
+    
+    NSArray* newStatements = template.program.statements;
+    XCTAssertEqual(newStatements.count, oldStatements.count);
+    NSUInteger reused = 0;
+    for (HBAstNode* statement in newStatements) {
+        if ([oldStatements indexOfObjectIdenticalTo:statement] != NSNotFound) reused++;
+    }
+    // the raw text typed in is parsed again with its neighbours, up to the tags around them
+    XCTAssertEqual(reused, oldStatements.count - 3);
+    
+    NSError* renderError = nil;
+    XCTAssertEqualObjects([template renderWithContext:@{ @"title" : @"t" } error:&renderError], [[[[HBTemplate alloc] initWithString:template.templateString] autorelease] renderWithContext:@{ @"title" : @"t" } error:&renderError]);
+}
+
+- (void) testIncrementalCompilationOfAnEmptiedTemplate
+{
+    HBTemplate* template = [[[HBTemplate alloc] initWithString:@"a {{foo}} b"] autorelease];
+    NSError* error = nil;
+    XCTAssert([template compile:&error]);
+    
+    XCTAssert([template replaceCharactersInRange:NSMakeRange(0, template.templateString.length) withString:@"" error:&error]);
+    XCTAssertNil(error);
+    XCTAssertNotNil(template.program);
+    XCTAssertEqual(template.program.statements.count, (NSUInteger)0);
+    XCTAssertEqualObjects([template renderWithContext:@{ @"foo" : @"bar" } error:&error], @"");
+    
+    // and typing in it again
+    XCTAssert([template replaceCharactersInRange:NSMakeRange(0, 0) withString:@"{{foo}}" error:&error]);
+    XCTAssertEqualObjects([template renderWithContext:@{ @"foo" : @"bar" } error:&error], @"bar");
+}
+
+// Parsing must be reentrant:templates compiled concurrently must produce exactly
+// what a serial compilation produces, including line and position of parse errors.
+
+- (NSArray*) concurrencyTestCorpus
+{
+    NSArray* seeds = @[
+        @"a string",
+        @"{{foo}} \\{{bar}} \\\\{{baz}}",
+        @"{{foo omg bar=baz bat=\"bam\" baz=1}}",
+        @"{{#foo}} bar {{else}} baz {{/foo}}",
+        @"{{> foo bar a=b c='d'}}",
+        @"{{!\nthis is a multi-line comment\n}}",
+        @"aaa {{{{foo}}}} {{a}} {{{{/foo}}}} bbbb",
+        @"{{foo (bar true true)}} {{~foo~}} {{../a/b.c}} {{@index}}",
+        @"a\na\na {{ string",
+        @"{{#foo}} {{/bar"
+    ];
+
+    NSMutableArray* corpus = [NSMutableArray array];
+    for (NSInteger i = 0; i < 50; i++) {
+        // vary the amount of leading text so that lines and positions differ between templates
+        NSString* prefix = [@"" stringByPaddingToLength:i withString:(i % 2 ? @"x\n" : @"y ") startingAtIndex:0];
+        for (NSString* seed in seeds) {
+            [corpus addObject:[prefix stringByAppendingString:seed]];
+        }
+    }
+    return corpus;
+}
+
+- (NSString*) parseSummary:(NSString*)template
+{
+    NSError* error = nil;
+    NSString* astString = [self astString:template error:&error];
+    if (error) {
+        HBParseError* parseError = (HBParseError*)error;
+        return [NSString stringWithFormat:@"ERROR line %ld position %ld", (long)parseError.lineNumber, (long)parseError.positionInBuffer];
+    }
+    return astString;
+}
+
+- (void) testConcurrentParsingMatchesSerialParsing
+{
+    NSArray* corpus = [self concurrencyTestCorpus];
+    NSUInteger count = corpus.count;
+
+    NSMutableArray* serialResults = [NSMutableArray arrayWithCapacity:count];
+    for (NSString* template in corpus) {
+        [serialResults addObject:[self parseSummary:template]];
+    }
+
+    NSString** concurrentResults = calloc(count, sizeof(NSString*));
+    for (NSInteger round = 0; round < 4; round++) {
+        dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+            @autoreleasepool {
+                concurrentResults[index] = [[self parseSummary:corpus[index]] retain];
+            }
+        });
+
+        for (NSUInteger i = 0; i < count; i++) {
+            XCTAssertEqualObjects(concurrentResults[i], serialResults[i], @"concurrent compilation of template %lu differs from serial compilation", (unsigned long)i);
+            [concurrentResults[i] release];
+            concurrentResults[i] = nil;
+        }
+    }
+    free(concurrentResults);
+}
+
+// UTF-8 input read in chunks must parse exactly like the same template given as a string
+
+- (NSString*) summaryOfProgram:(HBAstProgram*)program error:(NSError*)error
+{
+    if (error) {
+        HBParseError* parseError = (HBParseError*)error;
+        return [NSString stringWithFormat:@"ERROR line %ld position %ld", (long)parseError.lineNumber, (long)parseError.positionInBuffer];
+    }
+    
+    HBAstParserTestVisitor* visitor = [[HBAstParserTestVisitor alloc] initWithRootAstNode:program];
+    NSString* summary = [visitor testStringRepresentation];
+    [visitor release];
+    return summary;
+}
+
+- (void) testStreamingInputParsesLikeStrings
+{
+    // large templates make tokens straddle flex's buffer refills
+    NSMutableArray* corpus = [NSMutableArray arrayWithArray:[self concurrencyTestCorpus]];
+    [corpus addObjectsFromArray:[HBTestCorpus templates]];
+    NSString* large = [NSString stringWithFormat:@"%@{{{{raw}}}}%@{{{{/raw}}}}{{foo \"%@\"}} é", [self string:@"x\n{{a.b}} ü " repeated:3000], [self string:@"{ y\n" repeated:5000], [self string:@"s" repeated:20000]];
+    [corpus addObject:large];
+    [corpus addObject:[large stringByAppendingString:@" {{ bar"]];
+    
+    NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    for (NSString* template in corpus) {
+        NSString* expected = [self parseSummary:template];
+        NSData* data = [template dataUsingEncoding:NSUTF8StringEncoding];
+        XCTAssert([data writeToFile:path atomically:NO]);
+        
+        NSError* error = nil;
+        HBAstProgram* program = [HBParser astFromUTF8Data:data error:&error];
+        XCTAssertEqualObjects([self summaryOfProgram:program error:error], expected);
+        
+        error = nil;
+        program = [HBParser astFromContentsOfFile:path error:&error];
+        XCTAssertEqualObjects([self summaryOfProgram:program error:error], expected);
+        
+        error = nil;
+        program = [HBParser astFromInputStream:[NSInputStream inputStreamWithData:data] error:&error];
+        XCTAssertEqualObjects([self summaryOfProgram:program error:error], expected);
+        
+        error = nil;
+        int fd = open([path fileSystemRepresentation], O_RDONLY);
+        XCTAssert(fd >= 0);
+        program = [HBParser astFromFileDescriptor:fd error:&error];
+        close(fd);
+        XCTAssertEqualObjects([self summaryOfProgram:program error:error], expected);
+    }
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    
+    // read errors are reported as such
+    NSError* error = nil;
+    XCTAssertNil([HBParser astFromFileDescriptor:-1 error:&error]);
+    XCTAssertEqualObjects(error.domain, NSPOSIXErrorDomain);
+    XCTAssertEqual(error.code, (NSInteger)EBADF);
+}
+
+// Archived programs must decode to the same AST, without running the parser
+
+- (void) testArchivedProgramsDecodeLikeParsedPrograms
+{
+    NSMutableArray* corpus = [NSMutableArray arrayWithArray:[HBTestCorpus templates]];
+    [corpus addObject:@"{{foo -12 3.5 true false \"s\" a=-1 b=(c d) e=@f}} {{> p this x=1}} {{> \"q\"}} {{> 42}} {{^x}}y{{/x}} {{! c }}"];
+    
+    NSMutableDictionary* programs = [NSMutableDictionary dictionary];
+    NSMutableDictionary* expected = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < corpus.count; i++) {
+        NSError* error = nil;
+        HBAstProgram* program = [HBParser astFromString:corpus[i] error:&error];
+        XCTAssertNil(error);
+        NSString* name = [NSString stringWithFormat:@"%lu", (unsigned long)i];
+        programs[name] = program;
+        expected[name] = [self summaryOfProgram:program error:nil];
+    }
+    
+    NSData* data = [HBAstArchive archivedDataWithTemplatePrograms:programs partialPrograms:@{ @"partial" : programs[@"0"] }];
+    XCTAssertEqualObjects(data, [HBAstArchive archivedDataWithTemplatePrograms:programs partialPrograms:@{ @"partial" : programs[@"0"] }], @"archives are reproducible");
+    
+    NSDictionary* templatePrograms = nil;
+    NSDictionary* partialPrograms = nil;
+    NSError* error = nil;
+    XCTAssert([HBAstArchive readArchivedData:data templatePrograms:&templatePrograms partialPrograms:&partialPrograms error:&error]);
+    XCTAssertNil(error);
+    XCTAssertEqualObjects([NSSet setWithArray:[templatePrograms allKeys]], [NSSet setWithArray:[programs allKeys]]);
+    XCTAssertEqualObjects([partialPrograms allKeys], @[ @"partial" ]);
+    for (NSString* name in programs) {
+        HBAstProgram* program = [templatePrograms[name] program:&error];
+        XCTAssertNil(error);
+        XCTAssertEqualObjects([self summaryOfProgram:program error:nil], expected[name]);
+        XCTAssertEqualObjects([self spansOfStatements:program.statements], [self spansOfStatements:((HBAstProgram*)programs[name]).statements]);
+    }
+    
+    // corrupted archives are reported, never decoded
+    NSMutableData* corrupted = [[data mutableCopy] autorelease];
+    ((uint8_t*)[corrupted mutableBytes])[4] = HBAstArchiveVersion + 1;
+    XCTAssertFalse([HBAstArchive readArchivedData:corrupted templatePrograms:NULL partialPrograms:NULL error:&error]);
+    XCTAssertEqual(error.code, (NSInteger)HBErrorCodeArchiveError);
+    for (NSUInteger length = 0; length < data.length; length += 7) {
+        NSData* truncated = [data subdataWithRange:NSMakeRange(0, length)];
+        XCTAssertFalse([HBAstArchive readArchivedData:truncated templatePrograms:NULL partialPrograms:NULL error:NULL]);
+    }
+    uint32_t seed = 1;
+    for (NSUInteger i = 0; i < 2000; i++) {
+        corrupted = [[data mutableCopy] autorelease];
+        seed = seed * 1103515245 + 12345;
+        ((uint8_t*)[corrupted mutableBytes])[24 + (seed >> 8) % (data.length - 24)] ^= (1 << (seed % 8));
+        if ([HBAstArchive readArchivedData:corrupted templatePrograms:&templatePrograms partialPrograms:NULL error:NULL]) {
+            for (NSString* name in templatePrograms) [templatePrograms[name] program:NULL];
+        }
+    }
+}
+
+// Templates built by repeating a string.
+
+- (NSString*) string:(NSString*)string repeated:(NSUInteger)count
+{
+    return [@"" stringByPaddingToLength:string.length * count withString:string startingAtIndex:0];
+}
+
+- (void) testTextScannerFindsDelimitersAtAnyOffset
+{
+    // delimiters at every offset and alignment, so that all vector, word and byte paths are exercised
+    char buffer[100];
+    for (NSUInteger length = 0; length < 80; length++) {
+        for (NSUInteger start = 0; start < 4 && start <= length; start++) {
+            for (NSUInteger delimiterOffset = start; delimiterOffset <= length; delimiterOffset++) {
+                for (NSUInteger i = 0; i < length; i++) buffer[i] = (i % 7 == 3) ? '\n' : 'a' + i % 26;
+                if (delimiterOffset < length) buffer[delimiterOffset] = (delimiterOffset % 2) ? '{' : '\\';
+                const char* found = hb_scan_text(buffer + start, buffer + length);
+                XCTAssertEqual(found, hb_scan_text_bytewise(buffer + start, buffer + length));
+                XCTAssertEqual(found, buffer + delimiterOffset);
+                XCTAssertEqual(hb_count_newlines(buffer + start, found), (NSUInteger)((delimiterOffset + 3) / 7 - (start + 3) / 7));
+            }
+        }
+    }
+}
+
+- (void) testCompiledProgramsMergeTextAndDropComments
+{
+    NSString* string = @"a \\{{b}} {{! c }} d {{~foo}} {{! e }}{{#x}}{{! f }}{{/x}}{{#y}} g {{!-- h --}} i {{/y}}";
+    HBTemplate* template = [[[HBTemplate alloc] initWithString:string] autorelease];
+    NSError* error = nil;
+    XCTAssert([template compile:&error]);
+    
+    NSArray* statements = template.program.statements;
+    XCTAssertEqual(statements.count, (NSUInteger)5);
+    XCTAssertEqualObjects([statements[0] litteralValue], @"a {{b}}  d");
+    XCTAssertEqualObjects([statements[2] litteralValue], @" ");
+    XCTAssertNil([statements[3] statements]);
+    XCTAssertEqual([[statements[4] statements] count], (NSUInteger)1);
+    XCTAssertEqualObjects([[statements[4] statements][0] litteralValue], @" g  i ");
+    
+    // merged text spans the statements it replaces
+    NSData* source = [string dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertEqualObjects([[[NSString alloc] initWithData:[source subdataWithRange:[statements[0] sourceSpan]] encoding:NSUTF8StringEncoding] autorelease], @"a \\{{b}} {{! c }} d ");
+    
+    NSString* result = [template renderWithContext:@{ @"foo" : @"F", @"x" : @YES, @"y" : @YES } error:&error];
+    XCTAssertEqualObjects(result, @"a {{b}}  dF  g  i ");
+}
+
+- (void) testCompiledProgramsHaveLookupDescriptors
+{
+    HBTemplate* template = [[[HBTemplate alloc] initWithString:@"{{#with a}}{{this/../b.c}}{{@index}}{{../../d}}{{/with}}"] autorelease];
+    NSError* error = nil;
+    XCTAssert([template compile:&error]);
+    
+    NSArray* statements = [template.program.statements[0] statements];
+    HBAstContextualValue* value = [statements[0] expression].mainValue;
+    XCTAssert(value.hasLookupDescriptor);
+    XCTAssertEqual(value.parentLevels, (NSUInteger)1);
+    XCTAssertEqual(value.lookupKeyCount, (NSUInteger)2);
+    XCTAssertEqualObjects(value.lookupKeys[0], @"b");
+    XCTAssertEqualObjects(value.lookupKeys[1], @"c");
+    
+    value = [statements[1] expression].mainValue;
+    XCTAssert(value.isDataValue);
+    XCTAssertEqual(value.parentLevels, (NSUInteger)0);
+    XCTAssertEqual(value.lookupKeyCount, (NSUInteger)1);
+    XCTAssertEqualObjects(value.lookupKeys[0], @"index");
+    
+    value = [statements[2] expression].mainValue;
+    XCTAssertEqual(value.parentLevels, (NSUInteger)2);
+    
+    // inline caches are allocated by the first lookup
+    value = [statements[0] expression].mainValue;
+    XCTAssert(value.propertyCaches == NULL);
+    NSString* result = [template renderWithContext:@{ @"a" : @{}, @"b" : @{ @"c" : @"C" }, @"d" : @"D" } error:&error];
+    XCTAssertEqualObjects(result, @"C");
+    XCTAssert(value.propertyCaches != NULL);
+    
+    // names of partials and of helpers called with parameters are not looked up, and neither is a value used once
+    template = [[[HBTemplate alloc] initWithString:@"{{> p}}{{f x}}"] autorelease];
+    XCTAssert([template compile:&error]);
+    XCTAssertFalse([(HBAstContextualValue*)[template.program.statements[0] partialName] hasLookupDescriptor]);
+    XCTAssertFalse([(HBAstContextualValue*)[template.program.statements[1] expression].mainValue hasLookupDescriptor]);
+    XCTAssert([(HBAstContextualValue*)[template.program.statements[1] expression].positionalParameters[0] hasLookupDescriptor]);
+    XCTAssertNil(template.program.lookupCacheKeys);
+}
+
+// Memory kept by compiled templates, before and after their AST is frozen
+
+- (NSString*) testStringOfProgram:(HBAstProgram*)program
+{
+    HBAstParserTestVisitor* visitor = [[HBAstParserTestVisitor alloc] initWithRootAstNode:program];
+    NSString* result = [visitor testStringRepresentation];
+    [visitor release];
+    return result;
+}
+
+- (void) testFrozenProgramsUseLessMemory
+{
+    NSArray* corpus = [HBTestCorpus templates];
+    NSUInteger copies = 1000;
+    
+    for (NSUInteger i = 0; i < corpus.count; i += 2) {
+        NSString* template = corpus[i];
+        NSMutableArray* programs = [NSMutableArray arrayWithCapacity:copies];
+        
+        malloc_statistics_t statistics;
+        malloc_zone_statistics(NULL, &statistics);
+        size_t initialSize = statistics.size_in_use;
+        @autoreleasepool {
+            for (NSUInteger copy = 0; copy < copies; copy++) {
+                [programs addObject:[HBParser astFromString:template error:nil]];
+            }
+        }
+        malloc_zone_statistics(NULL, &statistics);
+        size_t parsedSize = statistics.size_in_use;
+        
+        NSString* parsedString = [self testStringOfProgram:programs[0]];
+        @autoreleasepool {
+            for (HBAstProgram* program in programs) {
+                [HBAstFreezingVisitor freezeProgram:program];
+            }
+        }
+        malloc_zone_statistics(NULL, &statistics);
+        size_t frozenSize = statistics.size_in_use;
+        
+        XCTAssertEqualObjects([self testStringOfProgram:programs[0]], parsedString);
+        XCTAssert(frozenSize < parsedSize, @"template %lu: %lu bytes per compiled template, %lu once frozen", (unsigned long)i / 2, (unsigned long)(parsedSize - initialSize) / copies, (unsigned long)(frozenSize - initialSize) / copies);
+        
+        // what renders need is allocated by renders: inline caches of lookups are not part of frozen programs
+        HBTemplate* compiledTemplate = [[[HBTemplate alloc] initWithString:template] autorelease];
+        XCTAssert([compiledTemplate compile:nil]);
+        for (HBAstContextualValue* value in compiledTemplate.profileSites.lookups) {
+            XCTAssert(value.propertyCaches == NULL, @"template %lu: %@ has inline caches before it is rendered", (unsigned long)i / 2, value.sourceRepresentation);
+        }
+    }
+}
+
+// Templates that are mostly static text, where parsers spend their time in the text scanner
+
+- (void) testMostlyStaticTemplatesParseIdentically
+{
+    for (NSString* template in [HBTestCorpus staticTextTemplates]) {
+        [self parseSummary:template];
+    }
+}
+
 @end
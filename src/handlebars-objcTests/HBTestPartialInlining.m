@@ -0,0 +1,107 @@
+//
+//  HBTestPartialInlining.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "HBHandlebars.h"
+#import "HBTemplate_Private.h"
+#import "HBAst.h"
+
+@interface HBTestPartialInlining : XCTestCase
+
+@end
+
+@implementation HBTestPartialInlining
+
+- (void)testInlinedPartials
+{
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    [executionContext registerPartialString:@"<b>{{name}}</b>{{> price}}" forName:@"card"];
+    [executionContext registerPartialString:@" ${{price}}" forName:@"price"];
+    [executionContext registerPartialString:@"{{#if next}}.{{#with next}}{{> loop}}{{/with}}{{/if}}" forName:@"loop"];
+    NSString* templateString = @"{{#each items}}{{> card}};{{/each}}{{> card first}}|{{> loop}}";
+    id context = @{ @"items" : @[ @{ @"name" : @"a", @"price" : @1 }, @{ @"name" : @"b", @"price" : @2 } ],
+                    @"first" : @{ @"name" : @"c", @"price" : @3 },
+                    @"next" : @{ @"next" : @{ @"x" : @1 } } };
+    
+    HBTemplate* template = [executionContext templateWithString:templateString];
+    template.inlinesPartials = YES;
+    NSError* error = nil;
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"<b>a</b> $1;<b>b</b> $2;<b>c</b> $3|..");
+    XCTAssertNil(error);
+    
+    // partials with a context and recursive partials stay partial tags
+    XCTAssertNotNil(template.inlinedProgram);
+    XCTAssertEqualObjects([template.inlinedPartials.allKeys sortedArrayUsingSelector:@selector(compare:)], (@[ @"card", @"loop", @"price" ]));
+    XCTAssertEqual(template.inlinedProgram.statements.count, template.program.statements.count);
+    XCTAssert([template.inlinedProgram.statements[1] isKindOfClass:[HBAstPartialTag class]]);
+    XCTAssert([template.inlinedProgram.statements.lastObject isKindOfClass:[HBAstBlock class]]);
+    
+    // registering an inlined partial again invalidates the template
+    [executionContext registerPartialString:@" {{price}}EUR" forName:@"price"];
+    XCTAssertEqualObjects([template renderWithContext:context error:&error], @"<b>a</b> 1EUR;<b>b</b> 2EUR;<b>c</b> 3EUR|..");
+    XCTAssertNil(error);
+    
+    HBTemplate* interpreted = [executionContext templateWithString:templateString];
+    for (NSNumber* engine in @[ @(HBTemplateEngineBytecode), @(HBTemplateEngineClosures) ]) {
+        template.engine = [engine integerValue];
+        XCTAssertEqualObjects([template renderWithContext:context error:&error], [interpreted renderWithContext:context error:&error]);
+    }
+    template.engine = HBTemplateEngineInterpreter;
+    
+    // and so does unregistering it
+    [executionContext unregisterPartialForName:@"price"];
+    [template renderWithContext:context error:&error];
+    XCTAssertEqual(error.code, (NSInteger)HBErrorCodePartialMissingError);
+}
+
+- (void)testConcurrentRendersWhilePartialsChange
+{
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    [executionContext registerPartialString:@"<{{name}}>" forName:@"item"];
+    HBTemplate* template = [executionContext templateWithString:@"{{#each items}}{{> item}}{{/each}}"];
+    template.inlinesPartials = YES;
+    id context = @{ @"items" : @[ @{ @"name" : @"a" }, @{ @"name" : @"b" } ] };
+    NSSet* expected = [NSSet setWithObjects:@"<a><b>", @"[a][b]", nil];
+    
+    // renders keep the program, bytecode or closure tree they started with while others are compiled
+    for (NSNumber* engine in @[ @(HBTemplateEngineInterpreter), @(HBTemplateEngineBytecode), @(HBTemplateEngineClosures) ]) {
+        template.engine = [engine integerValue];
+        __block volatile NSInteger failures = 0;
+        dispatch_apply(400, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+            @autoreleasepool {
+                if (index % 10 == 0) {
+                    [executionContext registerPartialString:(index % 20 ? @"<{{name}}>" : @"[{{name}}]") forName:@"item"];
+                }
+                NSString* result = [template renderWithContext:context error:nil];
+                if (![expected containsObject:result]) __sync_add_and_fetch(&failures, 1);
+            }
+        });
+        XCTAssertEqual(failures, (NSInteger)0);
+    }
+}
+
+@end
@@ -0,0 +1,217 @@
+//
+//  HBTestPerformance.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "HBHandlebars.h"
+#import "HBParser.h"
+#import "HBTextScanner.h"
+#import "HBTestFixtures.h"
+
+// Tests that measure time. Their results depend on the machine and on its load, so the shared
+// schemes skip this test case: enable it in the scheme's test action to run them, on an idle machine.
+// Tests using measureBlock: report their times to Xcode, which compares them to the baselines set there.
+
+@interface HBTestPerformance : XCTestCase
+
+@end
+
+@implementation HBTestPerformance
+
+- (NSString*) string:(NSString*)string repeated:(NSUInteger)count
+{
+    return [@"" stringByPaddingToLength:string.length * count withString:string startingAtIndex:0];
+}
+
+// Tokenization must be linear in the size of the template, whatever the template. Each of these
+// inputs used to make flex back up and rescan, or can make a naive lexer do so. Times are the best
+// of several parses, which leaves out most of what the machine does meanwhile.
+
+- (NSTimeInterval) bestParseTime:(NSString*)template implementation:(HBParserImplementation)implementation
+{
+    NSTimeInterval best = DBL_MAX;
+    for (NSInteger i = 0; i < 5; i++) {
+        @autoreleasepool {
+            NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+            [HBParser astFromString:template implementation:implementation error:nil];
+            best = MIN(best, [NSDate timeIntervalSinceReferenceDate] - start);
+        }
+    }
+    return best;
+}
+
+- (void) testAdversarialInputsAreParsedInLinearTime
+{
+    // blocks are copied since they are stored in a collection
+    NSDictionary* generators = @{
+        @"long line in raw block" : [[^(NSUInteger n) { return [NSString stringWithFormat:@"{{{{raw}}}}%@\n{{{{/raw}}}}", [self string:@"x" repeated:n]]; } copy] autorelease],
+        @"long identifier in raw block end" : [[^(NSUInteger n) { return [NSString stringWithFormat:@"{{{{raw}}}}x{{{{/raw %@!}}}}", [self string:@"a" repeated:n]]; } copy] autorelease],
+        @"newlines in expression" : [[^(NSUInteger n) { return [NSString stringWithFormat:@"{{foo %@\"bar\"}}", [self string:@"\n" repeated:n]]; } copy] autorelease],
+        @"identifier without trailing character" : [[^(NSUInteger n) { return [NSString stringWithFormat:@"{{foo %@!}}", [self string:@"a" repeated:n]]; } copy] autorelease],
+        @"escaped quotes" : [[^(NSUInteger n) { return [NSString stringWithFormat:@"{{foo \"%@}}", [self string:@"\\\"" repeated:n]]; } copy] autorelease],
+        @"unterminated quotes" : [[^(NSUInteger n) { return [self string:@"{{foo 'bar}} " repeated:n]; } copy] autorelease],
+        @"segment literals" : [[^(NSUInteger n) { return [NSString stringWithFormat:@"{{[%@[a]}}", [self string:@"]" repeated:n]]; } copy] autorelease],
+        @"spaces before else" : [[^(NSUInteger n) { return [NSString stringWithFormat:@"{{%@foo}}", [self string:@" " repeated:n]]; } copy] autorelease],
+        @"nested blocks" : [[^(NSUInteger n) { return [self string:@"{{#a}}" repeated:n / 10]; } copy] autorelease],
+    };
+
+    NSUInteger size = 20000;
+    NSUInteger factor = 8;
+    for (NSString* name in generators) {
+        NSString* (^generator)(NSUInteger) = generators[name];
+        NSString* small = generator(size);
+        NSString* large = generator(size * factor);
+
+        for (NSNumber* implementation in @[ @(HBParserImplementationFlexBison), @(HBParserImplementationRecursiveDescent) ]) {
+            NSTimeInterval smallTime = [self bestParseTime:small implementation:implementation.integerValue];
+            NSTimeInterval largeTime = [self bestParseTime:large implementation:implementation.integerValue];
+
+            // linear, with a margin for timing noise. Quadratic would be 8 times that.
+            XCTAssert(largeTime < factor * 3 * smallTime + 0.05, @"%@: parsing time is not linear with parser %@ (%.4fs for %lu bytes, %.4fs for %lu bytes)", name, implementation, smallTime, (unsigned long)small.length, largeTime, (unsigned long)large.length);
+        }
+    }
+}
+
+
+// Parsing, with both implementations, of realistic templates and of templates that are mostly static text
+
+- (void) parseTemplates:(NSArray*)templates implementation:(HBParserImplementation)implementation
+{
+    @autoreleasepool {
+        for (NSString* template in templates) {
+            [HBParser astFromString:template implementation:implementation error:nil];
+        }
+    }
+}
+
+- (void) testFlexBisonParsingPerformance
+{
+    NSArray* templates = [[HBTestCorpus templates] arrayByAddingObjectsFromArray:[HBTestCorpus staticTextTemplates]];
+    [self measureBlock:^{
+        [self parseTemplates:templates implementation:HBParserImplementationFlexBison];
+    }];
+}
+
+- (void) testRecursiveDescentParsingPerformance
+{
+    NSArray* templates = [[HBTestCorpus templates] arrayByAddingObjectsFromArray:[HBTestCorpus staticTextTemplates]];
+    [self measureBlock:^{
+        [self parseTemplates:templates implementation:HBParserImplementationRecursiveDescent];
+    }];
+}
+
+// Compiling templates with whitespace control. Trimming is done by the parsers as they build statements,
+// so that compiling costs the same as parsing plus freezing, with no pass over the tree in between.
+
+- (void) testCompilePerformance
+{
+    NSString* template = @"<ul class=\"people\">\n  {{~#each people~}}\n  <li>  {{~@index~}}  :  {{~firstName}} {{lastName~}}  </li>\n  {{~else~}}\n  <li> {{~> nobody~}} </li>\n  {{~/each~}}\n</ul>\n";
+    NSArray* templates = @[ template, [self string:template repeated:50] ];
+    [self measureBlock:^{
+        @autoreleasepool {
+            for (NSString* string in templates) {
+                HBTemplate* compiled = [[HBTemplate alloc] initWithString:string];
+                XCTAssert([compiled compile:nil]);
+                [compiled release];
+            }
+        }
+    }];
+}
+
+// The text scanner must beat a bytewise scan of the same text, on the templates where it matters
+
+- (NSTimeInterval) bestScanTime:(NSArray*)texts bytewise:(BOOL)bytewise
+{
+    NSTimeInterval best = DBL_MAX;
+    for (NSInteger i = 0; i < 5; i++) {
+        NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+        for (NSData* text in texts) {
+            const char* end = (const char*)text.bytes + text.length;
+            for (const char* p = text.bytes; p < end; p++) {
+                p = bytewise ? hb_scan_text_bytewise(p, end) : hb_scan_text(p, end);
+            }
+        }
+        best = MIN(best, [NSDate timeIntervalSinceReferenceDate] - start);
+    }
+    return best;
+}
+
+- (void) testTextScannerIsFasterThanBytewiseScanning
+{
+    NSMutableArray* texts = [NSMutableArray array];
+    for (NSString* template in [HBTestCorpus staticTextTemplates]) {
+        [texts addObject:[template dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    
+    NSTimeInterval scannerTime = [self bestScanTime:texts bytewise:NO];
+    NSTimeInterval bytewiseTime = [self bestScanTime:texts bytewise:YES];
+    XCTAssert(scannerTime < bytewiseTime, @"text scanner takes %.4fs, bytewise scanning %.4fs", scannerTime, bytewiseTime);
+}
+
+// Rendering a loop-heavy template, which is where compiled engines pay off, with each engine
+
+- (void) measureRenderingWithEngine:(HBTemplateEngine)engine
+{
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    [executionContext registerPartialString:@"{{firstName}} {{{lastName}}}" forName:@"person"];
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) {
+        return [[callingInfo[0] uppercaseString] stringByAppendingString:callingInfo[@"suffix"]];
+    } forName:@"upper"];
+    HBTemplate* template = [executionContext templateWithString:@"<ul>{{#each people}}<li class=\"{{#if @first}}first{{/if}}\">{{@index}}: {{> person}}{{#unless age}} ({{../unknown}}){{/unless}}</li>{{else}}<li>nobody</li>{{/each}}</ul>{{#with boss}}{{upper name suffix=\"!\"}}{{/with}}"];
+    template.engine = engine;
+    
+    NSMutableArray* people = [NSMutableArray array];
+    for (NSInteger i = 0; i < 1000; i++) {
+        [people addObject:@{ @"firstName" : [NSString stringWithFormat:@"first%ld", (long)i], @"lastName" : @"<b>last</b>", @"age" : @(i % 3) }];
+    }
+    NSDictionary* context = @{ @"people" : people, @"boss" : @{ @"name" : @"b&b" }, @"unknown" : @"?" };
+    XCTAssertNotNil([template renderWithContext:context error:nil]);
+    
+    [self measureBlock:^{
+        for (NSInteger i = 0; i < 20; i++) {
+            @autoreleasepool {
+                [template renderWithContext:context error:nil];
+            }
+        }
+    }];
+}
+
+- (void) testInterpreterRenderingPerformance
+{
+    [self measureRenderingWithEngine:HBTemplateEngineInterpreter];
+}
+
+- (void) testBytecodeRenderingPerformance
+{
+    [self measureRenderingWithEngine:HBTemplateEngineBytecode];
+}
+
+- (void) testClosuresRenderingPerformance
+{
+    [self measureRenderingWithEngine:HBTemplateEngineClosures];
+}
+
+@end
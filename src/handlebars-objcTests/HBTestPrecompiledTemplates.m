@@ -0,0 +1,83 @@
+//
+//  HBTestPrecompiledTemplates.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "HBHandlebars.h"
+
+@interface HBTestPrecompiledTemplates : XCTestCase
+
+@end
+
+@implementation HBTestPrecompiledTemplates
+
+- (void)testPrecompiledTemplatesOnExecutionContext
+{
+    NSDictionary* templateStrings = @{ @"list" : @"{{title}}:\n  {{#each items}}{{> item}}{{else}}none{{/each}}  \n{{~#if flag}} yes {{~/if}}",
+                                       @"unicode" : @"héllo {{{name}}} ✓" };
+    NSDictionary* partialStrings = @{ @"item" : @"[{{name}} {{../title}}]" };
+    NSDictionary* context = @{ @"title" : @"t", @"flag" : @YES, @"name" : @"<b>", @"items" : @[ @{ @"name" : @"a" }, @{ @"name" : @"b" } ] };
+    
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    NSDictionary* templateErrors = nil;
+    NSDictionary* partialErrors = nil;
+    NSData* data = [executionContext precompiledDataWithTemplateStrings:templateStrings partialStrings:partialStrings templateErrors:&templateErrors partialErrors:&partialErrors];
+    XCTAssertNotNil(data);
+    XCTAssertEqual(templateErrors.count, (NSUInteger)0);
+    XCTAssertEqual(partialErrors.count, (NSUInteger)0);
+    XCTAssertNil([executionContext partialForName:@"item"]);
+    
+    NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    XCTAssert([data writeToFile:path atomically:NO]);
+    
+    // precompiled templates render like the same templates compiled from strings
+    HBExecutionContext* stringsContext = [[HBExecutionContext new] autorelease];
+    [stringsContext registerPartialStrings:partialStrings];
+    HBExecutionContext* precompiledContext = [[HBExecutionContext new] autorelease];
+    NSError* error = nil;
+    NSDictionary* templates = [precompiledContext templatesWithContentsOfPrecompiledFile:path error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects([NSSet setWithArray:[templates allKeys]], [NSSet setWithArray:[templateStrings allKeys]]);
+    XCTAssertNotNil([precompiledContext partialForName:@"item"]);
+    for (NSString* name in templateStrings) {
+        NSString* expected = [[stringsContext templateWithString:templateStrings[name]] renderWithContext:context error:&error];
+        XCTAssertNil(error);
+        XCTAssertEqualObjects([templates[name] renderWithContext:context error:&error], expected);
+        XCTAssertNil(error);
+    }
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    
+    // errors
+    data = [executionContext precompiledDataWithTemplateStrings:@{ @"broken" : @"{{#each items}}" } partialStrings:@{ @"brokenPartial" : @"{{name" } templateErrors:&templateErrors partialErrors:&partialErrors];
+    XCTAssertNil(data);
+    XCTAssertEqualObjects([templateErrors allKeys], @[ @"broken" ]);
+    XCTAssertEqualObjects([partialErrors allKeys], @[ @"brokenPartial" ]);
+    
+    XCTAssertNil([precompiledContext templatesWithPrecompiledData:[@"{{not precompiled}}" dataUsingEncoding:NSUTF8StringEncoding] error:&error]);
+    XCTAssertEqual(error.code, (NSInteger)HBErrorCodeArchiveError);
+}
+
+@end
@@ -0,0 +1,177 @@
+//
+//  HBTestRenderFunctions.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "HBHandlebars.h"
+#import "HBTemplate_Private.h"
+#import "HBAstCodeGenerationVisitor.h"
+
+@interface HBTestRenderFunctions : XCTestCase
+
+@end
+
+// Render function as generated by hbs-codegen for "{{#if flag}}<{{name}}>{{else}}-{{/if}}{{#each items}}[{{this}}]{{/each}}"
+
+static const char test_sample_text2[] = "<";
+static NSString* test_sample_text2_string;
+static NSString* const test_sample_keys5[] = { @"name" };
+static const char test_sample_text6[] = ">";
+static NSString* test_sample_text6_string;
+static const char test_sample_text8[] = "-";
+static NSString* test_sample_text8_string;
+static NSString* const test_sample_keys11[] = { @"flag" };
+static const char test_sample_text14[] = "[";
+static NSString* test_sample_text14_string;
+static const char test_sample_text16[] = "]";
+static NSString* test_sample_text16_string;
+static NSString* const test_sample_keys19[] = { @"items" };
+
+static void test_sample_statements1(HBAstEvaluationVisitor* visitor, NSMutableString* output)
+{
+    hb_render_append_text(output, &test_sample_text2_string, test_sample_text2, sizeof(test_sample_text2) - 1);
+    id value3 = nil;
+    HBHelper* helper4 = hb_render_helper(visitor, @"name");
+    if (helper4) {
+        value3 = hb_render_call_helper(visitor, helper4, HBHelperInvocationExpression, NULL, 0, NULL, NULL, 0, NULL, NULL);
+    } else {
+        value3 = hb_render_lookup(visitor, 0, NO, test_sample_keys5, 1);
+    }
+    hb_render_append_value(visitor, output, value3, YES);
+    hb_render_append_text(output, &test_sample_text6_string, test_sample_text6, sizeof(test_sample_text6) - 1);
+}
+
+static void test_sample_statements7(HBAstEvaluationVisitor* visitor, NSMutableString* output)
+{
+    hb_render_append_text(output, &test_sample_text8_string, test_sample_text8, sizeof(test_sample_text8) - 1);
+}
+
+static void test_sample_statements13(HBAstEvaluationVisitor* visitor, NSMutableString* output)
+{
+    hb_render_append_text(output, &test_sample_text14_string, test_sample_text14, sizeof(test_sample_text14) - 1);
+    id value15 = hb_render_lookup(visitor, 0, NO, NULL, 0);
+    hb_render_append_value(visitor, output, value15, YES);
+    hb_render_append_text(output, &test_sample_text16_string, test_sample_text16, sizeof(test_sample_text16) - 1);
+}
+
+static void test_sample(HBAstEvaluationVisitor* visitor, NSMutableString* output)
+{
+    HBHelper* helper9 = hb_render_helper(visitor, @"if");
+    if (helper9) {
+        id value10 = hb_render_lookup(visitor, 0, NO, test_sample_keys11, 1);
+        id positional12[] = { value10 };
+        if (hb_render_is_builtin_helper(helper9, @"if")) {
+            hb_render_if(visitor, output, NO, positional12, 1, NULL, NULL, 0, test_sample_statements1, test_sample_statements7);
+        } else {
+            hb_render_append(output, hb_render_call_helper(visitor, helper9, HBHelperInvocationBlock, positional12, 1, NULL, NULL, 0, test_sample_statements1, test_sample_statements7));
+        }
+    } else {
+        hb_render_missing_helper(visitor, @"if");
+    }
+    HBHelper* helper17 = hb_render_helper(visitor, @"each");
+    if (helper17) {
+        id value18 = hb_render_lookup(visitor, 0, NO, test_sample_keys19, 1);
+        id positional20[] = { value18 };
+        if (hb_render_is_builtin_helper(helper17, @"each")) {
+            hb_render_each(visitor, output, positional20, 1, test_sample_statements13, NULL);
+        } else {
+            hb_render_append(output, hb_render_call_helper(visitor, helper17, HBHelperInvocationBlock, positional20, 1, NULL, NULL, 0, test_sample_statements13, NULL));
+        }
+    } else {
+        hb_render_missing_helper(visitor, @"each");
+    }
+}
+
+
+@implementation HBTestRenderFunctions
+
+- (void)testRenderFunctionTemplates
+{
+    NSString* templateString = @"{{#if flag}}<{{name}}>{{else}}-{{/if}}{{#each items}}[{{this}}]{{/each}}";
+    NSArray* contexts = @[ @{ @"flag" : @YES, @"name" : @"a&b", @"items" : @[ @1, @"x" ] },
+                           @{ @"flag" : @NO, @"name" : @"a", @"items" : @[] },
+                           @{ @"items" : @{ @"k" : @"v" } } ];
+    
+    // render functions render like the templates they are generated from
+    HBExecutionContext* executionContext = [[HBExecutionContext new] autorelease];
+    HBTemplate* interpreted = [executionContext templateWithString:templateString];
+    HBTemplate* generated = [executionContext templateWithRenderFunction:test_sample];
+    NSError* error = nil;
+    XCTAssert([generated compile:&error]);
+    for (id context in contexts) {
+        NSString* expected = [interpreted renderWithContext:context error:&error];
+        XCTAssertNil(error);
+        XCTAssertEqualObjects([generated renderWithContext:context error:&error], expected);
+        XCTAssertNil(error);
+    }
+    XCTAssertEqualObjects([generated renderWithContext:contexts[0] error:&error], @"<a&amp;b>[1][x]");
+    
+    // helpers named like keys and overridden builtin helpers are still resolved at render time
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return @"helper"; } forName:@"name"];
+    [executionContext registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return callingInfo.inverseStatements(callingInfo.context, callingInfo.data); } forName:@"if"];
+    for (id context in contexts) {
+        XCTAssertEqualObjects([generated renderWithContext:context error:&error], [interpreted renderWithContext:context error:&error]);
+    }
+    XCTAssertEqualObjects([generated renderWithContext:contexts[0] error:&error], @"-[1][x]");
+    
+    // generated source
+    NSString* source = [HBAstCodeGenerationVisitor implementationForPrograms:@{ @"sample" : interpreted.program } prefix:@"test" headerName:@"test.h"];
+    NSArray* expectedSnippets = @[ @"#import \"test.h\"\n",
+                                   @"static const char test_sample_text2[] = \"<\";\n",
+                                   @"static NSString* const test_sample_keys11[] = { @\"flag\" };\n",
+                                   @"\nvoid test_sample(HBAstEvaluationVisitor* visitor, NSMutableString* output)\n{\n",
+                                   @"            hb_render_if(visitor, output, NO, positional12, 1, NULL, NULL, 0, test_sample_statements1, test_sample_statements7);\n",
+                                   @"            hb_render_each(visitor, output, positional20, 1, test_sample_statements13, NULL);\n",
+                                   @"    id value15 = hb_render_lookup(visitor, 0, NO, NULL, 0);\n" ];
+    for (NSString* snippet in expectedSnippets) {
+        XCTAssert([source rangeOfString:snippet].location != NSNotFound, @"missing %@", snippet);
+    }
+    NSString* header = [HBAstCodeGenerationVisitor headerForTemplateNames:@[ @"sample", @"page-2" ] prefix:@"test"];
+    XCTAssert([header rangeOfString:@"extern void test_page_2(HBAstEvaluationVisitor* visitor, NSMutableString* output);\nextern void test_sample("].location != NSNotFound);
+    
+    // literals
+    HBTemplate* literals = [[[HBTemplate alloc] initWithString:@"\"a\\b\"\n\t{{#with x}}{{format ../y @index \"é\" 12 1.5 true n=-3}}{{/with}}"] autorelease];
+    XCTAssert([literals compile:&error]);
+    source = [HBAstCodeGenerationVisitor implementationForPrograms:@{ @"literals" : literals.program } prefix:@"test" headerName:@"test.h"];
+    expectedSnippets = @[ @"[] = \"\\\"a\\\\b\\\"\\n\"\n    \"\\t\";\n",
+                          @"hb_render_lookup(visitor, 1, NO, ",
+                          @"hb_render_lookup(visitor, 0, YES, ",
+                          @"@\"é\", [NSNumber numberWithLongLong:12LL], [NSNumber numberWithDouble:1.5], @YES };\n",
+                          @"[] = { @\"n\" };\n",
+                          @"{ [NSNumber numberWithLongLong:-3LL] };\n",
+                          @"hb_render_with(visitor, output, " ];
+    for (NSString* snippet in expectedSnippets) {
+        XCTAssert([source rangeOfString:snippet].location != NSNotFound, @"missing %@", snippet);
+    }
+    
+    // the smallest long long has no literal of its own
+    HBTemplate* smallest = [[[HBTemplate alloc] initWithString:@"{{f -9223372036854775808 -9223372036854775807}}"] autorelease];
+    XCTAssert([smallest compile:&error]);
+    source = [HBAstCodeGenerationVisitor implementationForPrograms:@{ @"smallest" : smallest.program } prefix:@"test" headerName:@"test.h"];
+    XCTAssert([source rangeOfString:@"{ [NSNumber numberWithLongLong:(-9223372036854775807LL - 1)], [NSNumber numberWithLongLong:-9223372036854775807LL] };\n"].location != NSNotFound);
+}
+
+@end
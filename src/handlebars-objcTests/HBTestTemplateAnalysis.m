@@ -0,0 +1,63 @@
+//
+//  HBTestTemplateAnalysis.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "HBHandlebars.h"
+
+@interface HBTestTemplateAnalysis : XCTestCase
+
+@end
+
+@implementation HBTestTemplateAnalysis
+
+- (void)testTemplateAnalysis
+{
+    HBTemplate* template = [[[HBTemplate alloc] initWithString:@"{{title}}{{#each orders}}{{#if paid}}{{customer.name}} {{../../currency}}{{/if}}{{@index}}{{> line item}}{{else}}{{noOrders}}{{/each}}{{formatDate date format=\"short\"}}{{> footer}}{{> missing}}"] autorelease];
+    [template.helpers registerHelperBlock:^(HBHelperCallingInfo* callingInfo) { return @"date"; } forName:@"formatDate"];
+    [template.partials registerPartialStrings:@{ @"line" : @"{{label}}{{#if more}}{{> line}}{{/if}}", @"footer" : @"{{company}}{{../outside}}" }];
+    
+    NSError* error = nil;
+    HBTemplateAnalysis* analysis = [template analyze:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects([analysis.keyPaths valueForKey:@"description"], (@[ @"title", @"orders", @"paid in #each orders", @"customer.name in #each orders", @"currency", @"item in #each orders", @"label in #each orders / >line item", @"more in #each orders / >line item", @"noOrders", @"date", @"company" ]));
+    XCTAssertEqualObjects([analysis.dataKeyPaths valueForKey:@"description"], (@[ @"@index in #each orders" ]));
+    XCTAssertEqualObjects(analysis.helperNames, ([NSSet setWithObjects:@"each", @"if", @"formatDate", nil]));
+    XCTAssertEqualObjects(analysis.partialNames, ([NSSet setWithObjects:@"line", @"footer", @"missing", nil]));
+    XCTAssertEqualObjects(analysis.unresolvedPartialNames, [NSSet setWithObject:@"missing"]);
+    
+    // values and sections, rather than helper calls
+    template = [[[HBTemplate alloc] initWithString:@"{{#people}}{{name}}{{this}}{{/people}}{{count}}"] autorelease];
+    analysis = [template analyze:&error];
+    XCTAssertEqualObjects([analysis.keyPaths valueForKey:@"description"], (@[ @"people", @"name in #people", @"this in #people", @"count" ]));
+    XCTAssertEqual(analysis.helperNames.count, (NSUInteger)0);
+    
+    template = [[[HBTemplate alloc] initWithString:@"{{#if x}}unclosed"] autorelease];
+    XCTAssertNil([template analyze:&error]);
+    XCTAssertNotNil(error);
+}
+
+@end
@@ -0,0 +1,108 @@
+//
+//  HBTestTemplateProfiles.m
+//  handlebars-objc
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <XCTest/XCTest.h>
+#import "HBHandlebars.h"
+#import "HBTemplate_Private.h"
+#import "HBAst.h"
+#import "HBObjectPropertyAccess.h"
+#import "HBTemplateProfile_Private.h"
+#import "HBTestFixtures.h"
+
+@interface HBTestTemplateProfiles : XCTestCase
+
+@end
+
+@implementation HBTestTemplateProfiles
+
+- (void)testTemplateProfile
+{
+    NSMutableArray* items = [NSMutableArray array];
+    for (NSInteger i = 0; i < 50; i++) {
+        [items addObject:@{ @"name" : [NSString stringWithFormat:@"item %ld", (long)i] }];
+    }
+    id context = @{ @"show" : @YES, @"items" : items, @"person" : [[CountingPerson new] autorelease] };
+    NSString* string = @"{{#if show}}<ul>{{#each items}}<li>{{name}}</li>{{/each}}</ul>{{else}}none{{/if}}{{person.name}}";
+    HBTemplate* template = [[[HBTemplate alloc] initWithString:string] autorelease];
+    template.engine = HBTemplateEngineBytecode;
+    NSString* expected = [template renderWithContext:context error:nil];
+    NSUInteger listLength = expected.length - @"Ann".length;
+    
+    // recorded renders are interpreted, and render the same
+    template.recordsProfile = YES;
+    XCTAssertNotNil(template.profile);
+    for (NSInteger i = 0; i < 3; i++) {
+        XCTAssertEqualObjects([template renderWithContext:context error:nil], expected);
+    }
+    XCTAssertEqual(template.profile.renderCount, (NSUInteger)3);
+    XCTAssertEqual(template.profile.averageOutputLength, expected.length);
+    XCTAssertEqual(template.profile.maximumOutputLength, expected.length);
+    XCTAssertEqual([template estimatedOutputLength], expected.length);
+    
+    // if takes its first branch, and each iterates 50 times, in each render
+    NSDictionary* propertyList = [template.profile propertyList];
+    XCTAssertEqualObjects(propertyList[@"blocks"], (@[ @[ @3, @3, @0, @(3 * listLength) ], @[ @3, @150, @0, @(3 * (listLength - @"<ul></ul>".length)) ] ]));
+    
+    // lookups: if, show, each, items, name, person.name
+    NSArray* lookups = propertyList[@"lookups"];
+    XCTAssertEqual(lookups.count, (NSUInteger)6);
+    XCTAssertEqualObjects(lookups[0], @[ @[] ]);
+    XCTAssertEqualObjects(lookups[5][1], @[ @"CountingPerson" ]);
+    
+    // profiles survive a round trip through their property list, and prepare lookups of templates they apply to
+    HBTemplateProfile* loadedProfile = [[[HBTemplateProfile alloc] initWithPropertyList:propertyList] autorelease];
+    XCTAssertEqualObjects([loadedProfile propertyList], propertyList);
+    HBTemplate* loadedTemplate = [[[HBTemplate alloc] initWithString:string] autorelease];
+    loadedTemplate.profile = loadedProfile;
+    XCTAssertTrue([loadedTemplate compile:nil]);
+    HBAstContextualValue* personName = loadedTemplate.profileSites.lookups[5];
+    XCTAssertEqualObjects([HBObjectPropertyAccess classesInCache:&personName.propertyCaches[1]], @[ [CountingPerson class] ]);
+    XCTAssertEqualObjects([loadedTemplate renderWithContext:context error:nil], expected);
+    XCTAssertEqual([loadedTemplate estimatedOutputLength], expected.length);
+    
+    // whether the profile is set before or after the template compiles
+    HBTemplate* compiledTemplate = [[[HBTemplate alloc] initWithString:string] autorelease];
+    XCTAssertTrue([compiledTemplate compile:nil]);
+    personName = compiledTemplate.profileSites.lookups[5];
+    XCTAssert(personName.propertyCaches == NULL);
+    compiledTemplate.profile = loadedProfile;
+    XCTAssertEqualObjects([HBObjectPropertyAccess classesInCache:&personName.propertyCaches[1]], @[ [CountingPerson class] ]);
+    
+    // profiles of other templates only tell the output length
+    HBTemplate* otherTemplate = [[[HBTemplate alloc] initWithString:@"{{#each items}}{{name}}{{/each}}"] autorelease];
+    otherTemplate.profile = loadedProfile;
+    NSString* names = [[items valueForKey:@"name"] componentsJoinedByString:@""];
+    XCTAssertEqualObjects([otherTemplate renderWithContext:context error:nil], names);
+    XCTAssertNil([loadedProfile blockProfilesForSites:otherTemplate.profileSites]);
+    otherTemplate.recordsProfile = YES;
+    [otherTemplate renderWithContext:context error:nil];
+    XCTAssertEqualObjects([loadedProfile propertyList][@"blocks"], (@[ @[ @1, @50, @0, @(names.length) ] ]));
+    
+    XCTAssertNil([[[HBTemplateProfile alloc] initWithPropertyList:@{ @"version" : @2 }] autorelease]);
+}
+
+@end
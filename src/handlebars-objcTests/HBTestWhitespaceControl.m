@@ -173,6 +173,31 @@
     XCTAssertEqualObjects(result, @"foo bar ");
 }
 
+- (void)testShouldStripWhitespaceInsidePartials
+{
+    NSError* error = nil;
+    id hash = @{ @"foo" : @"bar" };
+    id partials = @{ @"dude" : @" {{~foo~}} {{#if foo~}} baz {{~/if}} " };
+    
+    NSString* result = [self renderTemplate:@"[{{> dude}}]" withContext:hash withPartials:partials error:&error];
+    XCTAssert(!error, @"evaluation should not generate an error");
+    XCTAssertEqualObjects(result, @"[barbaz ]");
+}
+
+- (void)testShouldStripUnicodeWhitespaceButNotNewlines
+{
+    NSError* error = nil;
+    id hash = @{ @"foo" : @"bar" };
+    
+    NSString* result = [self renderTemplate:@"a\u00a0\u3000\t {{~foo~}} \u2003\u202fb" withContext:hash error:&error];
+    XCTAssert(!error, @"evaluation should not generate an error");
+    XCTAssertEqualObjects(result, @"abarb");
+    
+    result = [self renderTemplate:@"a \n {{~foo~}} \n b" withContext:hash error:&error];
+    XCTAssert(!error, @"evaluation should not generate an error");
+    XCTAssertEqualObjects(result, @"a \nbar\n b");
+}
+
 - (void)testShouldOnlyStripWhitespaceOnce
 {
     NSError* error = nil;
@@ -0,0 +1,111 @@
+//
+//  main.m
+//  hbs-codegen
+//
+//  Created by Bertrand Guiheneuf on 10/17/26.
+//
+//  The MIT License
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//  THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import "HBTemplate.h"
+#import "HBTemplate_Private.h"
+#import "HBAstCodeGenerationVisitor.h"
+
+// Compiles templates ahead of time into Objective-C render functions, to be linked in applications.
+//
+// hbs-codegen [-p prefix] -o output template_file...
+//
+// writes output.h and output.m. Each template gets a render function named after the prefix and the template
+// file name without extension, such as hbs_page for page.hbs. See HBRenderFunction.h.
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: hbs-codegen [-p prefix] -o output template_file...\n");
+    fprintf(stderr, "  writes output.h and output.m, with one render function per template, named prefix_<file name>\n");
+    fprintf(stderr, "  prefix must be a C identifier. Default is 'hbs'.\n");
+}
+
+int main(int argc, const char * argv[])
+{
+    int status = 0;
+    
+    @autoreleasepool {
+        NSString* prefix = @"hbs";
+        NSString* output = nil;
+        NSMutableArray* paths = [NSMutableArray array];
+        
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+                prefix = @(argv[++i]);
+            } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+                output = @(argv[++i]);
+            } else if (argv[i][0] == '-') {
+                usage();
+                return 64;
+            } else {
+                [paths addObject:@(argv[i])];
+            }
+        }
+        if (!output || paths.count == 0) {
+            usage();
+            return 64;
+        }
+        
+        NSMutableDictionary* programs = [NSMutableDictionary dictionary];
+        NSMutableDictionary* pathsByFunctionName = [NSMutableDictionary dictionary];
+        for (NSString* path in paths) {
+            NSString* name = [[path lastPathComponent] stringByDeletingPathExtension];
+            NSString* functionName = [HBAstCodeGenerationVisitor functionNameForTemplateName:name prefix:prefix];
+            if (pathsByFunctionName[functionName]) {
+                fprintf(stderr, "%s: render function %s is already generated for %s\n", [path UTF8String], [functionName UTF8String], [pathsByFunctionName[functionName] UTF8String]);
+                status = 1;
+                continue;
+            }
+            pathsByFunctionName[functionName] = path;
+            
+            HBTemplate* template = [[[HBTemplate alloc] initWithContentsOfFile:path] autorelease];
+            NSError* error = nil;
+            if (![template compile:&error]) {
+                fprintf(stderr, "%s: %s\n", [path UTF8String], [[error localizedDescription] UTF8String]);
+                status = 1;
+                continue;
+            }
+            programs[name] = template.program;
+        }
+        
+        if (status == 0) {
+            NSString* headerPath = [output stringByAppendingPathExtension:@"h"];
+            NSString* implementationPath = [output stringByAppendingPathExtension:@"m"];
+            NSString* header = [HBAstCodeGenerationVisitor headerForTemplateNames:[programs allKeys] prefix:prefix];
+            NSString* implementation = [HBAstCodeGenerationVisitor implementationForPrograms:programs prefix:prefix headerName:[headerPath lastPathComponent]];
+            
+            NSError* error = nil;
+            if (![header writeToFile:headerPath atomically:YES encoding:NSUTF8StringEncoding error:&error]
+                || ![implementation writeToFile:implementationPath atomically:YES encoding:NSUTF8StringEncoding error:&error]) {
+                fprintf(stderr, "hbs-codegen: %s\n", [[error localizedDescription] UTF8String]);
+                status = 1;
+            }
+        }
+    }
+    
+    return status;
+}